@@ -17,4 +17,5 @@
 static constexpr int WIN_WIDTH = 800; ///< Window width
 static constexpr int WIN_HEIGHT = 600; ///< Window height
 static constexpr const char* WIN_TITLE = "Pyramidy"; ///< Window title
-static constexpr unsigned int REFRESH_INTERVAL = 33; ///< Refresh rate
\ No newline at end of file
+static constexpr unsigned int REFRESH_INTERVAL = 33; ///< Refresh rate
+static constexpr size_t SCATTER_COUNT = 0; ///< Number of props scattered around the desert, zero disables them
\ No newline at end of file
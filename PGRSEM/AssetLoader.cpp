@@ -0,0 +1,136 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       AssetLoader.cpp
+ * \author     Dominik Pupala
+ * \date       2021/21/05
+ * \brief      Source file for parallel asset loader.
+ *
+ *  Source file containing declarations for AssetLoader class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "AssetLoader.h"
+
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+AssetLoader::AssetLoader(unsigned int threads)
+	: _count(0), _stop(false), _start(std::chrono::steady_clock::now())
+{
+	if (threads == 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+
+	for (unsigned int i = 0; i < threads; ++i)
+		_workers.emplace_back(&AssetLoader::Run, this);
+}
+
+AssetLoader::~AssetLoader()
+{
+	Finish();
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_workReady.notify_all();
+
+	for (auto& worker : _workers)
+		worker.join();
+}
+
+void AssetLoader::Enqueue(const std::string& name, std::function<bool()> work, std::function<void(bool)> upload)
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_pending.push(new Task{ name, std::move(work), std::move(upload) });
+		++_count;
+	}
+
+	_workReady.notify_one();
+}
+
+void AssetLoader::Finish()
+{
+	size_t uploaded = 0;
+
+	while (true)
+	{
+		Task* task;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+
+			if (_count == 0)
+				break;
+
+			_uploadReady.wait(lock, [this]() { return !_done.empty(); });
+			task = _done.front();
+			_done.pop();
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		task->Upload(task->Result);
+		double uploadTime = Elapsed(start);
+
+		std::cout << std::fixed << std::setprecision(2)
+			<< "Loaded " << task->Name << (task->Result ? "" : " (failed)")
+			<< ": work " << task->WorkTime << " ms, upload " << uploadTime << " ms" << std::endl;
+
+		delete task;
+		++uploaded;
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		--_count;
+	}
+
+	if (uploaded > 0)
+		std::cout << std::fixed << std::setprecision(2) << "Assets loaded in " << Elapsed(_start) << " ms using " << _workers.size() << " workers" << std::endl;
+}
+
+void AssetLoader::Run()
+{
+	while (true)
+	{
+		Task* task;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_workReady.wait(lock, [this]() { return _stop || !_pending.empty(); });
+
+			if (_stop && _pending.empty())
+				return;
+
+			task = _pending.front();
+			_pending.pop();
+		}
+
+		auto start = std::chrono::steady_clock::now();
+
+		// exception leaving the worker would terminate the process, Finish reports the failure instead
+		try
+		{
+			task->Result = task->Work();
+		}
+		catch (...)
+		{
+			task->Result = false;
+		}
+
+		task->WorkTime = Elapsed(start);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_done.push(task);
+		}
+
+		_uploadReady.notify_one();
+	}
+}
+
+double AssetLoader::Elapsed(const std::chrono::steady_clock::time_point& since)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
@@ -0,0 +1,106 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       AssetLoader.h
+ * \author     Dominik Pupala
+ * \date       2021/21/05
+ * \brief      Header file for parallel asset loader.
+ *
+ *  Header file containing definitions for AssetLoader class that runs CPU side asset
+ *  work on a thread pool and leaves OpenGL uploads to the calling thread.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <queue>
+#include <mutex>
+#include <vector>
+#include <thread>
+#include <string>
+#include <chrono>
+#include <functional>
+#include <condition_variable>
+
+/// Class that handles parallel asset loading.
+/**
+  This class contains context and functionality of the parallel asset loader.
+  Work part of the asset runs on worker thread, upload part runs on the thread
+  that calls Finish, which is supposed to be the one owning OpenGL context.
+*/
+class AssetLoader
+{
+private:
+	/// Struct that contains single asset task.
+	/**
+		This struct contains task context of single asset.
+	*/
+	struct Task
+	{
+		std::string Name; ///< Asset name used in reports
+		std::function<bool()> Work; ///< CPU side part, runs on worker
+		std::function<void(bool)> Upload; ///< OpenGL side part, runs on caller
+
+		bool Result = false; ///< Result of the work part
+		double WorkTime = 0.0; ///< Duration of the work part in ms
+	};
+
+	std::vector<std::thread> _workers; ///< Worker threads
+
+	std::queue<Task*> _pending; ///< Tasks waiting for worker
+	std::queue<Task*> _done; ///< Tasks waiting for upload
+	size_t _count; ///< Tasks not uploaded yet
+	bool _stop; ///< Workers termination flag
+
+	std::mutex _mutex; ///< Queue guard
+	std::condition_variable _workReady; ///< Signals pending task
+	std::condition_variable _uploadReady; ///< Signals finished task
+
+	std::chrono::steady_clock::time_point _start; ///< Creation time
+
+public:
+	/// Constructor
+	/**
+		Creates loader with given number of worker threads.
+
+		\param[in] threads	Number of worker threads, zero picks the hardware concurrency.
+	*/
+	AssetLoader(unsigned int threads = 0);
+	/// Destructor
+	/**
+		Finishes remaining tasks and joins worker threads.
+	*/
+	~AssetLoader();
+
+	AssetLoader(const AssetLoader&) = delete;
+	AssetLoader& operator=(const AssetLoader&) = delete;
+	/// Enqueue asset.
+	/**
+		Enqueues the asset, its work part starts as soon as some worker is free.
+
+		\param[in] name		Asset name used in reports.
+		\param[in] work		CPU side part, returns false on failure.
+		\param[in] upload	OpenGL side part, receives result of the work part.
+	*/
+	void Enqueue(const std::string& name, std::function<bool()> work, std::function<void(bool)> upload);
+	/// Finish loading.
+	/**
+		Uploads finished assets in order of completion until all enqueued assets are done
+		and reports load times.
+	*/
+	void Finish();
+
+private:
+	/// Worker loop.
+	/**
+		Runs work parts of pending tasks.
+	*/
+	void Run();
+	/// Milliseconds getter.
+	/**
+		Returns milliseconds elapsed since the given time point.
+
+		\param[in] since	Time point to measure from.
+	*/
+	static double Elapsed(const std::chrono::steady_clock::time_point& since);
+};
@@ -0,0 +1,290 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       BVH.cpp
+ * \author     Dominik Pupala
+ * \date       2021/04/06
+ * \brief      Source file for bounding volume hierarchies.
+ *
+ *  Source file containing declarations for BVH, MeshBVH and SceneBVH classes.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "BVH.h"
+#include "BoundingBox.h"
+
+#include <cmath>
+#include <algorithm>
+
+void BVH::Build(const std::vector<glm::vec3>& lower, const std::vector<glm::vec3>& upper)
+{
+	_nodes.clear();
+	_order.resize(lower.size());
+
+	for (GLuint i = 0; i < (GLuint)_order.size(); ++i)
+		_order[i] = i;
+
+	if (!_order.empty())
+		BuildNode(lower, upper, 0, (GLuint)_order.size());
+}
+
+void BVH::GetBounds(glm::vec3& outLower, glm::vec3& outUpper) const
+{
+	outLower = _nodes.empty() ? glm::vec3(0.0f) : _nodes[0].Lower;
+	outUpper = _nodes.empty() ? glm::vec3(0.0f) : _nodes[0].Upper;
+}
+
+bool BVH::IntersectBox(const glm::vec3& origin, const glm::vec3& inverse, const glm::vec3& lower, const glm::vec3& upper, GLfloat distance, GLfloat& outEntry)
+{
+	GLfloat entry = 0.0f, exit = distance;
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		GLfloat enter = (lower[axis] - origin[axis]) * inverse[axis];
+		GLfloat leave = (upper[axis] - origin[axis]) * inverse[axis];
+
+		if (enter > leave)
+			std::swap(enter, leave);
+
+		entry = std::max(entry, enter);
+		exit = std::min(exit, leave);
+	}
+
+	outEntry = entry;
+
+	return entry <= exit;
+}
+
+GLuint BVH::BuildNode(const std::vector<glm::vec3>& lower, const std::vector<glm::vec3>& upper, GLuint start, GLuint count)
+{
+	GLuint index = (GLuint)_nodes.size();
+	_nodes.push_back(Node());
+
+	glm::vec3 boxLower = lower[_order[start]], boxUpper = upper[_order[start]];
+	glm::vec3 centerLower = (boxLower + boxUpper) * 0.5f, centerUpper = centerLower;
+
+	for (GLuint i = start; i < start + count; ++i)
+	{
+		glm::vec3 center = (lower[_order[i]] + upper[_order[i]]) * 0.5f;
+		boxLower = glm::min(boxLower, lower[_order[i]]);
+		boxUpper = glm::max(boxUpper, upper[_order[i]]);
+		centerLower = glm::min(centerLower, center);
+		centerUpper = glm::max(centerUpper, center);
+	}
+
+	_nodes[index].Lower = boxLower;
+	_nodes[index].Upper = boxUpper;
+
+	glm::vec3 extent = centerUpper - centerLower;
+	int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+
+	// coincident centers can't be split
+	if (count <= LEAF_SIZE || extent[axis] <= 0.0f)
+	{
+		_nodes[index].Start = start;
+		_nodes[index].Count = count;
+		return index;
+	}
+
+	GLuint half = count / 2;
+	auto first = _order.begin() + start;
+
+	std::nth_element(first, first + half, first + count, [&](GLuint a, GLuint b)
+	{
+		return lower[a][axis] + upper[a][axis] < lower[b][axis] + upper[b][axis];
+	});
+
+	// left child lands right behind its parent
+	BuildNode(lower, upper, start, half);
+	GLuint right = BuildNode(lower, upper, start + half, count - half);
+
+	// nodes may move while children are built
+	_nodes[index].Start = right;
+	_nodes[index].Count = 0;
+
+	return index;
+}
+
+void MeshBVH::Build(std::vector<glm::vec3> positions, std::vector<GLuint> indices)
+{
+	_positions = std::move(positions);
+	_indices = std::move(indices);
+
+	size_t count = _indices.size() / 3;
+	std::vector<glm::vec3> lower(count), upper(count);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const glm::vec3& a = _positions[_indices[3 * i]];
+		const glm::vec3& b = _positions[_indices[3 * i + 1]];
+		const glm::vec3& c = _positions[_indices[3 * i + 2]];
+
+		lower[i] = glm::min(a, glm::min(b, c));
+		upper[i] = glm::max(a, glm::max(b, c));
+	}
+
+	_tree.Build(lower, upper);
+}
+
+bool MeshBVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, GLfloat& distance, GLuint& outTriangle) const
+{
+	bool hit = false;
+
+	_tree.Traverse(origin, direction, distance, [&](GLuint triangle, GLfloat& length)
+	{
+		GLfloat t;
+		const glm::vec3& a = _positions[_indices[3 * triangle]];
+		const glm::vec3& b = _positions[_indices[3 * triangle + 1]];
+		const glm::vec3& c = _positions[_indices[3 * triangle + 2]];
+
+		if (IntersectTriangle(origin, direction, a, b, c, length, t))
+		{
+			length = t;
+			outTriangle = triangle;
+			hit = true;
+		}
+	});
+
+	return hit;
+}
+
+bool MeshBVH::Overlaps(const glm::vec3& center, GLfloat radius) const
+{
+	glm::vec3 reach = glm::vec3(radius);
+
+	return _tree.Query(center - reach, center + reach, [&](GLuint triangle)
+	{
+		const glm::vec3& a = _positions[_indices[3 * triangle]];
+		const glm::vec3& b = _positions[_indices[3 * triangle + 1]];
+		const glm::vec3& c = _positions[_indices[3 * triangle + 2]];
+
+		glm::vec3 offset = ClosestPoint(center, a, b, c) - center;
+
+		return glm::dot(offset, offset) <= radius * radius;
+	});
+}
+
+bool MeshBVH::IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, GLfloat distance, GLfloat& outHit)
+{
+	glm::vec3 edge1 = b - a;
+	glm::vec3 edge2 = c - a;
+	glm::vec3 p = glm::cross(direction, edge2);
+	GLfloat determinant = glm::dot(edge1, p);
+
+	// both faces are hit, ray parallel with the triangle misses it
+	if (std::fabs(determinant) < 1e-8f)
+		return false;
+
+	GLfloat inverse = 1.0f / determinant;
+	glm::vec3 s = origin - a;
+	GLfloat u = glm::dot(s, p) * inverse;
+
+	if (u < 0.0f || u > 1.0f)
+		return false;
+
+	glm::vec3 q = glm::cross(s, edge1);
+	GLfloat v = glm::dot(direction, q) * inverse;
+
+	if (v < 0.0f || u + v > 1.0f)
+		return false;
+
+	GLfloat t = glm::dot(edge2, q) * inverse;
+
+	if (t < 0.0f || t > distance)
+		return false;
+
+	outHit = t;
+
+	return true;
+}
+
+glm::vec3 MeshBVH::ClosestPoint(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+{
+	// point is projected onto the closest of the vertex, edge and face regions
+	glm::vec3 ab = b - a, ac = c - a, ap = point - a;
+	GLfloat d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return a;
+
+	glm::vec3 bp = point - b;
+	GLfloat d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+
+	if (d3 >= 0.0f && d4 <= d3)
+		return b;
+
+	GLfloat vc = d1 * d4 - d3 * d2;
+
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return a + ab * (d1 / (d1 - d3));
+
+	glm::vec3 cp = point - c;
+	GLfloat d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+
+	if (d6 >= 0.0f && d5 <= d6)
+		return c;
+
+	GLfloat vb = d5 * d2 - d1 * d6;
+
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return a + ac * (d2 / (d2 - d6));
+
+	GLfloat va = d3 * d6 - d5 * d4;
+
+	if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	GLfloat denominator = 1.0f / (va + vb + vc);
+
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+void SceneBVH::Clear()
+{
+	_instances.clear();
+	_lower.clear();
+	_upper.clear();
+}
+
+void SceneBVH::Add(size_t entity, const glm::mat4& model, std::shared_ptr<const MeshBVH> mesh)
+{
+	glm::vec3 lower, upper;
+	mesh->GetBounds(lower, upper);
+
+	glm::vec3 center, extent;
+	BoundingBox::Transform(model, lower, upper, center, extent);
+
+	_instances.push_back({ entity, glm::inverse(model), std::move(mesh) });
+	_lower.push_back(center - extent);
+	_upper.push_back(center + extent);
+}
+
+void SceneBVH::Build()
+{
+	_tree.Build(_lower, _upper);
+}
+
+RayHit SceneBVH::Raycast(const glm::vec3& origin, const glm::vec3& direction, GLfloat distance, size_t ignore) const
+{
+	RayHit hit;
+	hit.Distance = distance;
+
+	_tree.Traverse(origin, direction, hit.Distance, [&](GLuint index, GLfloat& length)
+	{
+		const Instance& instance = _instances[index];
+
+		if (instance.Entity == ignore)
+			return;
+
+		glm::vec3 localOrigin, localDirection;
+		BoundingBox::TransformRay(instance.Inverse, origin, direction, localOrigin, localDirection);
+
+		if (instance.Mesh->Raycast(localOrigin, localDirection, length, hit.Triangle))
+		{
+			hit.Hit = true;
+			hit.Entity = instance.Entity;
+		}
+	});
+
+	return hit;
+}
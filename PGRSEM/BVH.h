@@ -0,0 +1,343 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       BVH.h
+ * \author     Dominik Pupala
+ * \date       2021/04/06
+ * \brief      Header file for bounding volume hierarchies.
+ *
+ *  Header file containing definitions for BVH, MeshBVH and SceneBVH classes.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "pgr.h"
+
+/// Struct that contains result of ray query.
+/**
+	This struct contains the closest hit along the ray.
+*/
+struct RayHit
+{
+	bool Hit = false; ///< Ray hit anything
+	size_t Entity = 0; ///< Hit entity
+	GLuint Triangle = 0; ///< Hit triangle of the entity mesh
+	GLfloat Distance = std::numeric_limits<GLfloat>::max(); ///< Distance along the ray
+};
+
+/// Class that contains hierarchy of boxes.
+/**
+  This class contains binary tree of axis aligned boxes over primitives given by their
+  own boxes. Primitives are split by median of their centers along the longest axis,
+  nodes are stored depth first with left child right behind its parent.
+  Traversal visits the nearer child first and shortens the ray on every hit.
+*/
+class BVH
+{
+public:
+	static constexpr GLuint LEAF_SIZE = 4; ///< Largest number of primitives in leaf
+	static constexpr size_t STACK_SIZE = 64; ///< Depth of traversal stack
+
+	/// Struct that contains single node.
+	struct Node
+	{
+		glm::vec3 Lower; ///< Lower corner of the box
+		GLuint Start; ///< First primitive of leaf, right child of inner node
+		glm::vec3 Upper; ///< Upper corner of the box
+		GLuint Count; ///< Primitives of leaf, zero for inner node
+	};
+
+private:
+	std::vector<Node> _nodes; ///< Nodes, root first
+	std::vector<GLuint> _order; ///< Primitives in order of leaves
+
+public:
+	/// Build hierarchy.
+	/**
+		Builds the tree over boxes of primitives, replacing the previous one.
+
+		\param[in] lower	Lower corners of primitives.
+		\param[in] upper	Upper corners of primitives.
+	*/
+	void Build(const std::vector<glm::vec3>& lower, const std::vector<glm::vec3>& upper);
+	/// Traverse hierarchy.
+	/**
+		Calls the leaf function for every primitive whose leaf is hit before the distance.
+		The function gets index of the primitive and the distance it may shorten.
+
+		\param[in] origin			Origin of the ray.
+		\param[in] direction		Direction of the ray.
+		\param[in,out] distance		Length of the ray.
+		\param[in] leaf				Primitive test.
+	*/
+	template<typename F>
+	void Traverse(const glm::vec3& origin, const glm::vec3& direction, GLfloat& distance, F leaf) const
+	{
+		if (_nodes.empty())
+			return;
+
+		glm::vec3 inverse = glm::vec3(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+		GLuint stack[STACK_SIZE];
+		size_t top = 0;
+		GLfloat entry;
+
+		if (!IntersectBox(origin, inverse, _nodes[0].Lower, _nodes[0].Upper, distance, entry))
+			return;
+
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			GLuint index = stack[--top];
+			const Node& node = _nodes[index];
+
+			if (node.Count > 0)
+			{
+				for (GLuint i = node.Start; i < node.Start + node.Count; ++i)
+					leaf(_order[i], distance);
+
+				continue;
+			}
+
+			GLuint left = index + 1, right = node.Start;
+			GLfloat leftEntry, rightEntry;
+			bool leftHit = IntersectBox(origin, inverse, _nodes[left].Lower, _nodes[left].Upper, distance, leftEntry);
+			bool rightHit = IntersectBox(origin, inverse, _nodes[right].Lower, _nodes[right].Upper, distance, rightEntry);
+
+			// nearer child is popped first, its hits may skip the other one
+			if (leftHit && rightHit)
+			{
+				stack[top++] = leftEntry < rightEntry ? right : left;
+				stack[top++] = leftEntry < rightEntry ? left : right;
+			}
+			else if (leftHit)
+				stack[top++] = left;
+			else if (rightHit)
+				stack[top++] = right;
+		}
+	}
+	/// Query hierarchy.
+	/**
+		Calls the leaf function for every primitive whose leaf overlaps the box, until
+		the function returns true. Returns true if the query was stopped.
+
+		\param[in] lower	Lower corner of the box.
+		\param[in] upper	Upper corner of the box.
+		\param[in] leaf		Primitive test.
+	*/
+	template<typename F>
+	bool Query(const glm::vec3& lower, const glm::vec3& upper, F leaf) const
+	{
+		if (_nodes.empty())
+			return false;
+
+		GLuint stack[STACK_SIZE];
+		size_t top = 0;
+
+		stack[top++] = 0;
+
+		while (top > 0)
+		{
+			GLuint index = stack[--top];
+			const Node& node = _nodes[index];
+
+			if (upper.x < node.Lower.x || upper.y < node.Lower.y || upper.z < node.Lower.z ||
+				lower.x > node.Upper.x || lower.y > node.Upper.y || lower.z > node.Upper.z)
+				continue;
+
+			if (node.Count == 0)
+			{
+				stack[top++] = node.Start;
+				stack[top++] = index + 1;
+				continue;
+			}
+
+			for (GLuint i = node.Start; i < node.Start + node.Count; ++i)
+				if (leaf(_order[i]))
+					return true;
+		}
+
+		return false;
+	}
+	/// Bounds getter.
+	/**
+		Returns box of the root node, empty hierarchy has zero box.
+
+		\param[out] outLower	Lower corner of the box.
+		\param[out] outUpper	Upper corner of the box.
+	*/
+	void GetBounds(glm::vec3& outLower, glm::vec3& outUpper) const;
+	/// Node count getter.
+	/**
+		Returns number of nodes.
+	*/
+	inline size_t GetNodeCount() const { return _nodes.size(); }
+	/// Box intersection.
+	/**
+		Returns true if the ray enters the box before the distance, slab test.
+
+		\param[in] origin		Origin of the ray.
+		\param[in] inverse		Inverted direction of the ray.
+		\param[in] lower		Lower corner of the box.
+		\param[in] upper		Upper corner of the box.
+		\param[in] distance		Length of the ray.
+		\param[out] outEntry	Distance of the entry point.
+	*/
+	static bool IntersectBox(const glm::vec3& origin, const glm::vec3& inverse, const glm::vec3& lower, const glm::vec3& upper, GLfloat distance, GLfloat& outEntry);
+
+private:
+	/// Build node.
+	/**
+		Builds subtree over the range of primitives and returns index of its root.
+
+		\param[in] lower	Lower corners of primitives.
+		\param[in] upper	Upper corners of primitives.
+		\param[in] start	First primitive of the range.
+		\param[in] count	Number of primitives in the range.
+	*/
+	GLuint BuildNode(const std::vector<glm::vec3>& lower, const std::vector<glm::vec3>& upper, GLuint start, GLuint count);
+};
+
+/// Class that contains triangles of single mesh for ray queries.
+/**
+  This class keeps CPU copy of mesh positions and full detail triangles with hierarchy
+  over them. Positions are in object space, queries are expected in the same space.
+*/
+class MeshBVH
+{
+private:
+	std::vector<glm::vec3> _positions; ///< Vertex positions
+	std::vector<GLuint> _indices; ///< Triangle indices, three per triangle
+	BVH _tree; ///< Hierarchy over triangles
+
+public:
+	/// Build hierarchy.
+	/**
+		Takes over the triangles and builds hierarchy over them.
+
+		\param[in] positions	Vertex positions.
+		\param[in] indices		Triangle indices.
+	*/
+	void Build(std::vector<glm::vec3> positions, std::vector<GLuint> indices);
+	/// Ray query.
+	/**
+		Returns true if the ray hits any triangle before the distance,
+		the distance is shortened to the closest hit.
+
+		\param[in] origin			Origin of the ray.
+		\param[in] direction		Direction of the ray.
+		\param[in,out] distance		Length of the ray.
+		\param[out] outTriangle		Closest hit triangle.
+	*/
+	bool Raycast(const glm::vec3& origin, const glm::vec3& direction, GLfloat& distance, GLuint& outTriangle) const;
+	/// Sphere query.
+	/**
+		Returns true if any triangle reaches into the sphere.
+
+		\param[in] center	Center of the sphere.
+		\param[in] radius	Radius of the sphere.
+	*/
+	bool Overlaps(const glm::vec3& center, GLfloat radius) const;
+	/// Bounds getter.
+	/**
+		Returns box around all triangles.
+
+		\param[out] outLower	Lower corner of the box.
+		\param[out] outUpper	Upper corner of the box.
+	*/
+	inline void GetBounds(glm::vec3& outLower, glm::vec3& outUpper) const { _tree.GetBounds(outLower, outUpper); }
+	/// Triangle count getter.
+	/**
+		Returns number of triangles.
+	*/
+	inline size_t GetTriangleCount() const { return _indices.size() / 3; }
+	/// Triangle intersection.
+	/**
+		Returns true if the ray hits the triangle before the distance, Moller-Trumbore test.
+
+		\param[in] origin		Origin of the ray.
+		\param[in] direction	Direction of the ray.
+		\param[in] a			First vertex.
+		\param[in] b			Second vertex.
+		\param[in] c			Third vertex.
+		\param[in] distance		Length of the ray.
+		\param[out] outHit		Distance of the hit.
+	*/
+	static bool IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, GLfloat distance, GLfloat& outHit);
+	/// Closest point on triangle.
+	/**
+		Returns point of the triangle closest to the given point.
+
+		\param[in] point	Tested point.
+		\param[in] a		First vertex.
+		\param[in] b		Second vertex.
+		\param[in] c		Third vertex.
+	*/
+	static glm::vec3 ClosestPoint(const glm::vec3& point, const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
+};
+
+/// Class that contains mesh instances for ray queries.
+/**
+  This class contains top level hierarchy over world space boxes of mesh instances.
+  Rays are moved into object space of every hit instance and tested against its mesh,
+  the direction isn't normalized there, so distances stay in world space.
+  Instances are collected and built again whenever they move.
+*/
+class SceneBVH
+{
+private:
+	/// Struct that contains single instance.
+	struct Instance
+	{
+		size_t Entity; ///< Owning entity
+		glm::mat4 Inverse; ///< World to object space
+		std::shared_ptr<const MeshBVH> Mesh; ///< Triangles of the mesh
+	};
+
+	std::vector<Instance> _instances; ///< Collected instances
+	std::vector<glm::vec3> _lower; ///< Lower corners of world space boxes
+	std::vector<glm::vec3> _upper; ///< Upper corners of world space boxes
+	BVH _tree; ///< Hierarchy over instances
+
+public:
+	/// Clear instances.
+	/**
+		Removes all instances, the memory is kept for the next build.
+	*/
+	void Clear();
+	/// Add instance.
+	/**
+		Adds mesh placed by the model matrix.
+
+		\param[in] entity	Owning entity.
+		\param[in] model	Model matrix.
+		\param[in] mesh		Triangles of the mesh.
+	*/
+	void Add(size_t entity, const glm::mat4& model, std::shared_ptr<const MeshBVH> mesh);
+	/// Build hierarchy.
+	/**
+		Builds hierarchy over added instances.
+	*/
+	void Build();
+	/// Ray query.
+	/**
+		Returns the closest hit along the ray.
+
+		\param[in] origin		Origin of the ray.
+		\param[in] direction	Normalized direction of the ray.
+		\param[in] distance		Length of the ray.
+		\param[in] ignore		Entity skipped by the ray, usually the one casting it.
+	*/
+	RayHit Raycast(const glm::vec3& origin, const glm::vec3& direction, GLfloat distance, size_t ignore) const;
+	/// Instance count getter.
+	/**
+		Returns number of instances.
+	*/
+	inline size_t GetInstanceCount() const { return _instances.size(); }
+};
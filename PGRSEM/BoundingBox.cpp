@@ -0,0 +1,32 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       BoundingBox.cpp
+ * \author     Dominik Pupala
+ * \date       2021/03/06
+ * \brief      Source file for bounding box transforms.
+ *
+ *  Source file containing declarations for BoundingBox class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "BoundingBox.h"
+
+void BoundingBox::Transform(const glm::mat4& model, const glm::vec3& lower, const glm::vec3& upper, glm::vec3& outCenter, glm::vec3& outExtent)
+{
+	outCenter = glm::vec3(model * glm::vec4((lower + upper) * 0.5f, 1.0f));
+	outExtent = Enclose(glm::mat3(model), (upper - lower) * 0.5f);
+}
+
+glm::vec3 BoundingBox::Enclose(const glm::mat3& axes, const glm::vec3& half)
+{
+	// rotated box is enclosed by the box of its projected axes
+	return glm::abs(axes[0]) * half.x + glm::abs(axes[1]) * half.y + glm::abs(axes[2]) * half.z;
+}
+
+void BoundingBox::TransformRay(const glm::mat4& inverse, const glm::vec3& origin, const glm::vec3& direction, glm::vec3& outOrigin, glm::vec3& outDirection)
+{
+	// scaled direction keeps the distance in world units
+	outOrigin = glm::vec3(inverse * glm::vec4(origin, 1.0f));
+	outDirection = glm::vec3(inverse * glm::vec4(direction, 0.0f));
+}
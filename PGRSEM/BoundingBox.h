@@ -0,0 +1,64 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       BoundingBox.h
+ * \author     Dominik Pupala
+ * \date       2021/03/06
+ * \brief      Header file for bounding box transforms.
+ *
+ *  Header file containing definitions for BoundingBox class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "pgr.h"
+
+/// Static class that places bounding boxes and rays of meshes into the world.
+/**
+  This static class moves local bounding boxes into world space as axis aligned boxes
+  and world rays into local space of the mesh they are tested against.
+*/
+class BoundingBox
+{
+public:
+	/// Transform box.
+	/**
+		Computes world center and extents of axis aligned box enclosing the placed local box.
+
+		\param[in] model		Model matrix of the box.
+		\param[in] lower		Local lower corner.
+		\param[in] upper		Local upper corner.
+		\param[out] outCenter	World center.
+		\param[out] outExtent	World half size along each axis.
+	*/
+	static void Transform(const glm::mat4& model, const glm::vec3& lower, const glm::vec3& upper, glm::vec3& outCenter, glm::vec3& outExtent);
+	/// Enclose box.
+	/**
+		Returns world half size along each axis of box spanned by the axes.
+
+		\param[in] axes		World axes of the box, scaled or unit.
+		\param[in] half		Half size along each of the axes.
+	*/
+	static glm::vec3 Enclose(const glm::mat3& axes, const glm::vec3& half);
+	/// Transform ray.
+	/**
+		Moves world ray into local space, the direction keeps its scale, so hit distances
+		along the local ray stay in world units.
+
+		\param[in] inverse			Inverse model matrix.
+		\param[in] origin			World origin.
+		\param[in] direction		World unit direction.
+		\param[out] outOrigin		Local origin.
+		\param[out] outDirection	Local direction.
+	*/
+	static void TransformRay(const glm::mat4& inverse, const glm::vec3& origin, const glm::vec3& direction, glm::vec3& outOrigin, glm::vec3& outDirection);
+
+private:
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	BoundingBox() { }
+};
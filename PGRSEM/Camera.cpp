@@ -68,6 +68,29 @@ void Camera::SetDirection(const glm::vec3& direction)
 	_up = glm::normalize(glm::cross(_right, _front));
 }
 
+Frustum Camera::ExtractFrustum(const glm::mat4& pv)
+{
+	// rows of the matrix, glm stores columns
+	glm::vec4 rows[4];
+
+	for (int i = 0; i < 4; ++i)
+		rows[i] = glm::vec4(pv[0][i], pv[1][i], pv[2][i], pv[3][i]);
+
+	Frustum frustum;
+	frustum.Planes[0] = rows[3] + rows[0];
+	frustum.Planes[1] = rows[3] - rows[0];
+	frustum.Planes[2] = rows[3] + rows[1];
+	frustum.Planes[3] = rows[3] - rows[1];
+	frustum.Planes[4] = rows[3] + rows[2];
+	frustum.Planes[5] = rows[3] - rows[2];
+
+	// unit normals turn plane equation into distance
+	for (glm::vec4& plane : frustum.Planes)
+		plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+
+	return frustum;
+}
+
 void Camera::Update()
 {
 	_front = glm::normalize(glm::vec3(
@@ -16,6 +16,16 @@
 
 #include "pgr.h"
 
+/// Struct that contains view frustum.
+/**
+  This struct contains six normalized planes facing inside the frustum,
+  point is inside if its distance from all of them is positive.
+*/
+struct Frustum
+{
+	glm::vec4 Planes[6]; ///< Left, right, bottom, top, near and far plane
+};
+
 /// Class that handles camera object.
 /**
   This class contains context and functionality of camera object.
@@ -97,6 +107,13 @@ public:
 		Returns view matrix of the camera.
 	*/
 	inline glm::mat4 GetViewMatrix() const { return glm::lookAt(_position, _position + _front, _up); }
+	/// Extract frustum.
+	/**
+		Returns world space frustum planes of the combined projection and view matrix.
+
+		\param[in] pv			Projection matrix multiplied by view matrix.
+	*/
+	static Frustum ExtractFrustum(const glm::mat4& pv);
 	/// Debug method.
 	/**
 		Prints out current position and yaw with pitch.
@@ -0,0 +1,389 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CollisionWorld.cpp
+ * \author     Dominik Pupala
+ * \date       2021/05/06
+ * \brief      Source file for collision world.
+ *
+ *  Source file containing declarations for CollisionWorld class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "CollisionWorld.h"
+#include "BoundingBox.h"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define COLLISION_SSE
+#endif
+
+CollisionWorld::CollisionWorld()
+	: _query(0), _moves(0), _tested(0), _blocked(0), _time(0.0)
+{
+}
+
+void CollisionWorld::AddSphere(const glm::vec3& center, GLfloat radius)
+{
+	const glm::vec3 axes[3] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+
+	PushBox(center, axes, glm::vec3(0.0f), radius);
+}
+
+void CollisionWorld::AddBox(const glm::mat4& model, const glm::vec3& lower, const glm::vec3& upper)
+{
+	glm::vec3 center = glm::vec3(model * glm::vec4((lower + upper) * 0.5f, 1.0f));
+	glm::vec3 half = (upper - lower) * 0.5f;
+
+	// scale moves from the axes into the extents
+	glm::vec3 axes[3];
+	glm::vec3 extent;
+
+	for (int i = 0; i < 3; ++i)
+	{
+		GLfloat length = glm::length(glm::vec3(model[i]));
+		axes[i] = length > 0.0f ? glm::vec3(model[i]) / length : glm::vec3(0.0f);
+		extent[i] = half[i] * length;
+	}
+
+	PushBox(center, axes, extent, 0.0f);
+}
+
+void CollisionWorld::AddMesh(const glm::mat4& model, std::shared_ptr<const MeshBVH> mesh)
+{
+	glm::vec3 lower, upper;
+	mesh->GetBounds(lower, upper);
+
+	glm::vec3 center, reach;
+	BoundingBox::Transform(model, lower, upper, center, reach);
+
+	glm::mat3 axes = glm::mat3(model);
+
+	_meshInverse.push_back(glm::inverse(model));
+	_meshScale.push_back(std::min(glm::length(axes[0]), std::min(glm::length(axes[1]), glm::length(axes[2]))));
+	_meshes.push_back(std::move(mesh));
+	_meshStamps.push_back(0);
+
+	Insert((GLuint)(_meshes.size() - 1) | MESH_BIT, center - reach, center + reach);
+}
+
+CollisionWorld::Body CollisionWorld::AddBody(const glm::vec3& center, GLfloat radius)
+{
+	Body body = _bodyCenters.size();
+	glm::vec3 reach = glm::vec3(radius);
+
+	_bodyCenters.push_back(center);
+	_bodyRadii.push_back(radius);
+	_bodyCells.push_back(GetCells(center - reach, center + reach));
+	_bodyStamps.push_back(0);
+	_bodyLower.push_back(glm::vec3(-std::numeric_limits<GLfloat>::max()));
+	_bodyUpper.push_back(glm::vec3(std::numeric_limits<GLfloat>::max()));
+
+	const CellRange& cells = _bodyCells.back();
+
+	for (GLint x = cells.MinX; x <= cells.MaxX; ++x)
+		for (GLint z = cells.MinZ; z <= cells.MaxZ; ++z)
+			_bodyGrid[Key(x, z)].push_back((GLuint)body);
+
+	return body;
+}
+
+void CollisionWorld::SetBounds(Body body, const glm::vec3& lower, const glm::vec3& upper)
+{
+	_bodyLower[body] = lower;
+	_bodyUpper[body] = upper;
+}
+
+bool CollisionWorld::Move(Body body, const glm::vec3& center, GLuint tests)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	GLfloat radius = _bodyRadii[body];
+	const glm::vec3& lower = _bodyLower[body];
+	const glm::vec3& upper = _bodyUpper[body];
+
+	bool inside =
+		center.x - radius >= lower.x && center.x + radius <= upper.x &&
+		center.y - radius >= lower.y && center.y + radius <= upper.y &&
+		center.z - radius >= lower.z && center.z + radius <= upper.z;
+	bool free = inside && !Overlaps(body, center, _bodyCenters[body], radius, tests);
+
+	if (free)
+		Place(body, center);
+	else
+		++_blocked;
+
+	++_moves;
+	_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	return free;
+}
+
+void CollisionWorld::Place(Body body, const glm::vec3& center)
+{
+	glm::vec3 reach = glm::vec3(_bodyRadii[body]);
+	CellRange cells = GetCells(center - reach, center + reach);
+	CellRange& old = _bodyCells[body];
+
+	_bodyCenters[body] = center;
+
+	if (cells.MinX == old.MinX && cells.MinZ == old.MinZ && cells.MaxX == old.MaxX && cells.MaxZ == old.MaxZ)
+		return;
+
+	for (GLint x = old.MinX; x <= old.MaxX; ++x)
+	{
+		for (GLint z = old.MinZ; z <= old.MaxZ; ++z)
+		{
+			std::vector<GLuint>& cell = _bodyGrid[Key(x, z)];
+			cell.erase(std::find(cell.begin(), cell.end(), (GLuint)body));
+		}
+	}
+
+	for (GLint x = cells.MinX; x <= cells.MaxX; ++x)
+		for (GLint z = cells.MinZ; z <= cells.MaxZ; ++z)
+			_bodyGrid[Key(x, z)].push_back((GLuint)body);
+
+	old = cells;
+}
+
+void CollisionWorld::PushBox(const glm::vec3& center, const glm::vec3 axes[3], const glm::vec3& extent, GLfloat margin)
+{
+	_centerX.push_back(center.x);
+	_centerY.push_back(center.y);
+	_centerZ.push_back(center.z);
+	_axisXX.push_back(axes[0].x);
+	_axisXY.push_back(axes[0].y);
+	_axisXZ.push_back(axes[0].z);
+	_axisYX.push_back(axes[1].x);
+	_axisYY.push_back(axes[1].y);
+	_axisYZ.push_back(axes[1].z);
+	_axisZX.push_back(axes[2].x);
+	_axisZY.push_back(axes[2].y);
+	_axisZZ.push_back(axes[2].z);
+	_extentX.push_back(extent.x);
+	_extentY.push_back(extent.y);
+	_extentZ.push_back(extent.z);
+	_margin.push_back(margin);
+	_boxStamps.push_back(0);
+
+	glm::vec3 reach = BoundingBox::Enclose(glm::mat3(axes[0], axes[1], axes[2]), extent) + glm::vec3(margin);
+
+	Insert((GLuint)_margin.size() - 1, center - reach, center + reach);
+}
+
+void CollisionWorld::Report()
+{
+	size_t moves = _moves > 0 ? _moves : 1;
+
+	std::cout << "Collisions: " << _margin.size() << " boxes, " << _meshes.size() << " meshes, "
+		<< _bodyCenters.size() << " bodies in " << _cells.size() << " cells, "
+		<< _moves << " moves (" << _blocked << " blocked), " << _tested / moves << " tests and "
+		<< _time * 1000.0 / moves << " us per move" << std::endl;
+
+	_moves = 0;
+	_tested = 0;
+	_blocked = 0;
+	_time = 0.0;
+}
+
+bool CollisionWorld::Overlaps(Body body, const glm::vec3& center, const glm::vec3& previous, GLfloat radius, GLuint tests)
+{
+	glm::vec3 reach = glm::vec3(radius);
+	CellRange cells = GetCells(center - reach, center + reach);
+
+	// stamps skip colliders spanning more cells of the query
+	++_query;
+	_candidates.clear();
+
+	for (GLint x = cells.MinX; x <= cells.MaxX && (tests & TEST_STATIC); ++x)
+	{
+		for (GLint z = cells.MinZ; z <= cells.MaxZ; ++z)
+		{
+			auto found = _cells.find(Key(x, z));
+
+			if (found == _cells.end())
+				continue;
+
+			for (GLuint collider : found->second)
+			{
+				if (collider & MESH_BIT)
+				{
+					GLuint mesh = collider & ~MESH_BIT;
+
+					if (_meshStamps[mesh] == _query)
+						continue;
+
+					_meshStamps[mesh] = _query;
+					++_tested;
+
+					if (TouchesMesh(mesh, center, radius) && !TouchesMesh(mesh, previous, radius))
+						return true;
+				}
+				else if (_boxStamps[collider] != _query)
+				{
+					_boxStamps[collider] = _query;
+					_candidates.push_back(collider);
+				}
+			}
+		}
+	}
+
+	_tested += _candidates.size();
+
+#ifdef COLLISION_SSE
+	size_t groups = (_candidates.size() + 3) / 4;
+	_gather.resize(groups * COMPONENTS * 4);
+
+	for (size_t i = 0; i < groups * 4; ++i)
+	{
+		GLfloat* lane = &_gather[(i / 4) * COMPONENTS * 4 + i % 4];
+
+		if (i < _candidates.size())
+		{
+			GLuint box = _candidates[i];
+			const GLfloat values[COMPONENTS] =
+			{
+				_centerX[box], _centerY[box], _centerZ[box],
+				_axisXX[box], _axisXY[box], _axisXZ[box],
+				_axisYX[box], _axisYY[box], _axisYZ[box],
+				_axisZX[box], _axisZY[box], _axisZZ[box],
+				_extentX[box], _extentY[box], _extentZ[box],
+				_margin[box]
+			};
+
+			for (size_t c = 0; c < COMPONENTS; ++c)
+				lane[c * 4] = values[c];
+		}
+		else
+		{
+			// padding box lies far away, the last group needs no scalar tail
+			const GLfloat values[COMPONENTS] = { 1e18f, 1e18f, 1e18f, 1, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0, 0 };
+
+			for (size_t c = 0; c < COMPONENTS; ++c)
+				lane[c * 4] = values[c];
+		}
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 r = _mm_set1_ps(radius);
+
+	for (size_t g = 0; g < groups; ++g)
+	{
+		const GLfloat* data = &_gather[g * COMPONENTS * 4];
+		__m128 box[COMPONENTS];
+
+		for (size_t c = 0; c < COMPONENTS; ++c)
+			box[c] = _mm_loadu_ps(data + c * 4);
+
+		__m128 reach = _mm_add_ps(r, box[15]);
+		__m128 reachSquared = _mm_mul_ps(reach, reach);
+		__m128 touches[2];
+
+		for (int p = 0; p < 2; ++p)
+		{
+			const glm::vec3& point = p == 0 ? center : previous;
+
+			__m128 dx = _mm_sub_ps(_mm_set1_ps(point.x), box[0]);
+			__m128 dy = _mm_sub_ps(_mm_set1_ps(point.y), box[1]);
+			__m128 dz = _mm_sub_ps(_mm_set1_ps(point.z), box[2]);
+
+			// distance from the box along each of its axes, zero inside
+			__m128 distanceSquared = zero;
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				__m128 local = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, box[3 + axis * 3]), _mm_mul_ps(dy, box[4 + axis * 3])), _mm_mul_ps(dz, box[5 + axis * 3]));
+				__m128 outside = _mm_max_ps(_mm_sub_ps(_mm_andnot_ps(sign, local), box[12 + axis]), zero);
+				distanceSquared = _mm_add_ps(distanceSquared, _mm_mul_ps(outside, outside));
+			}
+
+			touches[p] = _mm_cmple_ps(distanceSquared, reachSquared);
+		}
+
+		if (_mm_movemask_ps(_mm_andnot_ps(touches[1], touches[0])))
+			return true;
+	}
+#else
+	for (GLuint box : _candidates)
+	{
+		if (TouchesBox(box, center, radius) && !TouchesBox(box, previous, radius))
+			return true;
+	}
+#endif
+
+	for (GLint x = cells.MinX; x <= cells.MaxX && (tests & TEST_BODIES); ++x)
+	{
+		for (GLint z = cells.MinZ; z <= cells.MaxZ; ++z)
+		{
+			auto found = _bodyGrid.find(Key(x, z));
+
+			if (found == _bodyGrid.end())
+				continue;
+
+			for (GLuint other : found->second)
+			{
+				if (other == body || _bodyStamps[other] == _query)
+					continue;
+
+				_bodyStamps[other] = _query;
+				++_tested;
+
+				GLfloat contact = radius + _bodyRadii[other];
+				glm::vec3 now = center - _bodyCenters[other];
+				glm::vec3 before = previous - _bodyCenters[other];
+
+				if (glm::dot(now, now) <= contact * contact && glm::dot(before, before) > contact * contact)
+					return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+bool CollisionWorld::TouchesBox(GLuint box, const glm::vec3& center, GLfloat radius) const
+{
+	glm::vec3 offset = center - glm::vec3(_centerX[box], _centerY[box], _centerZ[box]);
+	glm::vec3 local = glm::vec3(
+		glm::dot(offset, glm::vec3(_axisXX[box], _axisXY[box], _axisXZ[box])),
+		glm::dot(offset, glm::vec3(_axisYX[box], _axisYY[box], _axisYZ[box])),
+		glm::dot(offset, glm::vec3(_axisZX[box], _axisZY[box], _axisZZ[box])));
+
+	glm::vec3 outside = glm::max(glm::abs(local) - glm::vec3(_extentX[box], _extentY[box], _extentZ[box]), glm::vec3(0.0f));
+	GLfloat reach = radius + _margin[box];
+
+	return glm::dot(outside, outside) <= reach * reach;
+}
+
+bool CollisionWorld::TouchesMesh(GLuint mesh, const glm::vec3& center, GLfloat radius) const
+{
+	// sphere turns into ellipsoid in object space, the sphere around it is tested
+	glm::vec3 local = glm::vec3(_meshInverse[mesh] * glm::vec4(center, 1.0f));
+
+	return _meshes[mesh]->Overlaps(local, radius / _meshScale[mesh]);
+}
+
+CollisionWorld::CellRange CollisionWorld::GetCells(const glm::vec3& lower, const glm::vec3& upper)
+{
+	CellRange cells;
+	cells.MinX = (GLint)std::floor(lower.x / CELL_SIZE);
+	cells.MinZ = (GLint)std::floor(lower.z / CELL_SIZE);
+	cells.MaxX = (GLint)std::floor(upper.x / CELL_SIZE);
+	cells.MaxZ = (GLint)std::floor(upper.z / CELL_SIZE);
+
+	return cells;
+}
+
+void CollisionWorld::Insert(GLuint collider, const glm::vec3& lower, const glm::vec3& upper)
+{
+	CellRange cells = GetCells(lower, upper);
+
+	for (GLint x = cells.MinX; x <= cells.MaxX; ++x)
+		for (GLint z = cells.MinZ; z <= cells.MaxZ; ++z)
+			_cells[Key(x, z)].push_back(collider);
+}
@@ -0,0 +1,237 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       CollisionWorld.h
+ * \author     Dominik Pupala
+ * \date       2021/05/06
+ * \brief      Header file for collision world.
+ *
+ *  Header file containing definitions for CollisionWorld class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <limits>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include "pgr.h"
+#include "BVH.h"
+
+/// Class that resolves collisions of moving bodies.
+/**
+  This class contains static colliders and moving bodies registered in uniform grid
+  over the ground plane, height is only compared by the narrowphase. Spheres and boxes
+  are stored as oriented boxes with rounded edges in structure of arrays layout,
+  candidates of single query are gathered and tested four at a time. Meshes are tested
+  triangle by triangle through their hierarchy. Bodies are spheres moved one by one,
+  move that ends in contact is rejected and the body stays where it was.
+*/
+class CollisionWorld
+{
+public:
+	typedef size_t Body; ///< Index of the moving body
+
+	static constexpr GLfloat CELL_SIZE = 2.0f; ///< Edge of the grid cell
+
+	static constexpr GLuint TEST_STATIC = 1; ///< Move is blocked by static colliders
+	static constexpr GLuint TEST_BODIES = 2; ///< Move is blocked by other bodies
+	static constexpr GLuint TEST_ALL = TEST_STATIC | TEST_BODIES; ///< Move is blocked by anything
+
+private:
+	static constexpr GLuint MESH_BIT = 0x80000000u; ///< Marks mesh colliders in cells
+	static constexpr size_t COMPONENTS = 16; ///< Floats of single box
+
+	/// Struct that contains range of grid cells.
+	struct CellRange
+	{
+		GLint MinX, MinZ, MaxX, MaxZ;
+	};
+
+	// Static boxes, spheres are boxes with zero extents
+	std::vector<GLfloat> _centerX, _centerY, _centerZ; ///< Box center
+	std::vector<GLfloat> _axisXX, _axisXY, _axisXZ; ///< Unit x axis of the box
+	std::vector<GLfloat> _axisYX, _axisYY, _axisYZ; ///< Unit y axis of the box
+	std::vector<GLfloat> _axisZX, _axisZY, _axisZZ; ///< Unit z axis of the box
+	std::vector<GLfloat> _extentX, _extentY, _extentZ; ///< Box half size along its axes
+	std::vector<GLfloat> _margin; ///< Rounding of the box edges
+
+	// Static meshes
+	std::vector<glm::mat4> _meshInverse; ///< World to object space
+	std::vector<GLfloat> _meshScale; ///< Smallest axis scale of the model matrix
+	std::vector<std::shared_ptr<const MeshBVH>> _meshes; ///< Triangles of the meshes
+
+	// Moving bodies
+	std::vector<glm::vec3> _bodyCenters; ///< Body centers
+	std::vector<GLfloat> _bodyRadii; ///< Body radii
+	std::vector<CellRange> _bodyCells; ///< Cells the bodies are registered in
+	std::vector<glm::vec3> _bodyLower; ///< Lower corners of the space the bodies stay in
+	std::vector<glm::vec3> _bodyUpper; ///< Upper corners of the space the bodies stay in
+
+	std::unordered_map<uint64_t, std::vector<GLuint>> _cells; ///< Static colliders per cell, meshes carry the mesh bit
+	std::unordered_map<uint64_t, std::vector<GLuint>> _bodyGrid; ///< Bodies per cell
+
+	// Query scratch
+	GLuint _query; ///< Current query
+	std::vector<GLuint> _boxStamps; ///< Query that saw the box last
+	std::vector<GLuint> _meshStamps; ///< Query that saw the mesh last
+	std::vector<GLuint> _bodyStamps; ///< Query that saw the body last
+	std::vector<GLuint> _candidates; ///< Boxes gathered by the query
+	std::vector<GLfloat> _gather; ///< Gathered boxes, groups of four interleaved by component
+
+	// Statistics
+	size_t _moves; ///< Moves since the last report
+	size_t _tested; ///< Narrowphase tests since the last report
+	size_t _blocked; ///< Rejected moves since the last report
+	double _time; ///< Milliseconds spent in moves since the last report
+
+public:
+	/// Constructor
+	/**
+		Creates empty world.
+	*/
+	CollisionWorld();
+	/// Add sphere.
+	/**
+		Adds static sphere.
+
+		\param[in] center	Center of the sphere.
+		\param[in] radius	Radius of the sphere.
+	*/
+	void AddSphere(const glm::vec3& center, GLfloat radius);
+	/// Add box.
+	/**
+		Adds static box given in object space, placed by the model matrix.
+
+		\param[in] model	Model matrix.
+		\param[in] lower	Lower corner of the box.
+		\param[in] upper	Upper corner of the box.
+	*/
+	void AddBox(const glm::mat4& model, const glm::vec3& lower, const glm::vec3& upper);
+	/// Add mesh.
+	/**
+		Adds static mesh placed by the model matrix.
+
+		\param[in] model	Model matrix.
+		\param[in] mesh		Triangles of the mesh.
+	*/
+	void AddMesh(const glm::mat4& model, std::shared_ptr<const MeshBVH> mesh);
+	/// Add body.
+	/**
+		Adds moving sphere and returns its handle.
+
+		\param[in] center	Center of the sphere.
+		\param[in] radius	Radius of the sphere.
+	*/
+	Body AddBody(const glm::vec3& center, GLfloat radius);
+	/// Set bounds.
+	/**
+		Limits the space the body can move in, bodies are unbounded by default.
+
+		\param[in] body		Target body.
+		\param[in] lower	Lower corner of the space.
+		\param[in] upper	Upper corner of the space.
+	*/
+	void SetBounds(Body body, const glm::vec3& lower, const glm::vec3& upper);
+	/// Move body.
+	/**
+		Moves the body if it doesn't end in contact with any collider or other body,
+		returns false if the move was rejected. Contacts the body is in already don't
+		block it, so bodies placed into colliders can leave them.
+
+		\param[in] body		Moved body.
+		\param[in] center	New center of the body.
+		\param[in] tests	Colliders blocking the move.
+	*/
+	bool Move(Body body, const glm::vec3& center, GLuint tests = TEST_ALL);
+	/// Place body.
+	/**
+		Moves the body without any test.
+
+		\param[in] body		Moved body.
+		\param[in] center	New center of the body.
+	*/
+	void Place(Body body, const glm::vec3& center);
+	/// Body center getter.
+	/**
+		Returns center of the body.
+
+		\param[in] body		Target body.
+	*/
+	inline const glm::vec3& GetCenter(Body body) const { return _bodyCenters[body]; }
+	/// Report statistics.
+	/**
+		Prints colliders, moves and time spent in them since the last report and resets them.
+	*/
+	void Report();
+
+private:
+	/// Push box.
+	/**
+		Stores the box and registers it in all cells it covers.
+
+		\param[in] center	Center of the box.
+		\param[in] axes		Unit axes of the box.
+		\param[in] extent	Half size along the axes.
+		\param[in] margin	Rounding of the edges.
+	*/
+	void PushBox(const glm::vec3& center, const glm::vec3 axes[3], const glm::vec3& extent, GLfloat margin);
+	/// Overlap test.
+	/**
+		Returns true if the sphere touches any collider or body other than the given one.
+		Colliders already touched by the sphere at its previous center are skipped.
+
+		\param[in] body			Tested body.
+		\param[in] center		Center of the sphere.
+		\param[in] previous		Previous center of the sphere.
+		\param[in] radius		Radius of the sphere.
+		\param[in] tests		Tested colliders.
+	*/
+	bool Overlaps(Body body, const glm::vec3& center, const glm::vec3& previous, GLfloat radius, GLuint tests);
+	/// Box test.
+	/**
+		Returns true if the sphere touches the box.
+
+		\param[in] box			Tested box.
+		\param[in] center		Center of the sphere.
+		\param[in] radius		Radius of the sphere.
+	*/
+	bool TouchesBox(GLuint box, const glm::vec3& center, GLfloat radius) const;
+	/// Mesh test.
+	/**
+		Returns true if the sphere touches the mesh.
+
+		\param[in] mesh			Tested mesh.
+		\param[in] center		Center of the sphere.
+		\param[in] radius		Radius of the sphere.
+	*/
+	bool TouchesMesh(GLuint mesh, const glm::vec3& center, GLfloat radius) const;
+	/// Cells getter.
+	/**
+		Returns range of cells covered by the box.
+
+		\param[in] lower	Lower corner of the box.
+		\param[in] upper	Upper corner of the box.
+	*/
+	static CellRange GetCells(const glm::vec3& lower, const glm::vec3& upper);
+	/// Cell key.
+	/**
+		Packs cell coordinates into hash key.
+
+		\param[in] x	Cell coordinate along x.
+		\param[in] z	Cell coordinate along z.
+	*/
+	static inline uint64_t Key(GLint x, GLint z) { return (uint64_t)(uint32_t)x << 32 | (uint32_t)z; }
+	/// Insert collider.
+	/**
+		Registers static collider in all cells covered by its box.
+
+		\param[in] collider		Collider index, meshes carry the mesh bit.
+		\param[in] lower		Lower corner of the box.
+		\param[in] upper		Upper corner of the box.
+	*/
+	void Insert(GLuint collider, const glm::vec3& lower, const glm::vec3& upper);
+};
@@ -31,6 +31,22 @@ glm::mat4 Curve::AlignObject(const glm::vec3& position, const glm::vec3& directi
 	return matrix;
 }
 
+glm::mat4 Curve::AlignObject(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& up)
+{
+	glm::vec3 x = glm::cross(up, -direction);
+	x = (!x.x && !x.y && !x.z) ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::normalize(x);
+
+	glm::vec3 z = glm::cross(x, up);
+	glm::mat4 matrix = glm::mat4(
+		x.x, x.y, x.z, 0.0f,
+		up.x, up.y, up.z, 0.0f,
+		z.x, z.y, z.z, 0.0f,
+		position.x, position.y, position.z, 1.0f
+	);
+
+	return matrix;
+}
+
 glm::mat4 Curve::BasisMatrix(float s)
 {
 	return 2.0f * glm::mat4(
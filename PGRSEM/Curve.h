@@ -31,6 +31,16 @@ public:
 		\param[in] direction	Direction of object.
 	*/
 	static glm::mat4 AlignObject(const glm::vec3& position, const glm::vec3& direction);
+	/// Aligns object to surface.
+	/**
+		Aligns object via creating the model matrix from position, direction and up vectors.
+		Object stands on the surface given by the up vector, direction is projected onto it.
+
+		\param[in] position		Position of object.
+		\param[in] direction	Direction of object.
+		\param[in] up			Unit normal of the surface.
+	*/
+	static glm::mat4 AlignObject(const glm::vec3& position, const glm::vec3& direction, const glm::vec3& up);
 	/// Parametrizable Catmull-Rom basis matrix.
 	/**
 		Returns the Catmull-Rom basis from the given parameter. Matrix will be multiplied by factor of 2.
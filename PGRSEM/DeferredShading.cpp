@@ -0,0 +1,247 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       DeferredShading.cpp
+ * \author     Dominik Pupala
+ * \date       2021/10/06
+ * \brief      Source file for deferred shading.
+ *
+ *  Source file containing declarations for DeferredShading class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "DeferredShading.h"
+#include "StateTracker.h"
+#include "VertexBufferLayout.h"
+
+#include <cmath>
+#include <iostream>
+
+/// Uniform handles of lighting shaders.
+static const struct
+{
+	Shader::Uniform AlbedoSampler = Shader::GetUniform("albedoSampler");
+	Shader::Uniform SpecularSampler = Shader::GetUniform("specularSampler");
+	Shader::Uniform NormalSampler = Shader::GetUniform("normalSampler");
+	Shader::Uniform DepthSampler = Shader::GetUniform("depthSampler");
+	Shader::Uniform AmbientSampler = Shader::GetUniform("ambientSampler");
+	Shader::Uniform InversePV = Shader::GetUniform("inversePVMatrix");
+	Shader::Uniform FirstLight = Shader::GetUniform("firstLight");
+	Shader::Uniform Spot = Shader::GetUniform("spot");
+} Uniforms;
+
+DeferredShading::DeferredShading(Shader& screenShader, Shader& volumeShader)
+	: _screenShader(&screenShader), _volumeShader(&volumeShader), _enabled(true)
+{
+	// G-buffer always samples the same units, lights come from the unit of the light list
+	for (Shader* shader : { _screenShader, _volumeShader })
+	{
+		shader->Bind();
+		shader->SetUniform1i(Uniforms.AlbedoSampler, 0);
+		shader->SetUniform1i(Uniforms.SpecularSampler, 1);
+		shader->SetUniform1i(Uniforms.NormalSampler, 2);
+		shader->SetUniform1i(Uniforms.DepthSampler, 3);
+		shader->SetUniform1i(Uniforms.AmbientSampler, 4);
+	}
+
+	// screen triangle is made up by the vertex shader
+	_screen = new VertexArray();
+
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+
+	GLfloat step = glm::radians(180.0f) / SPHERE_STACKS;
+	GLfloat slice = glm::radians(360.0f) / VOLUME_SLICES;
+
+	// faces lie inside the unit sphere, vertices are pushed out so the volume covers it
+	GLfloat scale = 1.0f / (std::cos(step) * std::cos(slice / 2.0f));
+
+	for (GLuint i = 0; i <= SPHERE_STACKS; ++i)
+	{
+		for (GLuint j = 0; j < VOLUME_SLICES; ++j)
+		{
+			vertices.push_back(scale * std::sin(i * step) * std::cos(j * slice));
+			vertices.push_back(scale * std::cos(i * step));
+			vertices.push_back(scale * std::sin(i * step) * std::sin(j * slice));
+		}
+	}
+
+	for (GLuint i = 0; i < SPHERE_STACKS; ++i)
+	{
+		for (GLuint j = 0; j < VOLUME_SLICES; ++j)
+		{
+			GLuint a = i * VOLUME_SLICES + j;
+			GLuint b = i * VOLUME_SLICES + (j + 1) % VOLUME_SLICES;
+
+			indices.insert(indices.end(), { a, b, a + VOLUME_SLICES, b, b + VOLUME_SLICES, a + VOLUME_SLICES });
+		}
+	}
+
+	_sphere = CreateVolume(vertices, indices);
+
+	// apex lies at the light, base at unit distance along the axis
+	vertices = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+	indices.clear();
+
+	scale = 1.0f / std::cos(slice / 2.0f);
+
+	for (GLuint j = 0; j < VOLUME_SLICES; ++j)
+	{
+		vertices.push_back(scale * std::cos(j * slice));
+		vertices.push_back(scale * std::sin(j * slice));
+		vertices.push_back(1.0f);
+
+		GLuint a = 2 + j;
+		GLuint b = 2 + (j + 1) % VOLUME_SLICES;
+
+		indices.insert(indices.end(), { 0, b, a, 1, a, b });
+	}
+
+	_cone = CreateVolume(vertices, indices);
+}
+
+DeferredShading::~DeferredShading()
+{
+	delete _screen;
+
+	for (Volume* volume : { &_sphere, &_cone })
+	{
+		delete volume->VAO;
+		delete volume->VB;
+		delete volume->EB;
+	}
+}
+
+void DeferredShading::AddShader(const Shader& shader, Shader& geometry)
+{
+	_shaders[&shader] = &geometry;
+}
+
+Shader* DeferredShading::GetShader(const Shader& shader) const
+{
+	auto found = _shaders.find(&shader);
+
+	return found != _shaders.end() ? found->second : nullptr;
+}
+
+void DeferredShading::AddPasses(RenderGraph& graph, const glm::mat4& projection, const glm::mat4& view, const LightClusters& lights, std::function<void()> geometry)
+{
+	GLsizei width = graph.GetWidth();
+	GLsizei height = graph.GetHeight();
+
+	RenderGraph::Resource albedo = graph.Create("albedo", width, height, ALBEDO_FORMAT);
+	RenderGraph::Resource specular = graph.Create("specular", width, height, SPECULAR_FORMAT);
+	RenderGraph::Resource normal = graph.Create("normal", width, height, NORMAL_FORMAT);
+	RenderGraph::Resource ambient = graph.Create("ambient", width, height, AMBIENT_FORMAT);
+	RenderGraph::Resource depth = graph.Create("depth", width, height, DEPTH_FORMAT);
+
+	RenderGraph::Pass fill = graph.AddPass("g-buffer", [geometry]()
+	{
+		// blending would mix the surfaces with the cleared targets
+		StateTracker::Disable(GL_BLEND);
+		geometry();
+	});
+
+	// attachments follow the outputs of the geometry shaders
+	graph.Write(fill, albedo);
+	graph.Write(fill, specular);
+	graph.Write(fill, normal);
+	graph.Write(fill, ambient);
+	graph.Write(fill, depth);
+
+	glm::mat4 pv = projection * view;
+
+	RenderGraph::Pass lighting = graph.AddPass("lighting", [this, &graph, &lights, albedo, specular, normal, ambient, depth, pv]()
+	{
+		Shade(graph.GetTexture(albedo), graph.GetTexture(specular), graph.GetTexture(normal), graph.GetTexture(ambient), graph.GetTexture(depth), pv, lights);
+	});
+
+	graph.Read(lighting, albedo);
+	graph.Read(lighting, specular);
+	graph.Read(lighting, normal);
+	graph.Read(lighting, ambient);
+	graph.Read(lighting, depth);
+	graph.Write(lighting, RenderGraph::BACKBUFFER);
+}
+
+void DeferredShading::Report() const
+{
+	std::cout << "Deferred shading: " << (_enabled ? "enabled" : "disabled") << std::endl;
+}
+
+void DeferredShading::Shade(GLuint albedo, GLuint specular, GLuint normal, GLuint ambient, GLuint depth, const glm::mat4& pv, const LightClusters& lights)
+{
+	GLuint textures[] = { albedo, specular, normal, depth, ambient };
+
+	for (GLuint i = 0; i < 5; ++i)
+	{
+		StateTracker::ActiveTexture(GL_TEXTURE0 + i);
+		StateTracker::BindTexture(GL_TEXTURE_2D, textures[i]);
+	}
+
+	StateTracker::ActiveTexture(GL_TEXTURE0);
+
+	glm::mat4 inverse = glm::inverse(pv);
+
+	// screen pass lays down depth of the surfaces for the volumes and forward draws
+	StateTracker::Disable(GL_BLEND);
+	StateTracker::DepthFunc(GL_ALWAYS);
+	StateTracker::DepthMask(GL_TRUE);
+
+	_screenShader->Bind();
+	_screenShader->SetUniformMatrix4fv(Uniforms.InversePV, 1, GL_FALSE, &inverse[0][0]);
+
+	_screen->Bind();
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+
+	// back faces behind the surface cover its pixels, even with the camera inside the volume
+	StateTracker::Enable(GL_BLEND);
+	StateTracker::BlendFunc(GL_ONE, GL_ONE);
+	StateTracker::DepthFunc(GL_GEQUAL);
+	StateTracker::DepthMask(GL_FALSE);
+	StateTracker::Enable(GL_CULL_FACE);
+	StateTracker::CullFace(GL_FRONT);
+
+	_volumeShader->Bind();
+	_volumeShader->SetUniformMatrix4fv(Uniforms.InversePV, 1, GL_FALSE, &inverse[0][0]);
+
+	// light list keeps point lights in front of spot lights
+	DrawVolume(_sphere, 0, lights.GetVisiblePoints(), false);
+	DrawVolume(_cone, lights.GetVisiblePoints(), lights.GetVisibleSpots(), true);
+
+	StateTracker::CullFace(GL_BACK);
+	StateTracker::Disable(GL_CULL_FACE);
+	StateTracker::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	StateTracker::Disable(GL_BLEND);
+	StateTracker::DepthFunc(GL_LESS);
+	StateTracker::DepthMask(GL_TRUE);
+}
+
+DeferredShading::Volume DeferredShading::CreateVolume(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices)
+{
+	Volume volume;
+	volume.VB = new VertexBuffer(vertices.data(), vertices.size() * sizeof(GLfloat));
+	volume.EB = new ElementBuffer(indices.data(), (GLuint)indices.size());
+
+	VertexBufferLayout layout;
+	layout.Push<GLfloat>(3);
+
+	volume.VAO = new VertexArray();
+	volume.VAO->AddBuffer(*volume.VB, layout);
+
+	return volume;
+}
+
+void DeferredShading::DrawVolume(const Volume& volume, size_t first, size_t count, bool spot)
+{
+	if (count == 0)
+		return;
+
+	_volumeShader->SetUniform1i(Uniforms.FirstLight, (GLint)first);
+	_volumeShader->SetUniform1i(Uniforms.Spot, spot ? 1 : 0);
+
+	volume.VAO->Bind();
+	volume.EB->Bind();
+
+	glDrawElementsInstanced(GL_TRIANGLES, volume.EB->GetCount(), volume.EB->GetType(), nullptr, (GLsizei)count);
+}
@@ -0,0 +1,160 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       DeferredShading.h
+ * \author     Dominik Pupala
+ * \date       2021/10/06
+ * \brief      Header file for deferred shading.
+ *
+ *  Header file containing definitions for DeferredShading class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+#include "pgr.h"
+#include "Shader.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "ElementBuffer.h"
+#include "RenderGraph.h"
+#include "LightClusters.h"
+
+/// Class that lights opaque geometry through G-buffer.
+/**
+  This class pairs forward shaders with geometry shaders writing albedo, specular color
+  with shininess, packed normal and ambient color of the nearest surface into G-buffer. Ambient light
+  and sunlight are applied by single screen pass, point and spot lights are drawn as
+  instanced spheres and cones, so each light only shades pixels inside its volume.
+  Visible lights are read from the buffer texture of the light list,
+  their cost grows with covered pixels, not with drawn objects.
+  Shaders without pair and blended draws keep the forward path.
+*/
+class DeferredShading
+{
+public:
+	static constexpr GLuint SPHERE_STACKS = 8; ///< Rings of the point light volume
+	static constexpr GLuint VOLUME_SLICES = 12; ///< Segments around the light volumes
+
+	static constexpr GLenum ALBEDO_FORMAT = GL_RGBA8; ///< Diffuse color
+	static constexpr GLenum SPECULAR_FORMAT = GL_RGBA8; ///< Specular color and shininess
+	static constexpr GLenum NORMAL_FORMAT = GL_RGBA8; ///< Octahedral normal, two bytes per component
+	static constexpr GLenum AMBIENT_FORMAT = GL_RGBA8; ///< Ambient color of the material
+	static constexpr GLenum DEPTH_FORMAT = GL_DEPTH_COMPONENT24; ///< Depth of the nearest surface
+
+private:
+	/// Struct that contains mesh of light volume.
+	struct Volume
+	{
+		VertexArray* VAO = nullptr; ///< Vertex array
+		VertexBuffer* VB = nullptr; ///< Unit positions
+		ElementBuffer* EB = nullptr; ///< Faces
+	};
+
+	std::unordered_map<const Shader*, Shader*> _shaders; ///< Geometry shaders by forward shader
+	Shader* _screenShader; ///< Ambient light and sunlight
+	Shader* _volumeShader; ///< Point and spot lights
+
+	VertexArray* _screen; ///< Empty vertex array of the screen triangle
+	Volume _sphere; ///< Point light volume
+	Volume _cone; ///< Spot light volume
+
+	bool _enabled; ///< Deferred path is drawn
+
+public:
+	/// Constructor
+	/**
+		Creates meshes of the light volumes, path starts enabled.
+
+		\param[in] screenShader		Shader of the screen pass.
+		\param[in] volumeShader		Shader of the light volumes.
+	*/
+	DeferredShading(Shader& screenShader, Shader& volumeShader);
+	/// Destructor
+	/**
+		Deletes meshes of the light volumes.
+	*/
+	~DeferredShading();
+	/// Add shader.
+	/**
+		Pairs the forward shader with geometry shader computing the same positions.
+
+		\param[in] shader		Forward shader.
+		\param[in] geometry		Geometry shader.
+	*/
+	void AddShader(const Shader& shader, Shader& geometry);
+	/// Geometry shader getter.
+	/**
+		Returns geometry shader paired with the forward shader, null if there is none.
+
+		\param[in] shader	Forward shader.
+	*/
+	Shader* GetShader(const Shader& shader) const;
+	/// Add passes.
+	/**
+		Declares G-buffer of the screen size, geometry pass filling it and lighting pass
+		drawing lit surfaces with their depth onto the screen.
+
+		\param[in,out] graph	Graph of the frame.
+		\param[in] projection	Global projection matrix.
+		\param[in] view			Global view matrix.
+		\param[in] lights		Light list assigned for the frame.
+		\param[in] geometry		Draws paired opaque geometry with geometry shaders.
+	*/
+	void AddPasses(RenderGraph& graph, const glm::mat4& projection, const glm::mat4& view, const LightClusters& lights, std::function<void()> geometry);
+	/// Enabled setter.
+	/**
+		Switches between deferred and forward path.
+
+		\param[in] enabled	Deferred path is drawn.
+	*/
+	inline void SetEnabled(bool enabled) { _enabled = enabled; }
+	/// Enabled getter.
+	/**
+		Returns true if the deferred path is drawn.
+	*/
+	inline bool IsEnabled() const { return _enabled; }
+	/// Report statistics.
+	/**
+		Prints whether the deferred path is drawn.
+	*/
+	void Report() const;
+
+private:
+	/// Shade surfaces.
+	/**
+		Draws ambient light and sunlight over the screen and adds light volumes
+		of the visible lights.
+
+		\param[in] albedo		Albedo texture.
+		\param[in] specular		Specular texture.
+		\param[in] normal		Normal texture.
+		\param[in] ambient		Ambient texture.
+		\param[in] depth		Depth texture.
+		\param[in] pv			Projection and view matrix.
+		\param[in] lights		Light list assigned for the frame.
+	*/
+	void Shade(GLuint albedo, GLuint specular, GLuint normal, GLuint ambient, GLuint depth, const glm::mat4& pv, const LightClusters& lights);
+	/// Create volume.
+	/**
+		Uploads positions and faces of light volume.
+
+		\param[in] vertices		Positions, three floats per vertex.
+		\param[in] indices		Faces, front ones wound counterclockwise.
+	*/
+	static Volume CreateVolume(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices);
+	/// Draw volume.
+	/**
+		Draws instances of the volume, one per light.
+
+		\param[in] volume	Drawn volume.
+		\param[in] first	First light in the buffer.
+		\param[in] count	Number of lights.
+		\param[in] spot		Lights are spot lights.
+	*/
+	void DrawVolume(const Volume& volume, size_t first, size_t count, bool spot);
+};
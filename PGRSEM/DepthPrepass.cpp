@@ -0,0 +1,128 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       DepthPrepass.cpp
+ * \author     Dominik Pupala
+ * \date       2021/08/06
+ * \brief      Source file for depth pre-pass.
+ *
+ *  Source file containing declarations for DepthPrepass class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "DepthPrepass.h"
+#include "StateTracker.h"
+
+#include <iostream>
+
+DepthPrepass::DepthPrepass()
+	: _mode(PrepassMode::AUTO), _active(false), _next(0), _measuring(false), _overdraw(0.0f)
+{
+	glGenQueries(QUERIES, _queries);
+
+	for (size_t i = 0; i < QUERIES; ++i)
+	{
+		_pixels[i] = 0;
+		_pending[i] = false;
+	}
+}
+
+DepthPrepass::~DepthPrepass()
+{
+	glDeleteQueries(QUERIES, _queries);
+}
+
+void DepthPrepass::AddShader(const Shader& shader, Shader& depth)
+{
+	_shaders[&shader] = &depth;
+}
+
+Shader* DepthPrepass::GetShader(const Shader& shader) const
+{
+	auto found = _shaders.find(&shader);
+
+	return found != _shaders.end() ? found->second : nullptr;
+}
+
+void DepthPrepass::Update()
+{
+	// oldest query is read first, so the last read one is the newest measurement
+	for (size_t k = 0; k < QUERIES; ++k)
+	{
+		size_t i = (_next + k) % QUERIES;
+
+		if (!_pending[i])
+			continue;
+
+		GLuint available = 0;
+		glGetQueryObjectuiv(_queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+
+		if (!available)
+			break;
+
+		GLuint samples = 0;
+		glGetQueryObjectuiv(_queries[i], GL_QUERY_RESULT, &samples);
+
+		_pending[i] = false;
+		_overdraw = _pixels[i] > 0 ? (GLfloat)samples / _pixels[i] : 0.0f;
+	}
+
+	// thresholds apart keep the pass from flipping every frame
+	if (_mode == PrepassMode::AUTO)
+	{
+		if (!_active && _overdraw > ENABLE_OVERDRAW)
+			_active = true;
+		else if (_active && _overdraw < DISABLE_OVERDRAW)
+			_active = false;
+	}
+}
+
+void DepthPrepass::BeginMeasure(GLsizei pixels)
+{
+	// all queries in flight, this frame goes unmeasured
+	_measuring = !_pending[_next];
+
+	if (!_measuring)
+		return;
+
+	_pixels[_next] = pixels;
+	glBeginQuery(GL_SAMPLES_PASSED, _queries[_next]);
+}
+
+void DepthPrepass::EndMeasure()
+{
+	if (!_measuring)
+		return;
+
+	glEndQuery(GL_SAMPLES_PASSED);
+
+	_pending[_next] = true;
+	_next = (_next + 1) % QUERIES;
+	_measuring = false;
+}
+
+void DepthPrepass::BeginPass() const
+{
+	StateTracker::ColorMask(GL_FALSE);
+}
+
+void DepthPrepass::EndPass() const
+{
+	StateTracker::ColorMask(GL_TRUE);
+}
+
+void DepthPrepass::SetMode(PrepassMode mode)
+{
+	_mode = mode;
+
+	if (_mode != PrepassMode::AUTO)
+		_active = _mode == PrepassMode::ON;
+}
+
+void DepthPrepass::Report() const
+{
+	static const char* modes[] = { "auto", "on", "off" };
+
+	std::cout << "Depth pre-pass: " << modes[(int)_mode] << ", " << (_active ? "active" : "inactive")
+		<< ", overdraw " << _overdraw << std::endl;
+}
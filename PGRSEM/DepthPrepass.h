@@ -0,0 +1,128 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       DepthPrepass.h
+ * \author     Dominik Pupala
+ * \date       2021/08/06
+ * \brief      Header file for depth pre-pass.
+ *
+ *  Header file containing definitions for DepthPrepass class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <unordered_map>
+
+#include "pgr.h"
+#include "Shader.h"
+
+/// Mode of the depth pre-pass.
+enum class PrepassMode { AUTO, ON, OFF };
+
+/// Class that decides about depth pre-pass and measures overdraw.
+/**
+  This class pairs lighting shaders with position only depth shaders and measures
+  overdraw of opaque geometry by occlusion queries. Pre-pass lays down depth of the
+  paired draws, so their lighting pass only shades the nearest fragment of every pixel.
+  In automatic mode the pass switches on when overdraw grows above the threshold
+  and off again once it drops well below, queries are read frames later without waiting.
+*/
+class DepthPrepass
+{
+public:
+	static constexpr GLfloat ENABLE_OVERDRAW = 1.6f; ///< Overdraw switching the pass on
+	static constexpr GLfloat DISABLE_OVERDRAW = 1.3f; ///< Overdraw switching the pass off
+	static constexpr size_t QUERIES = 4; ///< Queries in flight
+
+private:
+	std::unordered_map<const Shader*, Shader*> _shaders; ///< Depth shaders by lighting shader
+
+	PrepassMode _mode; ///< Selected mode
+	bool _active; ///< Pre-pass is drawn this frame
+
+	GLuint _queries[QUERIES]; ///< Occlusion queries
+	GLsizei _pixels[QUERIES]; ///< Screen size the queries were issued with
+	bool _pending[QUERIES]; ///< Query waits for its result
+	size_t _next; ///< Query of the next measurement
+	bool _measuring; ///< Measurement of this frame runs
+
+	GLfloat _overdraw; ///< Last measured overdraw
+
+public:
+	/// Constructor
+	/**
+		Creates queries, pre-pass starts in automatic mode switched off.
+	*/
+	DepthPrepass();
+	/// Destructor
+	/**
+		Deletes queries.
+	*/
+	~DepthPrepass();
+	/// Add shader.
+	/**
+		Pairs the lighting shader with depth shader computing the same positions.
+
+		\param[in] shader	Lighting shader.
+		\param[in] depth	Depth shader.
+	*/
+	void AddShader(const Shader& shader, Shader& depth);
+	/// Depth shader getter.
+	/**
+		Returns depth shader paired with the lighting shader, null if there is none.
+
+		\param[in] shader	Lighting shader.
+	*/
+	Shader* GetShader(const Shader& shader) const;
+	/// Update pass.
+	/**
+		Reads finished measurements and switches the pass in automatic mode.
+		Has to be called before the passes of the frame are decided.
+	*/
+	void Update();
+	/// Begin measurement.
+	/**
+		Starts counting fragments of the first opaque pass of the frame.
+
+		\param[in] pixels	Number of pixels of the screen.
+	*/
+	void BeginMeasure(GLsizei pixels);
+	/// End measurement.
+	/**
+		Stops counting fragments.
+	*/
+	void EndMeasure();
+	/// Begin pass.
+	/**
+		Disables color writes, pre-pass only fills the depth buffer.
+	*/
+	void BeginPass() const;
+	/// End pass.
+	/**
+		Enables color writes again.
+	*/
+	void EndPass() const;
+	/// Mode setter.
+	/**
+		Selects mode of the pass.
+
+		\param[in] mode		Selected mode.
+	*/
+	void SetMode(PrepassMode mode);
+	/// Mode getter.
+	/**
+		Returns selected mode.
+	*/
+	inline PrepassMode GetMode() const { return _mode; }
+	/// Active getter.
+	/**
+		Returns true if the pre-pass is drawn this frame.
+	*/
+	inline bool IsActive() const { return _active; }
+	/// Report statistics.
+	/**
+		Prints mode and the last measured overdraw.
+	*/
+	void Report() const;
+};
@@ -12,26 +12,37 @@
 //----------------------------------------------------------------------------------------
 
 #include "ElementBuffer.h"
+#include "StateTracker.h"
+#include "VertexBufferLayout.h"
 
-ElementBuffer::ElementBuffer(const GLuint* data, GLuint count) 
-	: _count(count)
+ElementBuffer::ElementBuffer(const GLvoid* data, GLuint count, GLenum type) 
+	: _count(count), _type(type)
 {
 	glGenBuffers(1, &_rendererID);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _rendererID);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(GLuint), data, GL_STATIC_DRAW);
+	StateTracker::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, _rendererID);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * VertexBufferElement::GetSizeOfType(type), data, GL_STATIC_DRAW);
 }
 
 ElementBuffer::~ElementBuffer()
 {
-	glDeleteBuffers(1, &_rendererID);
+	StateTracker::DeleteBuffer(_rendererID);
+}
+
+void ElementBuffer::SetData(const GLvoid* data, GLuint count, GLuint first)
+{
+	GLuint size = VertexBufferElement::GetSizeOfType(_type);
+
+	// element array binding would change the bound vertex array
+	StateTracker::BindBuffer(GL_COPY_WRITE_BUFFER, _rendererID);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, (GLintptr)first * size, (GLsizeiptr)count * size, data);
 }
 
 void ElementBuffer::Bind() const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _rendererID);
+	StateTracker::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, _rendererID);
 }
 
 void ElementBuffer::Unbind() const
 {
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	StateTracker::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -25,6 +25,7 @@ class ElementBuffer
 private:
 	GLuint _rendererID; ///< OpenGL ID handle
 	GLuint _count; ///< Count of indices
+	GLenum _type; ///< Datatype of indices
 
 public:
 	/// Constructor
@@ -34,13 +35,23 @@ public:
 
 		\param[in] data		Collection of indices.
 		\param[in] count	Count of indices in collection.
+		\param[in] type		Datatype of indices, GL_UNSIGNED_INT or GL_UNSIGNED_SHORT.
 	*/
-	ElementBuffer(const GLuint* data, GLuint count);
+	ElementBuffer(const GLvoid* data, GLuint count, GLenum type = GL_UNSIGNED_INT);
 	/// Destructor
 	/**
 		Deletes the OpenGL element array buffer object.
 	*/
 	~ElementBuffer();
+	/// Set data.
+	/**
+		Replaces part of the buffer content, bound vertex array is left untouched.
+
+		\param[in] data		Collection of indices.
+		\param[in] count	Count of indices in collection.
+		\param[in] first	Offset of the first replaced index.
+	*/
+	void SetData(const GLvoid* data, GLuint count, GLuint first);
 	/// Bind buffer.
 	/**
 		Binds the buffer to the OpenGL context.
@@ -56,5 +67,15 @@ public:
 		Returns count of indices in the buffer.
 	*/
 	inline GLuint GetCount() const { return _count; }
+	/// Index datatype getter.
+	/**
+		Returns datatype of indices in the buffer.
+	*/
+	inline GLenum GetType() const { return _type; }
+	/// OpenGL name getter.
+	/**
+		Returns OpenGL name of the buffer.
+	*/
+	inline GLuint GetID() const { return _rendererID; }
 };
 
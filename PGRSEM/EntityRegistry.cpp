@@ -0,0 +1,89 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       EntityRegistry.cpp
+ * \author     Dominik Pupala
+ * \date       2021/28/05
+ * \brief      Source file for scene entity registry.
+ *
+ *  Source file containing declarations for EntityRegistry class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "EntityRegistry.h"
+
+EntityRegistry::Entity EntityRegistry::Create(const std::string& name, Shader* shader, GLuint flags)
+{
+	Transforms.push_back(glm::mat4(1.0f));
+	Meshes.push_back(nullptr);
+	Materials.push_back(MaterialData());
+	Flags.push_back(flags);
+	Lods.push_back(0);
+	Shaders.push_back(shader);
+	Effects.push_back(Effect::NONE);
+	PickIds.push_back(0);
+
+	Names.push_back(name);
+
+	return Transforms.size() - 1;
+}
+
+void EntityRegistry::Reserve(size_t count)
+{
+	Transforms.reserve(count);
+	Meshes.reserve(count);
+	Materials.reserve(count);
+	Flags.reserve(count);
+	Lods.reserve(count);
+	Shaders.reserve(count);
+	Effects.reserve(count);
+	PickIds.reserve(count);
+
+	Names.reserve(count);
+}
+
+void EntityRegistry::UpdateHierarchy()
+{
+	size_t placed = 0;
+	bool changed = false;
+
+	// nothing moved, appeared or vanished since the last build
+	for (Entity i = 0; i < GetCount() && !changed; ++i)
+	{
+		if (!Meshes[i] || !Meshes[i]->Collision || !(Flags[i] & FLAG_VISIBLE))
+			continue;
+
+		changed = placed == _placedEntities.size() || _placedEntities[placed] != i
+			|| _placedTransforms[placed] != Transforms[i] || _placedMeshes[placed] != Meshes[i]->Collision.get();
+
+		++placed;
+	}
+
+	if (!changed && placed == _placedEntities.size())
+		return;
+
+	_hierarchy.Clear();
+	_placedEntities.clear();
+	_placedTransforms.clear();
+	_placedMeshes.clear();
+
+	for (Entity i = 0; i < GetCount(); ++i)
+	{
+		if (!Meshes[i] || !Meshes[i]->Collision || !(Flags[i] & FLAG_VISIBLE))
+			continue;
+
+		_hierarchy.Add(i, Transforms[i], Meshes[i]->Collision);
+		_placedEntities.push_back(i);
+		_placedTransforms.push_back(Transforms[i]);
+		_placedMeshes.push_back(Meshes[i]->Collision.get());
+	}
+
+	_hierarchy.Build();
+}
+
+void EntityRegistry::SetMesh(Entity entity, const MeshData& object)
+{
+	Meshes[entity] = object.Mesh;
+	Materials[entity] = object;
+	Lods[entity] = 0;
+}
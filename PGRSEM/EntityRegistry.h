@@ -0,0 +1,133 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       EntityRegistry.h
+ * \author     Dominik Pupala
+ * \date       2021/28/05
+ * \brief      Header file for scene entity registry.
+ *
+ *  Header file containing definitions for EntityRegistry class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "BVH.h"
+#include "Shader.h"
+#include "MeshData.h"
+
+/// Class that stores scene entities.
+/**
+  This class contains all drawable entities of the scene in structure of arrays layout.
+  Every attribute lives in its own contiguous array indexed by the entity, so loops
+  walk only the attributes they need. Entities are never removed, handles stay valid.
+  Meshes with kept triangles are gathered into hierarchy for ray queries.
+*/
+class EntityRegistry
+{
+public:
+	typedef size_t Entity; ///< Index of the entity in all arrays
+
+	static constexpr Entity NONE = (Entity)-1; ///< No entity
+
+	static constexpr GLuint FLAG_VISIBLE = 1; ///< Entity is drawn
+	static constexpr GLuint FLAG_ANIMATED = 2; ///< Shader effect of the entity runs
+	static constexpr GLuint FLAG_ADDITIVE = 4; ///< Entity is blended additively
+	static constexpr GLuint FLAG_TRANSPARENT = 8; ///< Entity is blended by its alpha
+	static constexpr GLuint FLAG_SOLID = 16; ///< Entity blocks moving bodies
+
+	/// Shader effects.
+	enum class Effect { NONE, PULSE, SCROLL };
+
+	// Hot data, read by the draw loop every frame
+	std::vector<glm::mat4> Transforms; ///< Model matrices
+	std::vector<std::shared_ptr<MeshResource>> Meshes; ///< Shared meshes, empty until loaded
+	std::vector<MaterialData> Materials; ///< Materials overriding the first part of the mesh
+	std::vector<GLuint> Flags; ///< Entity flags
+	std::vector<size_t> Lods; ///< Levels of detail drawn last frame
+	std::vector<Shader*> Shaders; ///< Shader programs
+	std::vector<Effect> Effects; ///< Shader effects
+	std::vector<GLuint> PickIds; ///< Values returned by picking, zero if not pickable
+
+	// Cold data
+	std::vector<std::string> Names; ///< Entity names used in reports
+
+private:
+	SceneBVH _hierarchy; ///< Visible entities as of the last update
+
+	// Entities the hierarchy was built from
+	std::vector<Entity> _placedEntities; ///< Gathered entities
+	std::vector<glm::mat4> _placedTransforms; ///< Their transforms
+	std::vector<const MeshBVH*> _placedMeshes; ///< Their kept triangles
+
+public:
+	/// Create entity.
+	/**
+		Appends entity with identity transform, default material and no mesh.
+
+		\param[in] name		Entity name.
+		\param[in] shader	Shader program.
+		\param[in] flags	Entity flags.
+	*/
+	Entity Create(const std::string& name, Shader* shader, GLuint flags = FLAG_VISIBLE);
+	/// Reserve entities.
+	/**
+		Reserves space in all arrays, so creating entities doesn't reallocate.
+
+		\param[in] count	Expected number of entities.
+	*/
+	void Reserve(size_t count);
+	/// Entity count getter.
+	/**
+		Returns number of entities.
+	*/
+	inline size_t GetCount() const { return Transforms.size(); }
+	/// Set mesh.
+	/**
+		Assigns uploaded mesh to the entity and resets its material to the default one.
+
+		\param[in] entity	Target entity.
+		\param[in] object	Uploaded object.
+	*/
+	void SetMesh(Entity entity, const MeshData& object);
+	/// Toggle flag.
+	/**
+		Toggles flags of the entity.
+
+		\param[in] entity	Target entity.
+		\param[in] flags	Toggled flags.
+	*/
+	inline void Toggle(Entity entity, GLuint flags) { Flags[entity] ^= flags; }
+	/// Flag validator.
+	/**
+		Returns true if the entity has all given flags.
+
+		\param[in] entity	Target entity.
+		\param[in] flags	Tested flags.
+	*/
+	inline bool Has(Entity entity, GLuint flags) const { return (Flags[entity] & flags) == flags; }
+	/// Update hierarchy.
+	/**
+		Gathers visible entities with kept triangles at their current transforms.
+		Has to be called after entities move, ray queries see the last update.
+		The hierarchy is only rebuilt if some of the gathered entities changed.
+	*/
+	void UpdateHierarchy();
+	/// Ray query.
+	/**
+		Returns the closest entity hit by the ray.
+
+		\param[in] origin		Origin of the ray.
+		\param[in] direction	Normalized direction of the ray.
+		\param[in] distance		Length of the ray.
+		\param[in] ignore		Entity skipped by the ray.
+	*/
+	inline RayHit Raycast(const glm::vec3& origin, const glm::vec3& direction, GLfloat distance = std::numeric_limits<GLfloat>::max(), Entity ignore = NONE) const
+	{
+		return _hierarchy.Raycast(origin, direction, distance, ignore);
+	}
+};
@@ -0,0 +1,129 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       FrustumCuller.cpp
+ * \author     Dominik Pupala
+ * \date       2021/03/06
+ * \brief      Source file for view frustum culler.
+ *
+ *  Source file containing declarations for FrustumCuller class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "FrustumCuller.h"
+#include "BoundingBox.h"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define CULL_SSE
+#endif
+
+void FrustumCuller::Clear()
+{
+	for (auto* component : { &_centerX, &_centerY, &_centerZ, &_extentX, &_extentY, &_extentZ, &_sphereX, &_sphereY, &_sphereZ, &_radius })
+		component->clear();
+}
+
+size_t FrustumCuller::Add(const glm::mat4& model, const glm::vec3& lower, const glm::vec3& upper, const glm::vec3& center, GLfloat radius)
+{
+	glm::vec3 boxCenter, extent;
+	BoundingBox::Transform(model, lower, upper, boxCenter, extent);
+
+	glm::mat3 axes = glm::mat3(model);
+	glm::vec3 sphere = glm::vec3(model * glm::vec4(center, 1.0f));
+	GLfloat scale = std::max(glm::length(axes[0]), std::max(glm::length(axes[1]), glm::length(axes[2])));
+
+	_centerX.push_back(boxCenter.x);
+	_centerY.push_back(boxCenter.y);
+	_centerZ.push_back(boxCenter.z);
+	_extentX.push_back(extent.x);
+	_extentY.push_back(extent.y);
+	_extentZ.push_back(extent.z);
+	_sphereX.push_back(sphere.x);
+	_sphereY.push_back(sphere.y);
+	_sphereZ.push_back(sphere.z);
+	_radius.push_back(radius * scale);
+
+	return _radius.size() - 1;
+}
+
+void FrustumCuller::Cull(const Frustum& frustum)
+{
+	size_t count = _radius.size();
+	size_t i = 0;
+
+	_visible.assign(count, 1);
+
+#ifdef CULL_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 sign = _mm_set1_ps(-0.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&_centerX[i]);
+		__m128 cy = _mm_loadu_ps(&_centerY[i]);
+		__m128 cz = _mm_loadu_ps(&_centerZ[i]);
+		__m128 ex = _mm_loadu_ps(&_extentX[i]);
+		__m128 ey = _mm_loadu_ps(&_extentY[i]);
+		__m128 ez = _mm_loadu_ps(&_extentZ[i]);
+		__m128 sx = _mm_loadu_ps(&_sphereX[i]);
+		__m128 sy = _mm_loadu_ps(&_sphereY[i]);
+		__m128 sz = _mm_loadu_ps(&_sphereZ[i]);
+		__m128 r = _mm_loadu_ps(&_radius[i]);
+
+		__m128 outside = zero;
+
+		for (const glm::vec4& plane : frustum.Planes)
+		{
+			__m128 nx = _mm_set1_ps(plane.x);
+			__m128 ny = _mm_set1_ps(plane.y);
+			__m128 nz = _mm_set1_ps(plane.z);
+			__m128 nw = _mm_set1_ps(plane.w);
+
+			// box reaches along the normal as far as its extents projected on absolute normal
+			__m128 boxDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, cx), _mm_mul_ps(ny, cy)), _mm_add_ps(_mm_mul_ps(nz, cz), nw));
+			__m128 boxReach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, nx), ex), _mm_mul_ps(_mm_andnot_ps(sign, ny), ey)), _mm_mul_ps(_mm_andnot_ps(sign, nz), ez));
+			__m128 sphereDistance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, sx), _mm_mul_ps(ny, sy)), _mm_add_ps(_mm_mul_ps(nz, sz), nw));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(boxDistance, boxReach), zero));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(sphereDistance, r), zero));
+		}
+
+		int mask = _mm_movemask_ps(outside);
+
+		for (size_t k = 0; k < 4; ++k)
+			_visible[i + k] = (mask >> k & 1) ? 0 : 1;
+	}
+#endif
+
+	// remainder of the last group, or all volumes without SSE
+	for (; i < count; ++i)
+	{
+		for (const glm::vec4& plane : frustum.Planes)
+		{
+			GLfloat boxDistance = plane.x * _centerX[i] + plane.y * _centerY[i] + plane.z * _centerZ[i] + plane.w;
+			GLfloat boxReach = std::fabs(plane.x) * _extentX[i] + std::fabs(plane.y) * _extentY[i] + std::fabs(plane.z) * _extentZ[i];
+			GLfloat sphereDistance = plane.x * _sphereX[i] + plane.y * _sphereY[i] + plane.z * _sphereZ[i] + plane.w;
+
+			if (boxDistance + boxReach < 0.0f || sphereDistance + _radius[i] < 0.0f)
+			{
+				_visible[i] = 0;
+				break;
+			}
+		}
+	}
+
+	_stats.Tested = count;
+	_stats.Visible = std::count(_visible.begin(), _visible.end(), (GLubyte)1);
+	_stats.Culled = count - _stats.Visible;
+}
+
+void FrustumCuller::Report(const std::string& name) const
+{
+	std::cout << "Culling " << name << ": " << _stats.Tested << " tested, "
+		<< _stats.Visible << " visible, " << _stats.Culled << " culled" << std::endl;
+}
@@ -0,0 +1,101 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       FrustumCuller.h
+ * \author     Dominik Pupala
+ * \date       2021/03/06
+ * \brief      Header file for view frustum culler.
+ *
+ *  Header file containing definitions for FrustumCuller class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+#include "Camera.h"
+
+/// Struct that contains statistics of single culling pass.
+/**
+	This struct contains number of tested, visible and culled volumes.
+*/
+struct CullStats
+{
+	size_t Tested = 0; ///< Tested volumes
+	size_t Visible = 0; ///< Volumes intersecting the frustum
+	size_t Culled = 0; ///< Volumes outside the frustum
+};
+
+/// Class that culls bounding volumes against view frustum.
+/**
+  This class collects world space bounding volumes of one frame and tests them
+  all in single pass. Volumes are stored in structure of arrays layout, so four
+  of them are tested against a plane at once. Every volume is a box and a sphere,
+  it's culled if either of them lies outside any plane.
+*/
+class FrustumCuller
+{
+private:
+	// World space volumes, one component per array
+	std::vector<GLfloat> _centerX; ///< Box center, x component
+	std::vector<GLfloat> _centerY; ///< Box center, y component
+	std::vector<GLfloat> _centerZ; ///< Box center, z component
+	std::vector<GLfloat> _extentX; ///< Box half size, x component
+	std::vector<GLfloat> _extentY; ///< Box half size, y component
+	std::vector<GLfloat> _extentZ; ///< Box half size, z component
+	std::vector<GLfloat> _sphereX; ///< Sphere center, x component
+	std::vector<GLfloat> _sphereY; ///< Sphere center, y component
+	std::vector<GLfloat> _sphereZ; ///< Sphere center, z component
+	std::vector<GLfloat> _radius; ///< Sphere radius
+
+	std::vector<GLubyte> _visible; ///< Results of the last pass
+
+	CullStats _stats; ///< Statistics of the last pass
+
+public:
+	/// Clear volumes.
+	/**
+		Removes all volumes, the memory is kept for the next frame.
+	*/
+	void Clear();
+	/// Add volume.
+	/**
+		Transforms bounds of the mesh into world space and returns index of the volume.
+
+		\param[in] model		Model matrix.
+		\param[in] lower		Lower corner of the bounding box.
+		\param[in] upper		Upper corner of the bounding box.
+		\param[in] center		Center of the bounding sphere.
+		\param[in] radius		Radius of the bounding sphere.
+	*/
+	size_t Add(const glm::mat4& model, const glm::vec3& lower, const glm::vec3& upper, const glm::vec3& center, GLfloat radius);
+	/// Cull volumes.
+	/**
+		Tests all volumes against the frustum.
+
+		\param[in] frustum		View frustum.
+	*/
+	void Cull(const Frustum& frustum);
+	/// Visibility getter.
+	/**
+		Returns true if the volume intersects the frustum in the last pass.
+
+		\param[in] index		Index of the volume.
+	*/
+	inline bool IsVisible(size_t index) const { return _visible[index] != 0; }
+	/// Statistics getter.
+	/**
+		Returns statistics of the last pass.
+	*/
+	inline const CullStats& GetStats() const { return _stats; }
+	/// Report statistics.
+	/**
+		Prints statistics of the last pass.
+
+		\param[in] name			Name of the culled volumes.
+	*/
+	void Report(const std::string& name) const;
+};
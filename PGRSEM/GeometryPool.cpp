@@ -0,0 +1,290 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       GeometryPool.cpp
+ * \author     Dominik Pupala
+ * \date       2021/01/06
+ * \brief      Source file for static geometry suballocator.
+ *
+ *  Source file containing declarations for GeometryPool class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "GeometryPool.h"
+#include "StateTracker.h"
+#include "ResourceRegistry.h"
+
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+bool GeometryPool::_running = false;
+std::vector<std::weak_ptr<GeometryPool::Arena>> GeometryPool::_arenas;
+
+size_t GeometryPool::_meshes = 0;
+size_t GeometryPool::_defragmentations = 0;
+size_t GeometryPool::_moved = 0;
+
+namespace
+{
+	/// Layout comparator.
+	/**
+		Returns true if both layouts describe the same vertices.
+
+		\param[in] a	First layout.
+		\param[in] b	Second layout.
+	*/
+	bool sameLayout(const VertexBufferLayout& a, const VertexBufferLayout& b)
+	{
+		const auto& ea = a.GetElements();
+		const auto& eb = b.GetElements();
+
+		if (a.GetStride() != b.GetStride() || a.GetDivisor() != b.GetDivisor() || ea.size() != eb.size())
+			return false;
+
+		for (size_t i = 0; i < ea.size(); ++i)
+			if (ea[i].Count != eb[i].Count || ea[i].Type != eb[i].Type || ea[i].Normalized != eb[i].Normalized)
+				return false;
+
+		return true;
+	}
+
+	/// Copy buffer range.
+	/**
+		Copies range between two buffers on the GPU.
+
+		\param[in] read			Source buffer.
+		\param[in] write		Destination buffer.
+		\param[in] readOffset	Offset in the source buffer.
+		\param[in] writeOffset	Offset in the destination buffer.
+		\param[in] size			Size of the range.
+	*/
+	void copyBuffer(GLuint read, GLuint write, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size)
+	{
+		StateTracker::BindBuffer(GL_COPY_READ_BUFFER, read);
+		StateTracker::BindBuffer(GL_COPY_WRITE_BUFFER, write);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, readOffset, writeOffset, size);
+	}
+}
+
+void GeometryPool::Shutdown()
+{
+	_running = false;
+	_arenas.clear();
+}
+
+bool GeometryPool::Allocate(const GLvoid* vertices, GLsizeiptr vertexSize, const GLvoid* indices, GLuint indexCount, GLenum indexType, const VertexBufferLayout& layout, MeshResource& outMesh)
+{
+	GLuint stride = layout.GetStride();
+	GLuint indexSize = VertexBufferElement::GetSizeOfType(indexType);
+
+	if (!_running || stride == 0 || indexSize == 0 || vertexSize % stride != 0)
+		return false;
+
+	GLuint vertexCount = (GLuint)(vertexSize / stride);
+	std::shared_ptr<Arena> arena;
+
+	for (auto it = _arenas.begin(); it != _arenas.end() && !arena;)
+	{
+		std::shared_ptr<Arena> candidate = it->lock();
+
+		if (!candidate)
+		{
+			it = _arenas.erase(it);
+			continue;
+		}
+
+		++it;
+
+		if (candidate->IndexType != indexType || !sameLayout(candidate->Layout, layout))
+			continue;
+
+		bool fits = candidate->VertexEnd + vertexCount <= candidate->VertexCapacity && candidate->IndexEnd + indexCount <= candidate->IndexCapacity;
+		bool fitsCompacted = candidate->VertexEnd - candidate->FreeVertices + vertexCount <= candidate->VertexCapacity
+			&& candidate->IndexEnd - candidate->FreeIndices + indexCount <= candidate->IndexCapacity;
+
+		// holes are compacted only if that makes room
+		if (!fits && fitsCompacted)
+			Defragment(*candidate);
+
+		if (fits || fitsCompacted)
+			arena = candidate;
+	}
+
+	if (!arena)
+	{
+		arena = std::make_shared<Arena>();
+		arena->Layout = layout;
+		arena->IndexType = indexType;
+
+		// meshes larger than the default arena get arena of their own
+		arena->VertexCapacity = std::max(vertexCount, (GLuint)(VERTEX_CAPACITY / stride));
+		arena->IndexCapacity = std::max(indexCount, (GLuint)(INDEX_CAPACITY / indexSize));
+
+		arena->VB = new VertexBuffer(nullptr, (GLsizeiptr)arena->VertexCapacity * stride);
+		arena->EB = new ElementBuffer(nullptr, arena->IndexCapacity, indexType);
+
+		arena->VAO = new VertexArray();
+		arena->VAO->AddBuffer(*arena->VB, arena->Layout);
+
+		_arenas.push_back(arena);
+	}
+
+	Arena::Block block;
+	block.Owner = &outMesh;
+	block.FirstVertex = arena->VertexEnd;
+	block.VertexCount = vertexCount;
+	block.FirstIndex = arena->IndexEnd;
+	block.IndexCount = indexCount;
+
+	arena->VB->SetData(vertices, vertexSize, (GLintptr)block.FirstVertex * stride);
+	arena->EB->SetData(indices, indexCount, block.FirstIndex);
+
+	arena->VertexEnd += vertexCount;
+	arena->IndexEnd += indexCount;
+	arena->Blocks.push_back(block);
+
+	outMesh.Arena = arena;
+	outMesh.VAO = arena->VAO;
+	outMesh.VB = arena->VB;
+	outMesh.EB = arena->EB;
+	outMesh.VBL = &arena->Layout;
+	outMesh.Size = vertexSize + (size_t)indexCount * indexSize;
+
+	outMesh.Submeshes.resize(1);
+	outMesh.Submeshes[0].First = block.FirstIndex;
+	outMesh.Submeshes[0].Count = indexCount;
+	outMesh.Submeshes[0].BaseVertex = (GLint)block.FirstVertex;
+
+	++_meshes;
+
+	return true;
+}
+
+void GeometryPool::Release(MeshResource& mesh)
+{
+	Arena& arena = *mesh.Arena;
+	auto found = std::find_if(arena.Blocks.begin(), arena.Blocks.end(), [&mesh](const Arena::Block& block) { return block.Owner == &mesh; });
+
+	if (found == arena.Blocks.end())
+		return;
+
+	arena.FreeVertices += found->VertexCount;
+	arena.FreeIndices += found->IndexCount;
+	arena.Blocks.erase(found);
+	--_meshes;
+
+	// holes at the end of the arena are reclaimed right away
+	GLuint vertexEnd = arena.Blocks.empty() ? 0 : arena.Blocks.back().FirstVertex + arena.Blocks.back().VertexCount;
+	GLuint indexEnd = arena.Blocks.empty() ? 0 : arena.Blocks.back().FirstIndex + arena.Blocks.back().IndexCount;
+
+	arena.FreeVertices -= arena.VertexEnd - vertexEnd;
+	arena.FreeIndices -= arena.IndexEnd - indexEnd;
+	arena.VertexEnd = vertexEnd;
+	arena.IndexEnd = indexEnd;
+
+	// meshes released during static destruction don't need compact arena
+	if (!_running)
+		return;
+
+	if (arena.FreeVertices > DEFRAGMENT_RATIO * arena.VertexEnd || arena.FreeIndices > DEFRAGMENT_RATIO * arena.IndexEnd)
+		Defragment(arena);
+}
+
+void GeometryPool::Defragment(Arena& arena)
+{
+	if (arena.FreeVertices == 0 && arena.FreeIndices == 0)
+		return;
+
+	GLuint stride = arena.Layout.GetStride();
+	GLuint indexSize = VertexBufferElement::GetSizeOfType(arena.IndexType);
+
+	GLsizeiptr vertexBytes = (GLsizeiptr)(arena.VertexEnd - arena.FreeVertices) * stride;
+	GLsizeiptr indexBytes = (GLsizeiptr)(arena.IndexEnd - arena.FreeIndices) * indexSize;
+
+	// copied ranges of single buffer can't overlap, live ranges go through scratch buffer
+	GLuint scratch;
+	glGenBuffers(1, &scratch);
+	StateTracker::BindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+	glBufferData(GL_COPY_WRITE_BUFFER, std::max(vertexBytes, indexBytes), nullptr, GL_STREAM_COPY);
+
+	GLuint vertex = 0;
+
+	for (const Arena::Block& block : arena.Blocks)
+	{
+		copyBuffer(arena.VB->GetID(), scratch, (GLintptr)block.FirstVertex * stride, (GLintptr)vertex * stride, (GLsizeiptr)block.VertexCount * stride);
+		vertex += block.VertexCount;
+	}
+
+	copyBuffer(scratch, arena.VB->GetID(), 0, 0, vertexBytes);
+
+	GLuint index = 0;
+
+	for (const Arena::Block& block : arena.Blocks)
+	{
+		copyBuffer(arena.EB->GetID(), scratch, (GLintptr)block.FirstIndex * indexSize, (GLintptr)index * indexSize, (GLsizeiptr)block.IndexCount * indexSize);
+		index += block.IndexCount;
+	}
+
+	copyBuffer(scratch, arena.EB->GetID(), 0, 0, indexBytes);
+
+	StateTracker::DeleteBuffer(scratch);
+
+	vertex = 0;
+	index = 0;
+
+	for (Arena::Block& block : arena.Blocks)
+	{
+		Relocate(*block.Owner, (GLint)vertex - (GLint)block.FirstVertex, (GLint)index - (GLint)block.FirstIndex);
+
+		block.FirstVertex = vertex;
+		block.FirstIndex = index;
+		vertex += block.VertexCount;
+		index += block.IndexCount;
+	}
+
+	arena.VertexEnd = vertex;
+	arena.IndexEnd = index;
+	arena.FreeVertices = 0;
+	arena.FreeIndices = 0;
+
+	++_defragmentations;
+	_moved += vertexBytes + indexBytes;
+}
+
+void GeometryPool::Report()
+{
+	size_t count = 0, used = 0, capacity = 0;
+
+	for (const auto& weak : _arenas)
+	{
+		std::shared_ptr<Arena> arena = weak.lock();
+
+		if (!arena)
+			continue;
+
+		GLuint stride = arena->Layout.GetStride();
+		GLuint indexSize = VertexBufferElement::GetSizeOfType(arena->IndexType);
+
+		++count;
+		used += (size_t)(arena->VertexEnd - arena->FreeVertices) * stride + (size_t)(arena->IndexEnd - arena->FreeIndices) * indexSize;
+		capacity += (size_t)arena->VertexCapacity * stride + (size_t)arena->IndexCapacity * indexSize;
+	}
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< "Geometry pool: " << _meshes << " meshes in " << count << " arenas, "
+		<< used / 1024.0 << " of " << capacity / 1024.0 << " KB used, "
+		<< _defragmentations << " compactions (" << _moved / 1024.0 << " KB moved)" << std::endl;
+}
+
+void GeometryPool::Relocate(MeshResource& mesh, GLint vertexDelta, GLint indexDelta)
+{
+	for (Submesh& submesh : mesh.Submeshes)
+	{
+		submesh.First += indexDelta;
+		submesh.BaseVertex += vertexDelta;
+
+		for (IndexRange& range : submesh.Lods)
+			range.First += indexDelta;
+	}
+}
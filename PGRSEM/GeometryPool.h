@@ -0,0 +1,159 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       GeometryPool.h
+ * \author     Dominik Pupala
+ * \date       2021/01/06
+ * \brief      Header file for static geometry suballocator.
+ *
+ *  Header file containing definitions for GeometryPool class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "pgr.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "ElementBuffer.h"
+#include "VertexBufferLayout.h"
+
+struct MeshResource;
+
+/// Static class that packs static meshes into shared buffers.
+/**
+  This static class hands out ranges of few large vertex and index buffers.
+  Meshes with the same vertex layout and index type share single arena with one
+  vertex array, their parts are drawn with base vertex. Ranges are appended to
+  the end of the arena, released ones leave holes that are compacted once they
+  waste enough space. Compaction keeps the OpenGL names, so vertex arrays built
+  over the arena buffers elsewhere stay valid.
+*/
+class GeometryPool
+{
+public:
+	static constexpr GLsizeiptr VERTEX_CAPACITY = 8 << 20; ///< Bytes of vertex buffer of single arena
+	static constexpr GLsizeiptr INDEX_CAPACITY = 4 << 20; ///< Bytes of index buffer of single arena
+	static constexpr GLfloat DEFRAGMENT_RATIO = 0.25f; ///< Wasted part of the arena that triggers compaction
+
+	/// Struct that contains shared buffers.
+	/**
+		This struct owns buffers of single arena, it's released with the last mesh in it.
+	*/
+	struct Arena
+	{
+		/// Struct that contains ranges of single mesh.
+		struct Block
+		{
+			MeshResource* Owner = nullptr; ///< Mesh drawn from the ranges
+			GLuint FirstVertex = 0; ///< Offset of the first vertex
+			GLuint VertexCount = 0; ///< Number of vertices
+			GLuint FirstIndex = 0; ///< Offset of the first index
+			GLuint IndexCount = 0; ///< Number of indices
+		};
+
+		VertexBufferLayout Layout; ///< Layout of all vertices
+		GLenum IndexType = GL_UNSIGNED_INT; ///< Datatype of all indices
+
+		GLuint VertexCapacity = 0; ///< Size of vertex buffer in vertices
+		GLuint IndexCapacity = 0; ///< Size of index buffer in indices
+		GLuint VertexEnd = 0; ///< End of the last vertex range
+		GLuint IndexEnd = 0; ///< End of the last index range
+		GLuint FreeVertices = 0; ///< Vertices in holes
+		GLuint FreeIndices = 0; ///< Indices in holes
+
+		// OpenGL context
+		VertexArray* VAO = nullptr;
+		VertexBuffer* VB = nullptr;
+		ElementBuffer* EB = nullptr;
+
+		std::vector<Block> Blocks; ///< Live ranges ordered by offset
+
+		/// Destructor
+		/**
+			Deletes allocated memory.
+		*/
+		inline ~Arena()
+		{
+			delete VAO;
+			delete VB;
+			delete EB;
+		}
+	};
+
+private:
+	static bool _running; ///< Pool accepts meshes, stays valid during static destruction
+	static std::vector<std::weak_ptr<Arena>> _arenas; ///< Arenas with live meshes
+
+	static size_t _meshes; ///< Number of pooled meshes
+	static size_t _defragmentations; ///< Number of compactions
+	static size_t _moved; ///< Bytes moved by compactions
+
+public:
+	/// Initialize pool.
+	/**
+		Starts accepting meshes.
+	*/
+	static void Initialize() { _running = true; }
+	/// Shutdown pool.
+	/**
+		Stops accepting meshes, arenas are released with their last mesh.
+	*/
+	static void Shutdown();
+	/// Allocate mesh.
+	/**
+		Uploads geometry into arena matching its layout and index type and points
+		the mesh to the shared buffers. The mesh gets single part covering all indices,
+		offset of the ranges is carried by its first index and base vertex.
+		Returns false if the pool isn't running or the geometry can't be pooled.
+
+		\param[in] vertices		Collection of vertices.
+		\param[in] vertexSize	Size of the collection.
+		\param[in] indices		Collection of indices.
+		\param[in] indexCount	Count of indices in collection.
+		\param[in] indexType	Datatype of indices.
+		\param[in] layout		Layout of vertices.
+		\param[out] outMesh		Mesh pointed to the shared buffers.
+	*/
+	static bool Allocate(const GLvoid* vertices, GLsizeiptr vertexSize, const GLvoid* indices, GLuint indexCount, GLenum indexType, const VertexBufferLayout& layout, MeshResource& outMesh);
+	/// Release mesh.
+	/**
+		Returns ranges of the mesh to its arena and compacts the arena
+		if it wastes too much space.
+
+		\param[in] mesh			Released mesh.
+	*/
+	static void Release(MeshResource& mesh);
+	/// Defragment arena.
+	/**
+		Moves live ranges to the start of the arena and shifts parts of their meshes.
+
+		\param[in] arena		Compacted arena.
+	*/
+	static void Defragment(Arena& arena);
+	/// Report statistics.
+	/**
+		Prints number of arenas, their usage and compactions.
+	*/
+	static void Report();
+
+private:
+	/// Relocate mesh.
+	/**
+		Shifts all parts and levels of the mesh.
+
+		\param[in,out] mesh		Moved mesh.
+		\param[in] vertexDelta	Change of vertex offset.
+		\param[in] indexDelta	Change of index offset.
+	*/
+	static void Relocate(MeshResource& mesh, GLint vertexDelta, GLint indexDelta);
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	GeometryPool() { }
+};
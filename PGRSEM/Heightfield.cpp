@@ -0,0 +1,242 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       Heightfield.cpp
+ * \author     Dominik Pupala
+ * \date       2021/07/06
+ * \brief      Source file for terrain heightfield.
+ *
+ *  Source file containing declarations for Heightfield class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "Heightfield.h"
+#include "BoundingBox.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define HEIGHTFIELD_SSE
+#endif
+
+#ifdef HEIGHTFIELD_SSE
+/// Bilinear blend of four corners, four points at a time.
+static inline __m128 blend(__m128 c00, __m128 c10, __m128 c01, __m128 c11, __m128 u, __m128 v)
+{
+	__m128 lerp0 = _mm_add_ps(c00, _mm_mul_ps(_mm_sub_ps(c10, c00), u));
+	__m128 lerp1 = _mm_add_ps(c01, _mm_mul_ps(_mm_sub_ps(c11, c01), u));
+
+	return _mm_add_ps(lerp0, _mm_mul_ps(_mm_sub_ps(lerp1, lerp0), v));
+}
+#endif
+
+Heightfield::Heightfield()
+	: _origin(0.0f), _cellSize(1.0f), _inverseCell(1.0f), _columns(0), _rows(0)
+{
+}
+
+bool Heightfield::Bake(const MeshBVH& mesh, const glm::mat4& model, const glm::vec2& lower, const glm::vec2& upper, GLfloat cellSize)
+{
+	_heights.clear();
+	_normals.clear();
+
+	// cell counts are only computed for a valid area
+	if (!(cellSize > 0.0f) || !(upper.x > lower.x) || !(upper.y > lower.y) || mesh.GetTriangleCount() == 0)
+		return false;
+
+	GLuint columns = (GLuint)std::ceil((upper.x - lower.x) / cellSize) + 1;
+	GLuint rows = (GLuint)std::ceil((upper.y - lower.y) / cellSize) + 1;
+
+	glm::vec3 meshLower, meshUpper;
+	mesh.GetBounds(meshLower, meshUpper);
+
+	// rays start above the highest point of the placed mesh and reach below the lowest one
+	glm::vec3 center, extent;
+	BoundingBox::Transform(model, meshLower, meshUpper, center, extent);
+	GLfloat reach = extent.y + 1.0f;
+
+	glm::mat4 inverse = glm::inverse(model);
+
+	std::vector<GLfloat> heights(columns * rows);
+	std::vector<GLubyte> hits(columns * rows, 0);
+	GLfloat lowest = std::numeric_limits<GLfloat>::max();
+
+	for (GLuint row = 0; row < rows; ++row)
+	{
+		for (GLuint column = 0; column < columns; ++column)
+		{
+			glm::vec3 origin = glm::vec3(lower.x + column * cellSize, center.y + reach, lower.y + row * cellSize);
+			glm::vec3 localOrigin, direction;
+			BoundingBox::TransformRay(inverse, origin, glm::vec3(0.0f, -1.0f, 0.0f), localOrigin, direction);
+			GLfloat distance = 2.0f * reach;
+			GLuint triangle;
+
+			if (!mesh.Raycast(localOrigin, direction, distance, triangle))
+				continue;
+
+			size_t index = row * columns + column;
+			heights[index] = origin.y - distance;
+			hits[index] = 1;
+			lowest = std::min(lowest, heights[index]);
+		}
+	}
+
+	if (lowest == std::numeric_limits<GLfloat>::max())
+		return false;
+
+	for (size_t i = 0; i < heights.size(); ++i)
+		if (!hits[i])
+			heights[i] = lowest;
+
+	_origin = lower;
+	_cellSize = cellSize;
+	_inverseCell = 1.0f / cellSize;
+	_columns = columns;
+	_rows = rows;
+	_heights = std::move(heights);
+	_normals.resize(_heights.size());
+
+	// central differences, edges fall back to one sided ones
+	for (GLuint row = 0; row < rows; ++row)
+	{
+		for (GLuint column = 0; column < columns; ++column)
+		{
+			GLuint left = column > 0 ? column - 1 : column, right = column + 1 < columns ? column + 1 : column;
+			GLuint back = row > 0 ? row - 1 : row, front = row + 1 < rows ? row + 1 : row;
+
+			GLfloat slopeX = (_heights[row * columns + right] - _heights[row * columns + left]) / ((right - left) * cellSize);
+			GLfloat slopeZ = (_heights[front * columns + column] - _heights[back * columns + column]) / ((front - back) * cellSize);
+
+			_normals[row * columns + column] = glm::normalize(glm::vec3(-slopeX, 1.0f, -slopeZ));
+		}
+	}
+
+	return true;
+}
+
+GLfloat Heightfield::GetHeight(GLfloat x, GLfloat z) const
+{
+	if (_heights.empty())
+		return 0.0f;
+
+	GLfloat u, v;
+	size_t i = Locate(x, z, u, v);
+
+	GLfloat lerp0 = _heights[i] + (_heights[i + 1] - _heights[i]) * u;
+	GLfloat lerp1 = _heights[i + _columns] + (_heights[i + _columns + 1] - _heights[i + _columns]) * u;
+
+	return lerp0 + (lerp1 - lerp0) * v;
+}
+
+glm::vec3 Heightfield::GetNormal(GLfloat x, GLfloat z) const
+{
+	if (_normals.empty())
+		return glm::vec3(0.0f, 1.0f, 0.0f);
+
+	GLfloat u, v;
+	size_t i = Locate(x, z, u, v);
+
+	glm::vec3 lerp0 = _normals[i] + (_normals[i + 1] - _normals[i]) * u;
+	glm::vec3 lerp1 = _normals[i + _columns] + (_normals[i + _columns + 1] - _normals[i + _columns]) * u;
+
+	return glm::normalize(lerp0 + (lerp1 - lerp0) * v);
+}
+
+void Heightfield::Sample(const GLfloat* x, const GLfloat* z, size_t count, GLfloat* outHeights, glm::vec3* outNormals) const
+{
+	size_t i = 0;
+
+	if (_heights.empty())
+	{
+		std::fill(outHeights, outHeights + count, 0.0f);
+		std::fill(outNormals, outNormals + count, glm::vec3(0.0f, 1.0f, 0.0f));
+		return;
+	}
+
+#ifdef HEIGHTFIELD_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 originX = _mm_set1_ps(_origin.x);
+	const __m128 originZ = _mm_set1_ps(_origin.y);
+	const __m128 inverse = _mm_set1_ps(_inverseCell);
+	const __m128 lastX = _mm_set1_ps((GLfloat)(_columns - 1));
+	const __m128 lastZ = _mm_set1_ps((GLfloat)(_rows - 1));
+	const __m128 cellX = _mm_set1_ps((GLfloat)(_columns - 2));
+	const __m128 cellZ = _mm_set1_ps((GLfloat)(_rows - 2));
+
+	alignas(16) int32_t columns[4], rows[4];
+	alignas(16) GLfloat h[4][4], nx[4][4], ny[4][4], nz[4][4];
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 gx = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(x + i), originX), inverse), zero), lastX);
+		__m128 gz = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(z + i), originZ), inverse), zero), lastZ);
+
+		// clamped coordinates are positive, truncation floors them, far edge stays in the last cell
+		__m128i cx = _mm_cvttps_epi32(_mm_min_ps(gx, cellX));
+		__m128i cz = _mm_cvttps_epi32(_mm_min_ps(gz, cellZ));
+		__m128 u = _mm_sub_ps(gx, _mm_cvtepi32_ps(cx));
+		__m128 v = _mm_sub_ps(gz, _mm_cvtepi32_ps(cz));
+
+		_mm_store_si128((__m128i*)columns, cx);
+		_mm_store_si128((__m128i*)rows, cz);
+
+		// SSE has no gather, corners are collected one point at a time
+		for (size_t k = 0; k < 4; ++k)
+		{
+			size_t corners[4] = { 0, 1, _columns, _columns + 1 };
+			size_t first = (size_t)rows[k] * _columns + columns[k];
+
+			for (size_t c = 0; c < 4; ++c)
+			{
+				h[c][k] = _heights[first + corners[c]];
+				nx[c][k] = _normals[first + corners[c]].x;
+				ny[c][k] = _normals[first + corners[c]].y;
+				nz[c][k] = _normals[first + corners[c]].z;
+			}
+		}
+
+		__m128 height = blend(_mm_load_ps(h[0]), _mm_load_ps(h[1]), _mm_load_ps(h[2]), _mm_load_ps(h[3]), u, v);
+		__m128 normalX = blend(_mm_load_ps(nx[0]), _mm_load_ps(nx[1]), _mm_load_ps(nx[2]), _mm_load_ps(nx[3]), u, v);
+		__m128 normalY = blend(_mm_load_ps(ny[0]), _mm_load_ps(ny[1]), _mm_load_ps(ny[2]), _mm_load_ps(ny[3]), u, v);
+		__m128 normalZ = blend(_mm_load_ps(nz[0]), _mm_load_ps(nz[1]), _mm_load_ps(nz[2]), _mm_load_ps(nz[3]), u, v);
+
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX, normalX), _mm_mul_ps(normalY, normalY)), _mm_mul_ps(normalZ, normalZ)));
+		normalX = _mm_div_ps(normalX, length);
+		normalY = _mm_div_ps(normalY, length);
+		normalZ = _mm_div_ps(normalZ, length);
+
+		_mm_storeu_ps(outHeights + i, height);
+		_mm_store_ps(nx[0], normalX);
+		_mm_store_ps(ny[0], normalY);
+		_mm_store_ps(nz[0], normalZ);
+
+		for (size_t k = 0; k < 4; ++k)
+			outNormals[i + k] = glm::vec3(nx[0][k], ny[0][k], nz[0][k]);
+	}
+#endif
+
+	// remainder of the last group, or all points without SSE
+	for (; i < count; ++i)
+	{
+		outHeights[i] = GetHeight(x[i], z[i]);
+		outNormals[i] = GetNormal(x[i], z[i]);
+	}
+}
+
+size_t Heightfield::Locate(GLfloat x, GLfloat z, GLfloat& outU, GLfloat& outV) const
+{
+	GLfloat gx = std::min(std::max((x - _origin.x) * _inverseCell, 0.0f), (GLfloat)(_columns - 1));
+	GLfloat gz = std::min(std::max((z - _origin.y) * _inverseCell, 0.0f), (GLfloat)(_rows - 1));
+
+	// far edge stays in the last cell
+	GLuint column = std::min((GLuint)gx, _columns - 2);
+	GLuint row = std::min((GLuint)gz, _rows - 2);
+
+	outU = gx - column;
+	outV = gz - row;
+
+	return (size_t)row * _columns + column;
+}
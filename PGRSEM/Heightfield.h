@@ -0,0 +1,101 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       Heightfield.h
+ * \author     Dominik Pupala
+ * \date       2021/07/06
+ * \brief      Header file for terrain heightfield.
+ *
+ *  Header file containing definitions for Heightfield class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+#include "BVH.h"
+
+/// Class that contains heights of terrain in regular grid.
+/**
+  This class contains heights and normals of terrain sampled in regular grid over
+  the ground plane. Samples are baked once by casting rays down onto the terrain mesh,
+  queries blend four samples around the point, so their cost doesn't depend on the mesh.
+  Points outside the grid get the nearest edge, empty field is flat ground at zero.
+*/
+class Heightfield
+{
+private:
+	glm::vec2 _origin; ///< World position of the first sample on the ground plane
+	GLfloat _cellSize; ///< Distance of neighbouring samples
+	GLfloat _inverseCell; ///< Inverted distance of neighbouring samples
+	GLuint _columns; ///< Samples along x
+	GLuint _rows; ///< Samples along z
+	std::vector<GLfloat> _heights; ///< Heights, rows along z
+	std::vector<glm::vec3> _normals; ///< Unit normals, rows along z
+
+public:
+	/// Constructor
+	/**
+		Creates empty field.
+	*/
+	Heightfield();
+	/// Bake field.
+	/**
+		Samples the mesh placed by the model matrix over the rectangle of the ground plane,
+		replacing the previous field. Samples missing the mesh lie at its lowest hit.
+		Returns false if the mesh wasn't hit at all.
+
+		\param[in] mesh			Triangles of the terrain.
+		\param[in] model		Model matrix of the terrain.
+		\param[in] lower		Lower corner of the rectangle.
+		\param[in] upper		Upper corner of the rectangle.
+		\param[in] cellSize		Distance of neighbouring samples.
+	*/
+	bool Bake(const MeshBVH& mesh, const glm::mat4& model, const glm::vec2& lower, const glm::vec2& upper, GLfloat cellSize);
+	/// Height getter.
+	/**
+		Returns height of the terrain under the point, bilinear blend of the samples.
+
+		\param[in] x	Position along x.
+		\param[in] z	Position along z.
+	*/
+	GLfloat GetHeight(GLfloat x, GLfloat z) const;
+	/// Normal getter.
+	/**
+		Returns unit normal of the terrain under the point, bilinear blend of the samples.
+
+		\param[in] x	Position along x.
+		\param[in] z	Position along z.
+	*/
+	glm::vec3 GetNormal(GLfloat x, GLfloat z) const;
+	/// Sample field.
+	/**
+		Returns heights and normals under many points at once, four points at a time with SSE.
+
+		\param[in] x				Positions along x.
+		\param[in] z				Positions along z.
+		\param[in] count			Number of points.
+		\param[out] outHeights		Heights under the points.
+		\param[out] outNormals		Unit normals under the points.
+	*/
+	void Sample(const GLfloat* x, const GLfloat* z, size_t count, GLfloat* outHeights, glm::vec3* outNormals) const;
+	/// Empty getter.
+	/**
+		Returns true if the field wasn't baked.
+	*/
+	inline bool IsEmpty() const { return _heights.empty(); }
+
+private:
+	/// Locate point.
+	/**
+		Returns the first sample of the cell under the point and position of the point in the cell.
+
+		\param[in] x		Position along x.
+		\param[in] z		Position along z.
+		\param[out] outU	Position in the cell along x, from zero to one.
+		\param[out] outV	Position in the cell along z, from zero to one.
+	*/
+	size_t Locate(GLfloat x, GLfloat z, GLfloat& outU, GLfloat& outV) const;
+};
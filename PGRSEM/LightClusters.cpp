@@ -0,0 +1,288 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       LightClusters.cpp
+ * \author     Dominik Pupala
+ * \date       2021/11/06
+ * \brief      Source file for clustered light list.
+ *
+ *  Source file containing declarations for LightClusters class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "LightClusters.h"
+#include "StateTracker.h"
+
+#include <cmath>
+#include <iostream>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define CLUSTER_SSE
+#endif
+
+static_assert(LightClusters::CLUSTERS_X % 4 == 0, "Rows of clusters aren't split into groups of four");
+static_assert(LightClusters::MAX_LIGHTS <= 65536, "Light indices don't fit the index buffer");
+
+LightClusters::LightClusters()
+	: _visiblePoints(0), _projection(0.0f), _zNear(0.0f), _sliceScale(0.0f), _sliceBias(0.0f),
+	_listed(0), _occupied(0), _busiest(0), _dropped(0)
+{
+	for (auto* component : { &_lowerX, &_lowerY, &_lowerZ, &_upperX, &_upperY, &_upperZ })
+		component->resize(CLUSTERS);
+
+	_grid.resize(2 * CLUSTERS);
+	_filled.resize(CLUSTERS);
+	_indices.resize(MAX_INDICES);
+
+	_lightBuffer = new VertexBuffer(nullptr, MAX_LIGHTS * sizeof(LightSource));
+	_gridBuffer = new VertexBuffer(nullptr, _grid.size() * sizeof(GLuint));
+	_indexBuffer = new VertexBuffer(nullptr, _indices.size() * sizeof(GLushort));
+	_uniforms = new UniformBuffer(sizeof(ClusterBlock), ClusterBlock::BINDING);
+
+	_lightTexture = CreateTexture(*_lightBuffer, LIGHT_UNIT, GL_RGBA32F);
+	_gridTexture = CreateTexture(*_gridBuffer, GRID_UNIT, GL_RG32UI);
+	_indexTexture = CreateTexture(*_indexBuffer, INDEX_UNIT, GL_R16UI);
+
+	StateTracker::ActiveTexture(GL_TEXTURE0);
+}
+
+LightClusters::~LightClusters()
+{
+	for (GLuint texture : { _lightTexture, _gridTexture, _indexTexture })
+		StateTracker::DeleteTexture(texture);
+
+	delete _lightBuffer;
+	delete _gridBuffer;
+	delete _indexBuffer;
+	delete _uniforms;
+}
+
+void LightClusters::AddLight(const LightSource& light)
+{
+	if (_lights.size() < MAX_LIGHTS)
+		_lights.push_back(light);
+}
+
+void LightClusters::Assign(const glm::mat4& projection, const glm::mat4& view, GLsizei width, GLsizei height)
+{
+	// lights whose range misses the frustum light nothing on the screen
+	_culler.Clear();
+
+	for (const LightSource& light : _lights)
+		_culler.Add(glm::mat4(1.0f), light.Position - light.Range, light.Position + light.Range, light.Position, light.Range);
+
+	_culler.Cull(Camera::ExtractFrustum(projection * view));
+
+	// point lights go first, deferred path draws each kind with its own volume
+	_visible.clear();
+
+	for (bool spot : { false, true })
+	{
+		for (size_t i = 0; i < _lights.size(); ++i)
+		{
+			if (_culler.IsVisible(i) && (glm::dot(_lights[i].Direction, _lights[i].Direction) > 0.0f) == spot)
+				_visible.push_back(_lights[i]);
+		}
+
+		if (!spot)
+			_visiblePoints = _visible.size();
+	}
+
+	if (projection != _projection)
+		Build(projection);
+
+	_hits.clear();
+	std::fill(_grid.begin(), _grid.end(), 0);
+
+	// only slices within the range along view depth are tested
+	for (size_t i = 0; i < _visible.size(); ++i)
+	{
+		glm::vec3 center = glm::vec3(view * glm::vec4(_visible[i].Position, 1.0f));
+		GLfloat radius = _visible[i].Range;
+
+		GLint first = GetSlice(-center.z - radius);
+		GLint last = GetSlice(-center.z + radius);
+
+		for (GLint z = first; z <= last; ++z)
+		{
+			for (GLint y = 0; y < CLUSTERS_Y; ++y)
+				AssignRow((size_t)(z * CLUSTERS_Y + y) * CLUSTERS_X, center, radius, (GLuint)i);
+		}
+	}
+
+	// counts turn into offsets, clusters past the index limit keep what fits
+	GLuint offset = 0;
+	_listed = _hits.size();
+	_occupied = 0;
+	_busiest = 0;
+
+	for (size_t i = 0; i < CLUSTERS; ++i)
+	{
+		GLuint count = std::min(_grid[2 * i + 1], (GLuint)MAX_INDICES - offset);
+
+		_occupied += _grid[2 * i + 1] > 0 ? 1 : 0;
+		_busiest = std::max(_busiest, (size_t)_grid[2 * i + 1]);
+
+		_grid[2 * i] = offset;
+		_grid[2 * i + 1] = count;
+		_filled[i] = 0;
+
+		offset += count;
+	}
+
+	_dropped = _listed - offset;
+
+	// hits come light after light, so each cluster lists its point lights first
+	for (GLuint hit : _hits)
+	{
+		size_t cluster = hit / MAX_LIGHTS;
+
+		if (_filled[cluster] < _grid[2 * cluster + 1])
+			_indices[_grid[2 * cluster] + _filled[cluster]++] = (GLushort)(hit % MAX_LIGHTS);
+	}
+
+	if (!_visible.empty())
+		_lightBuffer->SetData(_visible.data(), _visible.size() * sizeof(LightSource), 0);
+
+	if (offset > 0)
+		_indexBuffer->SetData(_indices.data(), offset * sizeof(GLushort), 0);
+
+	_gridBuffer->SetData(_grid.data(), _grid.size() * sizeof(GLuint), 0);
+
+	ClusterBlock block;
+	block.TileScale = glm::vec2((GLfloat)CLUSTERS_X / width, (GLfloat)CLUSTERS_Y / height);
+	block.SliceScale = _sliceScale;
+	block.SliceBias = _sliceBias;
+	block.Count = glm::ivec3(CLUSTERS_X, CLUSTERS_Y, CLUSTERS_Z);
+
+	_uniforms->SetData(&block, sizeof(block));
+
+	const GLuint textures[] = { _lightTexture, _gridTexture, _indexTexture };
+	const GLuint units[] = { LIGHT_UNIT, GRID_UNIT, INDEX_UNIT };
+
+	for (size_t i = 0; i < 3; ++i)
+	{
+		StateTracker::ActiveTexture(GL_TEXTURE0 + units[i]);
+		StateTracker::BindTexture(GL_TEXTURE_BUFFER, textures[i]);
+	}
+
+	StateTracker::ActiveTexture(GL_TEXTURE0);
+}
+
+void LightClusters::Report() const
+{
+	std::cout << "Light clusters: " << _lights.size() << " lights, " << _visiblePoints << " point and "
+		<< GetVisibleSpots() << " spot lights visible, " << _listed << " listed in " << _occupied << " of "
+		<< CLUSTERS << " clusters, busiest has " << _busiest << ", " << _dropped << " dropped" << std::endl;
+}
+
+void LightClusters::Build(const glm::mat4& projection)
+{
+	_projection = projection;
+
+	// planes of the perspective projection
+	_zNear = projection[3][2] / (projection[2][2] - 1.0f);
+	GLfloat zFar = projection[3][2] / (projection[2][2] + 1.0f);
+
+	_sliceScale = CLUSTERS_Z / std::log(zFar / _zNear);
+	_sliceBias = -std::log(_zNear) * _sliceScale;
+
+	for (GLint z = 0; z < CLUSTERS_Z; ++z)
+	{
+		GLfloat front = _zNear * std::pow(zFar / _zNear, (GLfloat)z / CLUSTERS_Z);
+		GLfloat back = _zNear * std::pow(zFar / _zNear, (GLfloat)(z + 1) / CLUSTERS_Z);
+
+		for (GLint y = 0; y < CLUSTERS_Y; ++y)
+		{
+			GLfloat bottom = 2.0f * y / CLUSTERS_Y - 1.0f;
+			GLfloat top = 2.0f * (y + 1) / CLUSTERS_Y - 1.0f;
+
+			for (GLint x = 0; x < CLUSTERS_X; ++x)
+			{
+				GLfloat left = 2.0f * x / CLUSTERS_X - 1.0f;
+				GLfloat right = 2.0f * (x + 1) / CLUSTERS_X - 1.0f;
+				size_t i = (size_t)(z * CLUSTERS_Y + y) * CLUSTERS_X + x;
+
+				// tile widens with depth, the box encloses it at both ends of the slice
+				_lowerX[i] = std::min(left * front, left * back) / projection[0][0];
+				_upperX[i] = std::max(right * front, right * back) / projection[0][0];
+				_lowerY[i] = std::min(bottom * front, bottom * back) / projection[1][1];
+				_upperY[i] = std::max(top * front, top * back) / projection[1][1];
+				_lowerZ[i] = -back;
+				_upperZ[i] = -front;
+			}
+		}
+	}
+}
+
+GLint LightClusters::GetSlice(GLfloat depth) const
+{
+	GLint slice = (GLint)std::floor(std::log(std::max(depth, _zNear)) * _sliceScale + _sliceBias);
+
+	return std::min(std::max(slice, 0), CLUSTERS_Z - 1);
+}
+
+void LightClusters::AssignRow(size_t row, const glm::vec3& center, GLfloat radius, GLuint light)
+{
+	size_t x = 0;
+
+#ifdef CLUSTER_SSE
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 cx = _mm_set1_ps(center.x);
+	const __m128 cy = _mm_set1_ps(center.y);
+	const __m128 cz = _mm_set1_ps(center.z);
+	const __m128 r2 = _mm_set1_ps(radius * radius);
+
+	for (; x < CLUSTERS_X; x += 4)
+	{
+		size_t i = row + x;
+
+		// center is away from the box only along axes where it lies outside of it
+		__m128 dx = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_lowerX[i]), cx), _mm_sub_ps(cx, _mm_loadu_ps(&_upperX[i]))));
+		__m128 dy = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_lowerY[i]), cy), _mm_sub_ps(cy, _mm_loadu_ps(&_upperY[i]))));
+		__m128 dz = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_lowerZ[i]), cz), _mm_sub_ps(cz, _mm_loadu_ps(&_upperZ[i]))));
+		__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+		int mask = _mm_movemask_ps(_mm_cmple_ps(distance, r2));
+
+		for (size_t k = 0; k < 4; ++k)
+		{
+			if (mask >> k & 1)
+			{
+				_hits.push_back((GLuint)((i + k) * MAX_LIGHTS + light));
+				++_grid[2 * (i + k) + 1];
+			}
+		}
+	}
+#endif
+
+	// all clusters of the row without SSE
+	for (; x < CLUSTERS_X; ++x)
+	{
+		size_t i = row + x;
+
+		GLfloat dx = std::max(0.0f, std::max(_lowerX[i] - center.x, center.x - _upperX[i]));
+		GLfloat dy = std::max(0.0f, std::max(_lowerY[i] - center.y, center.y - _upperY[i]));
+		GLfloat dz = std::max(0.0f, std::max(_lowerZ[i] - center.z, center.z - _upperZ[i]));
+
+		if (dx * dx + dy * dy + dz * dz <= radius * radius)
+		{
+			_hits.push_back((GLuint)(i * MAX_LIGHTS + light));
+			++_grid[2 * i + 1];
+		}
+	}
+}
+
+GLuint LightClusters::CreateTexture(const VertexBuffer& buffer, GLuint unit, GLenum format)
+{
+	GLuint texture;
+	glGenTextures(1, &texture);
+
+	StateTracker::ActiveTexture(GL_TEXTURE0 + unit);
+	StateTracker::BindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, format, buffer.GetID());
+
+	return texture;
+}
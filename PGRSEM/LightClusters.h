@@ -0,0 +1,203 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       LightClusters.h
+ * \author     Dominik Pupala
+ * \date       2021/11/06
+ * \brief      Header file for clustered light list.
+ *
+ *  Header file containing definitions for LightClusters class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+#include "VertexBuffer.h"
+#include "UniformBuffer.h"
+#include "FrustumCuller.h"
+
+/// Struct that contains light of the light list.
+/**
+  This struct mirrors four texels of the light buffer. Spot lights have direction,
+  point lights leave it zero. Light fades out completely at its range.
+*/
+struct LightSource
+{
+	glm::vec3 Position = glm::vec3(0.0f); ///< World position
+	GLfloat Range = 1.0f; ///< Distance the light reaches
+	glm::vec3 Color = glm::vec3(1.0f); ///< Diffuse and specular color
+	GLfloat Ambient = 0.0f; ///< Fraction of the color lighting ambient material
+	glm::vec3 Direction = glm::vec3(0.0f); ///< Unit direction of spot light
+	GLfloat CutoffInn = 1.0f; ///< Cosine of the fully lit cone
+	glm::vec3 Attenuation = glm::vec3(1.0f, 0.0f, 0.0f); ///< Constant, linear and quadratic attenuation
+	GLfloat CutoffOut = 0.0f; ///< Cosine of the lit cone
+};
+
+/// Struct that contains cluster uniform block.
+/**
+  This struct mirrors std140 layout of the ClusterData block.
+*/
+struct ClusterBlock
+{
+	static constexpr GLuint BINDING = 4;
+
+	glm::vec2 TileScale = glm::vec2(0.0f); ///< Clusters per pixel
+	GLfloat SliceScale = 0.0f; ///< Slices per logarithm of view depth
+	GLfloat SliceBias = 0.0f; ///< Slice of unit view depth
+	glm::ivec3 Count = glm::ivec3(0); ///< Clusters along each axis
+	GLint Padding = 0;
+};
+
+static_assert(sizeof(LightSource) == 64, "LightSource doesn't match the light buffer");
+static_assert(sizeof(ClusterBlock) == 32, "ClusterBlock doesn't match std140 layout");
+
+/// Class that assigns lights of the frame to clusters of the view frustum.
+/**
+  This class collects lights of one frame, culls them against the view frustum and uploads
+  the visible ones into buffer texture, point lights first. The frustum is split into screen
+  tiles and slices growing exponentially with view depth, every light is listed in each
+  cluster its range touches. Cluster bounds are view space boxes stored in structure of arrays
+  layout, so four of them are tested against the light sphere at once. Forward shaders find
+  the cluster of the fragment and loop only over its lights, so the cost follows the local
+  light density rather than the number of lights.
+*/
+class LightClusters
+{
+public:
+	static constexpr size_t MAX_LIGHTS = 1024; ///< Lights per frame
+	static constexpr size_t MAX_INDICES = 65536; ///< Lights listed in all clusters together
+	static constexpr GLint CLUSTERS_X = 16; ///< Screen tiles along the width
+	static constexpr GLint CLUSTERS_Y = 9; ///< Screen tiles along the height
+	static constexpr GLint CLUSTERS_Z = 24; ///< Depth slices
+	static constexpr size_t CLUSTERS = CLUSTERS_X * CLUSTERS_Y * CLUSTERS_Z; ///< Clusters of the frustum
+
+	static constexpr GLuint LIGHT_UNIT = 5; ///< Texture unit of the light buffer
+	static constexpr GLuint GRID_UNIT = 6; ///< Texture unit of the cluster ranges
+	static constexpr GLuint INDEX_UNIT = 7; ///< Texture unit of the light indices
+
+private:
+	std::vector<LightSource> _lights; ///< Lights of the frame
+	std::vector<LightSource> _visible; ///< Lights inside the frustum, point lights first
+	size_t _visiblePoints; ///< Point lights inside the frustum
+	FrustumCuller _culler; ///< Culler of the light ranges
+
+	// View space bounds of the clusters, one component per array
+	std::vector<GLfloat> _lowerX; ///< Lower corner, x component
+	std::vector<GLfloat> _lowerY; ///< Lower corner, y component
+	std::vector<GLfloat> _lowerZ; ///< Lower corner, z component
+	std::vector<GLfloat> _upperX; ///< Upper corner, x component
+	std::vector<GLfloat> _upperY; ///< Upper corner, y component
+	std::vector<GLfloat> _upperZ; ///< Upper corner, z component
+
+	glm::mat4 _projection; ///< Projection the bounds were built for
+	GLfloat _zNear; ///< Distance of the near plane
+	GLfloat _sliceScale; ///< Slices per logarithm of view depth
+	GLfloat _sliceBias; ///< Slice of unit view depth
+
+	std::vector<GLuint> _hits; ///< Cluster and light of every assignment
+	std::vector<GLuint> _grid; ///< Offset and count of the lights of every cluster
+	std::vector<GLuint> _filled; ///< Lights written into every cluster
+	std::vector<GLushort> _indices; ///< Lights of all clusters, cluster after cluster
+
+	size_t _listed; ///< Lights listed in the last assignment
+	size_t _occupied; ///< Clusters with any light in the last assignment
+	size_t _busiest; ///< Most lights of single cluster in the last assignment
+	size_t _dropped; ///< Lights over the index limit in the last assignment
+
+	VertexBuffer* _lightBuffer; ///< Visible lights
+	VertexBuffer* _gridBuffer; ///< Cluster ranges
+	VertexBuffer* _indexBuffer; ///< Light indices
+	GLuint _lightTexture; ///< Buffer texture of the visible lights
+	GLuint _gridTexture; ///< Buffer texture of the cluster ranges
+	GLuint _indexTexture; ///< Buffer texture of the light indices
+	UniformBuffer* _uniforms; ///< Cluster uniform block
+
+public:
+	/// Constructor
+	/**
+		Creates light, cluster and index buffers with their buffer textures.
+	*/
+	LightClusters();
+	/// Destructor
+	/**
+		Deletes the buffers and their buffer textures.
+	*/
+	~LightClusters();
+	/// Clear lights.
+	/**
+		Removes lights of the previous frame.
+	*/
+	inline void ClearLights() { _lights.clear(); }
+	/// Add light.
+	/**
+		Adds light of the frame, lights above the limit are dropped.
+
+		\param[in] light	Added light.
+	*/
+	void AddLight(const LightSource& light);
+	/// Assign lights.
+	/**
+		Culls lights against the frustum, lists visible ones in the clusters they reach
+		and uploads lights, clusters and the cluster block. Buffer textures are left bound
+		on their units for the whole frame.
+
+		\param[in] projection	Global perspective projection matrix.
+		\param[in] view			Global view matrix.
+		\param[in] width		Width of the screen.
+		\param[in] height		Height of the screen.
+	*/
+	void Assign(const glm::mat4& projection, const glm::mat4& view, GLsizei width, GLsizei height);
+	/// Visible point lights getter.
+	/**
+		Returns number of point lights at the start of the light buffer.
+	*/
+	inline size_t GetVisiblePoints() const { return _visiblePoints; }
+	/// Visible spot lights getter.
+	/**
+		Returns number of spot lights following the point lights in the light buffer.
+	*/
+	inline size_t GetVisibleSpots() const { return _visible.size() - _visiblePoints; }
+	/// Report statistics.
+	/**
+		Prints lights of the last frame, visible ones and how densely they fill the clusters.
+	*/
+	void Report() const;
+
+private:
+	/// Build clusters.
+	/**
+		Computes slicing and view space bounds of the clusters of the projection.
+
+		\param[in] projection	Perspective projection matrix.
+	*/
+	void Build(const glm::mat4& projection);
+	/// Slice getter.
+	/**
+		Returns depth slice of the view depth, clamped into the frustum.
+
+		\param[in] depth	Distance along the view direction.
+	*/
+	GLint GetSlice(GLfloat depth) const;
+	/// Assign row.
+	/**
+		Lists the light in clusters of single row its sphere intersects.
+
+		\param[in] row		First cluster of the row.
+		\param[in] center	View space center of the light.
+		\param[in] radius	Range of the light.
+		\param[in] light	Index of the light in the light buffer.
+	*/
+	void AssignRow(size_t row, const glm::vec3& center, GLfloat radius, GLuint light);
+	/// Create texture.
+	/**
+		Returns buffer texture of the buffer bound on the unit.
+
+		\param[in] buffer	Viewed buffer.
+		\param[in] unit		Texture unit.
+		\param[in] format	Internal format of the texels.
+	*/
+	static GLuint CreateTexture(const VertexBuffer& buffer, GLuint unit, GLenum format);
+};
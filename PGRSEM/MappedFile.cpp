@@ -0,0 +1,95 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MappedFile.cpp
+ * \author     Dominik Pupala
+ * \date       2021/20/05
+ * \brief      Source file for memory mapped file.
+ *
+ *  Source file containing declarations for MappedFile class that is a wrapper around
+ *  read-only memory mapping of the operating system.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+void MappedFile::Prefetch() const
+{
+	volatile uint8_t sink = 0;
+
+	for (size_t i = 0; i < _size; i += 4096)
+		sink ^= _data[i];
+}
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+	: _data(nullptr), _size(0), _file(INVALID_HANDLE_VALUE), _mapping(nullptr)
+{
+	_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (_file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0)
+		return;
+
+	_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (_mapping == nullptr)
+		return;
+
+	_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+	_size = _data ? static_cast<size_t>(size.QuadPart) : 0;
+}
+
+MappedFile::~MappedFile()
+{
+	if (_data)
+		UnmapViewOfFile(_data);
+	if (_mapping)
+		CloseHandle(_mapping);
+	if (_file != INVALID_HANDLE_VALUE)
+		CloseHandle(_file);
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+	: _data(nullptr), _size(0), _file(nullptr), _mapping(nullptr)
+{
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			_data = static_cast<const uint8_t*>(data);
+			_size = static_cast<size_t>(info.st_size);
+		}
+	}
+
+	close(fd); // mapping stays valid after the descriptor is closed
+}
+
+MappedFile::~MappedFile()
+{
+	if (_data)
+		munmap(const_cast<uint8_t*>(_data), _size);
+}
+
+#endif
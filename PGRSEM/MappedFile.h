@@ -0,0 +1,70 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MappedFile.h
+ * \author     Dominik Pupala
+ * \date       2021/20/05
+ * \brief      Header file for memory mapped file.
+ *
+ *  Header file containing definitions for MappedFile class that is a wrapper around
+ *  read-only memory mapping of the operating system.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+/// Class that wraps read-only memory mapped file.
+/**
+  This class contains context and functionality of read-only
+  memory mapped file.
+*/
+class MappedFile
+{
+private:
+	const uint8_t* _data; ///< Mapped memory
+	size_t _size; ///< Size of mapped memory
+
+	void* _file; ///< OS file handle
+	void* _mapping; ///< OS mapping handle
+
+public:
+	/// Constructor
+	/**
+		Maps the file from the given path into memory.
+		On failure, the mapping stays empty.
+
+		\param[in] path		Filepath to the mapped file.
+	*/
+	MappedFile(const std::string& path);
+	/// Destructor
+	/**
+		Unmaps the file from memory.
+	*/
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	/// Mapping validator.
+	/**
+		Returns true if the file was mapped.
+	*/
+	inline bool IsOpen() const { return _data != nullptr; }
+	/// Data getter.
+	/**
+		Returns pointer to the mapped memory.
+	*/
+	inline const uint8_t* GetData() const { return _data; }
+	/// Size getter.
+	/**
+		Returns size of the mapped memory.
+	*/
+	inline size_t GetSize() const { return _size; }
+	/// Prefetch mapping.
+	/**
+		Touches every page of the mapping, so later reads don't have to wait for the disk.
+	*/
+	void Prefetch() const;
+};
@@ -0,0 +1,231 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MeshCache.cpp
+ * \author     Dominik Pupala
+ * \date       2021/20/05
+ * \brief      Source file for binary mesh cache.
+ *
+ *  Source file containing declarations for MeshCache class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+
+MeshCache::MeshCache(const std::string& path)
+	: _file(path), _header(reinterpret_cast<const MeshCacheHeader*>(_file.GetData())) { }
+
+bool MeshCache::IsValid(uint64_t hash, uint32_t packing, uint32_t passes) const
+{
+	if (!_file.IsOpen() || _file.GetSize() < sizeof(MeshCacheHeader))
+		return false;
+
+	if (_header->Magic != MAGIC || _header->Version != VERSION || _header->Packing != packing || _header->Passes != passes)
+		return false;
+
+	if (hash != 0 && _header->SourceHash != hash)
+		return false;
+
+	// levels simplified with other settings are rebuilt
+	if (_header->LodRatio != MeshSimplifier::LOD_RATIO || _header->MaxError != MeshSimplifier::MAX_ERROR)
+		return false;
+
+	size_t size = sizeof(MeshCacheHeader)
+		+ _header->LayoutCount * sizeof(MeshCacheElement)
+		+ _header->SubmeshCount * sizeof(MeshCacheSubmesh)
+		+ _header->VertexSize
+		+ _header->IndexSize
+		+ _header->TextureSize;
+
+	return _file.GetSize() == size;
+}
+
+VertexBufferLayout MeshCache::GetLayout() const
+{
+	VertexBufferLayout layout;
+	const MeshCacheElement* elements = reinterpret_cast<const MeshCacheElement*>(_file.GetData() + sizeof(MeshCacheHeader));
+
+	for (uint32_t i = 0; i < _header->LayoutCount; ++i)
+		layout.Push(elements[i].Count, elements[i].Type, (GLboolean)elements[i].Normalized);
+
+	return layout;
+}
+
+std::vector<SubmeshAsset> MeshCache::GetSubmeshes() const
+{
+	std::vector<SubmeshAsset> submeshes(_header->SubmeshCount);
+
+	const MeshCacheSubmesh* packed = reinterpret_cast<const MeshCacheSubmesh*>(_file.GetData() + sizeof(MeshCacheHeader) + _header->LayoutCount * sizeof(MeshCacheElement));
+	const char* texture = reinterpret_cast<const char*>(GetIndices() + _header->IndexSize);
+
+	for (uint32_t i = 0; i < _header->SubmeshCount; ++i)
+	{
+		SubmeshAsset& submesh = submeshes[i];
+
+		submesh.First = packed[i].First;
+		submesh.Count = packed[i].Count;
+		submesh.BaseVertex = packed[i].BaseVertex;
+
+		for (uint32_t l = 0; l < packed[i].LodCount && l < MeshSimplifier::LOD_COUNT; ++l)
+		{
+			IndexRange lod;
+			lod.First = packed[i].LodFirst[l];
+			lod.Count = packed[i].LodIndexCount[l];
+			submesh.Lods.push_back(lod);
+		}
+
+		submesh.Diffuse = glm::vec3(packed[i].Diffuse[0], packed[i].Diffuse[1], packed[i].Diffuse[2]);
+		submesh.Ambient = glm::vec3(packed[i].Ambient[0], packed[i].Ambient[1], packed[i].Ambient[2]);
+		submesh.Specular = glm::vec3(packed[i].Specular[0], packed[i].Specular[1], packed[i].Specular[2]);
+		submesh.Shininess = packed[i].Shininess;
+
+		submesh.Texture.assign(texture, packed[i].TextureLength);
+		texture += packed[i].TextureLength;
+	}
+
+	return submeshes;
+}
+
+const GLubyte* MeshCache::GetVertices() const
+{
+	return _file.GetData() + sizeof(MeshCacheHeader) + _header->LayoutCount * sizeof(MeshCacheElement) + _header->SubmeshCount * sizeof(MeshCacheSubmesh);
+}
+
+const GLubyte* MeshCache::GetIndices() const
+{
+	return GetVertices() + _header->VertexSize;
+}
+
+bool MeshCache::Write(const std::string& path, uint64_t hash, const MeshAsset& asset)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file)
+		return false;
+
+	const PackedMesh& geometry = asset.Geometry;
+
+	uint32_t textureSize = 0;
+	for (const auto& submesh : asset.Submeshes)
+		textureSize += (uint32_t)submesh.Texture.size();
+
+	MeshCacheHeader header =
+	{
+		MAGIC, VERSION, hash, VertexQuantizer::GetMode(),
+		(uint32_t)geometry.Layout.size(), (uint32_t)geometry.Vertices.size(),
+		geometry.IndexType, geometry.IndexCount, (uint32_t)geometry.Indices.size(),
+		(uint32_t)asset.Submeshes.size(), textureSize, MeshOptimizer::GetPasses(),
+		MeshSimplifier::LOD_RATIO, MeshSimplifier::MAX_ERROR,
+		{ asset.Center.x, asset.Center.y, asset.Center.z }, asset.Radius,
+		{ asset.BoundsMin.x, asset.BoundsMin.y, asset.BoundsMin.z },
+		{ asset.BoundsMax.x, asset.BoundsMax.y, asset.BoundsMax.z }
+	};
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	for (const auto& element : geometry.Layout)
+	{
+		MeshCacheElement packed = { element.Count, element.Type, element.Normalized };
+		file.write(reinterpret_cast<const char*>(&packed), sizeof(packed));
+	}
+
+	for (const auto& submesh : asset.Submeshes)
+	{
+		MeshCacheSubmesh packed =
+		{
+			submesh.First, submesh.Count, submesh.BaseVertex, (uint32_t)submesh.Texture.size(),
+			(uint32_t)std::min(submesh.Lods.size(), (size_t)MeshSimplifier::LOD_COUNT), {}, {},
+			{ submesh.Diffuse.r, submesh.Diffuse.g, submesh.Diffuse.b },
+			{ submesh.Ambient.r, submesh.Ambient.g, submesh.Ambient.b },
+			{ submesh.Specular.r, submesh.Specular.g, submesh.Specular.b },
+			submesh.Shininess
+		};
+
+		for (uint32_t l = 0; l < packed.LodCount; ++l)
+		{
+			packed.LodFirst[l] = submesh.Lods[l].First;
+			packed.LodIndexCount[l] = submesh.Lods[l].Count;
+		}
+
+		file.write(reinterpret_cast<const char*>(&packed), sizeof(packed));
+	}
+
+	file.write(reinterpret_cast<const char*>(geometry.Vertices.data()), geometry.Vertices.size());
+	file.write(reinterpret_cast<const char*>(geometry.Indices.data()), geometry.Indices.size());
+
+	for (const auto& submesh : asset.Submeshes)
+		file.write(submesh.Texture.data(), submesh.Texture.size());
+
+	return file.good();
+}
+
+std::string MeshCache::GetCachePath(const std::string& path)
+{
+	size_t found = path.find_last_of('.');
+
+	return (found != std::string::npos ? path.substr(0, found) : path) + ".pgrmesh";
+}
+
+uint64_t MeshCache::HashSource(const std::string& path)
+{
+	std::ifstream obj(path, std::ios::binary);
+
+	if (!obj)
+		return 0;
+
+	std::string source((std::istreambuf_iterator<char>(obj)), std::istreambuf_iterator<char>());
+	uint64_t hash = Hash(source.data(), source.size(), HASH_BASIS);
+
+	std::string directory;
+	size_t found = path.find_last_of("/\\");
+
+	if (found != std::string::npos)
+		directory = path.substr(0, found + 1);
+
+	// material libraries are part of the source as well
+	std::string line;
+	std::istringstream lines(source);
+
+	while (std::getline(lines, line))
+	{
+		if (line.compare(0, 7, "mtllib ") != 0)
+			continue;
+
+		std::string name = line.substr(7);
+		name.erase(name.find_last_not_of(" \r\t") + 1);
+
+		std::ifstream mtl(directory + name, std::ios::binary);
+		std::string material((std::istreambuf_iterator<char>(mtl)), std::istreambuf_iterator<char>());
+		hash = Hash(material.data(), material.size(), hash);
+	}
+
+	return hash != 0 ? hash : 1;
+}
+
+uint64_t MeshCache::HashFile(const std::string& path)
+{
+	MappedFile file(path);
+
+	if (!file.IsOpen())
+		return 0;
+
+	uint64_t hash = Hash(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), HASH_BASIS);
+
+	return hash != 0 ? hash : 1;
+}
+
+uint64_t MeshCache::Hash(const char* data, size_t size, uint64_t hash)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= static_cast<uint8_t>(data[i]);
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
@@ -0,0 +1,240 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MeshCache.h
+ * \author     Dominik Pupala
+ * \date       2021/20/05
+ * \brief      Header file for binary mesh cache.
+ *
+ *  Header file containing definitions for MeshCache class and the layout of the
+ *  versioned .pgrmesh binary format.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+#include "MappedFile.h"
+#include "VertexQuantizer.h"
+#include "MeshSimplifier.h"
+#include "ResourceRegistry.h"
+
+class MeshCache;
+
+/// Struct that contains CPU side part of mesh.
+/**
+	This struct contains index range and material of single part of parsed mesh.
+*/
+struct SubmeshAsset
+{
+	GLuint First = 0; ///< Offset of the first index
+	GLuint Count = 0; ///< Number of indices
+	GLint BaseVertex = 0; ///< Offset of the first vertex
+
+	std::vector<IndexRange> Lods; ///< Simplified levels from the finest one
+
+	glm::vec3 Diffuse = glm::vec3(0.0f); ///< Material diffuse
+	glm::vec3 Ambient = glm::vec3(0.0f); ///< Material ambient
+	glm::vec3 Specular = glm::vec3(0.0f); ///< Material specular
+	GLfloat Shininess = 1.0f; ///< Material shininess
+
+	std::string Texture; ///< Diffuse texture path, empty if there is none
+};
+
+/// Struct that contains CPU side mesh data.
+/**
+	This struct contains mesh data that were parsed, but not uploaded yet.
+	Geometry is either owned by the packed mesh, or stays inside mapped cache.
+	If the same mesh was uploaded already, only the shared mesh is set.
+*/
+struct MeshAsset
+{
+	std::string Source; ///< Filepath to the source OBJ file
+	uint64_t SourceHash = 0; ///< Hash of the source files
+	std::shared_ptr<MeshResource> Shared; ///< Uploaded mesh, set if the registry has it already
+
+	std::shared_ptr<MeshCache> Cache; ///< Mapped cache, set if the geometry comes from it
+	PackedMesh Geometry; ///< Packed geometry of all parts, empty if it comes from the cache
+
+	glm::vec3 Center = glm::vec3(0.0f); ///< Center of the bounding sphere
+	GLfloat Radius = 0.0f; ///< Radius of the bounding sphere
+	glm::vec3 BoundsMin = glm::vec3(0.0f); ///< Lower corner of the bounding box
+	glm::vec3 BoundsMax = glm::vec3(0.0f); ///< Upper corner of the bounding box
+
+	std::shared_ptr<MeshBVH> Collision; ///< Triangles for ray queries, empty if the mesh is shared
+
+	std::vector<SubmeshAsset> Submeshes; ///< Parts of the mesh
+};
+
+/// Struct that contains header of the .pgrmesh file.
+/**
+	This struct contains fixed size header of the .pgrmesh file.
+	Header is followed by the layout elements, submeshes, packed vertices, packed indices
+	and texture paths of the submeshes, all tightly packed in this order.
+*/
+struct MeshCacheHeader
+{
+	uint32_t Magic; ///< File identifier
+	uint32_t Version; ///< Format version
+	uint64_t SourceHash; ///< Hash of the source OBJ and MTL files
+
+	uint32_t Packing; ///< Quantizer mode the geometry was packed with
+	uint32_t LayoutCount; ///< Number of layout elements
+	uint32_t VertexSize; ///< Size of packed vertices in bytes
+	uint32_t IndexType; ///< Datatype of indices
+	uint32_t IndexCount; ///< Number of indices
+	uint32_t IndexSize; ///< Size of packed indices in bytes
+	uint32_t SubmeshCount; ///< Number of submeshes
+	uint32_t TextureSize; ///< Length of all texture paths
+	uint32_t Passes; ///< Optimizer passes the geometry was optimized with
+	float LodRatio; ///< Triangle ratio between simplified levels
+	float MaxError; ///< Largest collapse error relative to mesh extent
+
+	float Center[3]; ///< Center of the bounding sphere
+	float Radius; ///< Radius of the bounding sphere
+	float BoundsMin[3]; ///< Lower corner of the bounding box
+	float BoundsMax[3]; ///< Upper corner of the bounding box
+};
+
+/// Struct that contains layout element of the .pgrmesh file.
+/**
+	This struct contains fixed size layout element of the .pgrmesh file.
+*/
+struct MeshCacheElement
+{
+	uint32_t Count; ///< Number of components
+	uint32_t Type; ///< Datatype of components
+	uint32_t Normalized; ///< Normalized components
+};
+
+/// Struct that contains submesh of the .pgrmesh file.
+/**
+	This struct contains fixed size submesh of the .pgrmesh file.
+*/
+struct MeshCacheSubmesh
+{
+	uint32_t First; ///< Offset of the first index
+	uint32_t Count; ///< Number of indices
+	int32_t BaseVertex; ///< Offset of the first vertex
+	uint32_t TextureLength; ///< Length of the texture path
+
+	uint32_t LodCount; ///< Number of simplified levels
+	uint32_t LodFirst[MeshSimplifier::LOD_COUNT]; ///< Offsets of the first indices of the levels
+	uint32_t LodIndexCount[MeshSimplifier::LOD_COUNT]; ///< Numbers of indices of the levels
+
+	float Diffuse[3]; ///< Material diffuse
+	float Ambient[3]; ///< Material ambient
+	float Specular[3]; ///< Material specular
+	float Shininess; ///< Material shininess
+};
+
+/// Class that handles binary mesh cache.
+/**
+  This class contains context and functionality of the binary mesh cache.
+  Cache is memory mapped, so its data can be handed directly to the OpenGL buffers.
+*/
+class MeshCache
+{
+public:
+	static constexpr uint32_t MAGIC = 0x4853454D; ///< "MESH" identifier
+	static constexpr uint32_t VERSION = 8; ///< Current format version, bump on any loader change
+	static constexpr uint64_t HASH_BASIS = 14695981039346656037ull; ///< FNV-1a offset basis
+
+private:
+	MappedFile _file; ///< Mapped cache file
+	const MeshCacheHeader* _header; ///< Header inside mapped memory
+
+public:
+	/// Constructor
+	/**
+		Maps the cache file from the given path.
+
+		\param[in] path		Filepath to the cache file.
+	*/
+	MeshCache(const std::string& path);
+	/// Cache validator.
+	/**
+		Returns true if the cache is complete and was built from the source with given hash
+		using given quantizer mode, optimizer passes and current simplifier settings.
+		Zero hash means the source is missing and any complete cache is accepted.
+
+		\param[in] hash		Hash of the source files.
+		\param[in] packing	Current quantizer mode.
+		\param[in] passes	Current optimizer passes.
+	*/
+	bool IsValid(uint64_t hash, uint32_t packing, uint32_t passes) const;
+	/// Header getter.
+	/**
+		Returns header of the cache.
+	*/
+	inline const MeshCacheHeader& GetHeader() const { return *_header; }
+	/// Prefetch cache.
+	/**
+		Pages the whole cache into memory.
+	*/
+	inline void Prefetch() const { _file.Prefetch(); }
+	/// Layout getter.
+	/**
+		Returns vertex layout stored in the cache.
+	*/
+	VertexBufferLayout GetLayout() const;
+	/// Submeshes getter.
+	/**
+		Returns submeshes stored in the cache, including their texture paths.
+	*/
+	std::vector<SubmeshAsset> GetSubmeshes() const;
+	/// Vertices getter.
+	/**
+		Returns packed vertex data stored in the cache.
+	*/
+	const GLubyte* GetVertices() const;
+	/// Indices getter.
+	/**
+		Returns packed index data stored in the cache.
+	*/
+	const GLubyte* GetIndices() const;
+	/// Write cache.
+	/**
+		Writes the mesh data into the cache file.
+
+		\param[in] path		Filepath to the cache file.
+		\param[in] hash		Hash of the source files.
+		\param[in] asset	Parsed mesh data.
+	*/
+	static bool Write(const std::string& path, uint64_t hash, const MeshAsset& asset);
+	/// Cache path getter.
+	/**
+		Returns path of the cache file that belongs to the given source.
+
+		\param[in] path		Filepath to the source OBJ file.
+	*/
+	static std::string GetCachePath(const std::string& path);
+	/// Hash source files.
+	/**
+		Hashes the source OBJ file and all MTL files referenced by it.
+		Returns zero if the source can't be read.
+
+		\param[in] path		Filepath to the source OBJ file.
+	*/
+	static uint64_t HashSource(const std::string& path);
+	/// Hash file.
+	/**
+		Hashes content of the single file. Returns zero if the file can't be read.
+
+		\param[in] path		Filepath to the file.
+	*/
+	static uint64_t HashFile(const std::string& path);
+	/// Hash data.
+	/**
+		Continues the FNV-1a hash with the given data.
+
+		\param[in] data		Data to be hashed.
+		\param[in] size		Size of the data.
+		\param[in] hash		Previous hash value.
+	*/
+	static uint64_t Hash(const char* data, size_t size, uint64_t hash);
+};
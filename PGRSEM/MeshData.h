@@ -12,39 +12,17 @@
 
 #pragma once
 
-#include "VertexArray.h"
-#include "VertexBuffer.h"
-#include "ElementBuffer.h"
+#include "ResourceRegistry.h"
 
 /// Struct that wraps basic object attributes.
 /**
-  This struct contains data context of basic object.
+  This struct contains data context of basic object. Material of the object
+  overrides the material of the first part of its mesh.
 */
-struct MeshData
+struct MeshData : public MaterialData
 {
-	// OpenGL context
-	VertexArray* VAO;
-	VertexBuffer* VB;
-	ElementBuffer* EB;
-	VertexBufferLayout* VBL;
+	// OpenGL context, shared with other objects using the same mesh
+	std::shared_ptr<MeshResource> Mesh;
 
-	// Material context
-	glm::vec3 Diffuse = glm::vec3(0.0f);
-	glm::vec3 Ambient = glm::vec3(0.0f);
-	glm::vec3 Specular = glm::vec3(0.0f);
-
-	GLfloat Shininess;
-	GLuint Texture;
-
-	/// Destructor
-	/**
-		Deletes allocated memory.
-	*/
-	inline ~MeshData()
-	{
-		delete VAO;
-		delete VB;
-		delete EB;
-		delete VBL;
-	}
+	size_t Lod = 0; ///< Level of detail drawn last frame
 };
\ No newline at end of file
@@ -0,0 +1,326 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MeshOptimizer.cpp
+ * \author     Dominik Pupala
+ * \date       2021/23/05
+ * \brief      Source file for mesh optimizer.
+ *
+ *  Source file containing declarations for MeshOptimizer class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "MeshOptimizer.h"
+
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+
+GLuint MeshOptimizer::_passes = MeshOptimizer::PASS_ALL;
+
+void MeshOptimizer::Initialize(GLuint passes)
+{
+	_passes = passes & PASS_ALL;
+}
+
+void MeshOptimizer::Optimize(const std::string& name, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, size_t stride)
+{
+	if (_passes == 0 || stride < 3)
+		return;
+
+	MeshStatistics before = Analyze(indices, vertices.size() / stride);
+
+	if (_passes & PASS_VERTEX_CACHE)
+		OptimizeVertexCache(indices, vertices.size() / stride);
+
+	if (_passes & PASS_OVERDRAW)
+		OptimizeOverdraw(indices, vertices, stride);
+
+	if (_passes & PASS_VERTEX_FETCH)
+		OptimizeVertexFetch(vertices, indices, stride);
+
+	MeshStatistics after = Analyze(indices, vertices.size() / stride);
+
+	std::cout << std::fixed << std::setprecision(3)
+		<< "Optimized " << name << ": ACMR " << before.ACMR << " -> " << after.ACMR
+		<< ", ATVR " << before.ATVR << " -> " << after.ATVR << std::endl;
+}
+
+MeshStatistics MeshOptimizer::Analyze(const std::vector<GLuint>& indices, size_t vertexCount)
+{
+	// vertex is cached while less than FIFO_SIZE misses happened since it was loaded
+	std::vector<size_t> loaded(vertexCount, 0);
+	size_t misses = 0, used = 0;
+
+	for (GLuint index : indices)
+	{
+		if (loaded[index] == 0)
+			++used;
+
+		if (loaded[index] == 0 || misses - loaded[index] >= FIFO_SIZE)
+			loaded[index] = ++misses;
+	}
+
+	size_t triangles = indices.size() / 3;
+
+	return { triangles ? (float)misses / triangles : 0.0f, used ? (float)misses / used : 0.0f };
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+
+	if (triangleCount == 0)
+		return;
+
+	// triangles adjacent to each vertex, live ones are kept at the front of the range
+	std::vector<GLuint> offsets(vertexCount + 1, 0);
+	std::vector<GLuint> valence(vertexCount, 0);
+
+	for (GLuint index : indices)
+		++valence[index];
+
+	for (size_t v = 0; v < vertexCount; ++v)
+		offsets[v + 1] = offsets[v] + valence[v];
+
+	std::vector<GLuint> adjacency(indices.size());
+	std::fill(valence.begin(), valence.end(), 0);
+
+	for (size_t t = 0; t < triangleCount; ++t)
+		for (size_t c = 0; c < 3; ++c)
+		{
+			GLuint v = indices[t * 3 + c];
+			adjacency[offsets[v] + valence[v]++] = (GLuint)t;
+		}
+
+	std::vector<GLint> position(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+
+	for (size_t v = 0; v < vertexCount; ++v)
+		vertexScore[v] = VertexScore(-1, valence[v]);
+
+	GLint best = 0;
+
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+		if (triangleScore[t] > triangleScore[best])
+			best = (GLint)t;
+	}
+
+	std::vector<GLuint> result;
+	std::vector<GLuint> cache, next;
+	size_t cursor = 0;
+
+	result.reserve(indices.size());
+
+	while (result.size() < indices.size())
+	{
+		// no candidate in cache, continue with the first triangle left
+		if (best < 0)
+		{
+			while (emitted[cursor])
+				++cursor;
+
+			best = (GLint)cursor;
+		}
+
+		emitted[best] = true;
+		next.clear();
+
+		for (size_t c = 0; c < 3; ++c)
+		{
+			GLuint v = indices[best * 3 + c];
+			result.push_back(v);
+
+			if (std::find(next.begin(), next.end(), v) == next.end())
+				next.push_back(v);
+
+			// swap the emitted triangle out of the live range
+			GLuint* begin = &adjacency[offsets[v]];
+			GLuint* end = begin + valence[v];
+			GLuint* found = std::find(begin, end, (GLuint)best);
+
+			if (found != end)
+			{
+				std::swap(*found, *(end - 1));
+				--valence[v];
+			}
+		}
+
+		for (GLuint v : cache)
+			if (std::find(next.begin(), next.end(), v) == next.end())
+				next.push_back(v);
+
+		for (size_t i = 0; i < next.size(); ++i)
+		{
+			GLuint v = next[i];
+			position[v] = i < CACHE_SIZE ? (GLint)i : -1;
+			vertexScore[v] = VertexScore(position[v], valence[v]);
+		}
+
+		best = -1;
+		float bestScore = -1.0f;
+
+		for (GLuint v : next)
+			for (GLuint i = 0; i < valence[v]; ++i)
+			{
+				GLuint t = adjacency[offsets[v] + i];
+				triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+
+				if (triangleScore[t] > bestScore)
+				{
+					bestScore = triangleScore[t];
+					best = (GLint)t;
+				}
+			}
+
+		if (next.size() > CACHE_SIZE)
+			next.resize(CACHE_SIZE);
+
+		cache.swap(next);
+	}
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<GLfloat>& vertices, size_t stride)
+{
+	static constexpr size_t MIN_CLUSTER = 16; ///< Minimal number of triangles in cluster
+
+	size_t triangleCount = indices.size() / 3;
+	size_t vertexCount = vertices.size() / stride;
+
+	if (triangleCount == 0)
+		return;
+
+	// clusters start where the FIFO cache restarts, so their order doesn't hurt cache locality
+	std::vector<size_t> clusters(1, 0);
+	std::vector<size_t> loaded(vertexCount, 0);
+	size_t misses = 0;
+
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		size_t triangleMisses = 0;
+
+		for (size_t c = 0; c < 3; ++c)
+		{
+			GLuint index = indices[t * 3 + c];
+
+			if (loaded[index] == 0 || misses - loaded[index] >= FIFO_SIZE)
+			{
+				loaded[index] = ++misses;
+				++triangleMisses;
+			}
+		}
+
+		if (triangleMisses == 3 && t - clusters.back() >= MIN_CLUSTER)
+			clusters.push_back(t);
+	}
+
+	clusters.push_back(triangleCount);
+
+	auto position = [&](GLuint index) { return glm::vec3(vertices[index * stride], vertices[index * stride + 1], vertices[index * stride + 2]); };
+
+	// area weighted centroids and normals of clusters
+	std::vector<glm::vec3> centroids(clusters.size() - 1, glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(clusters.size() - 1, glm::vec3(0.0f));
+	std::vector<float> areas(clusters.size() - 1, 0.0f);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t i = 0; i + 1 < clusters.size(); ++i)
+	{
+		for (size_t t = clusters[i]; t < clusters[i + 1]; ++t)
+		{
+			glm::vec3 a = position(indices[t * 3]);
+			glm::vec3 b = position(indices[t * 3 + 1]);
+			glm::vec3 c = position(indices[t * 3 + 2]);
+
+			glm::vec3 normal = glm::cross(b - a, c - a);
+			float area = glm::length(normal);
+
+			centroids[i] += (a + b + c) * (area / 3.0f);
+			normals[i] += normal;
+			areas[i] += area;
+		}
+
+		meshCentroid += centroids[i];
+		meshArea += areas[i];
+
+		if (areas[i] > 0.0f)
+			centroids[i] /= areas[i];
+	}
+
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	std::vector<float> keys(clusters.size() - 1);
+	std::vector<size_t> order(clusters.size() - 1);
+
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		float length = glm::length(normals[i]);
+		keys[i] = length > 0.0f ? glm::dot(centroids[i] - meshCentroid, normals[i] / length) : 0.0f;
+		order[i] = i;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] > keys[b]; });
+
+	std::vector<GLuint> result;
+	result.reserve(indices.size());
+
+	for (size_t i : order)
+		result.insert(result.end(), indices.begin() + clusters[i] * 3, indices.begin() + clusters[i + 1] * 3);
+
+	indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, size_t stride)
+{
+	static constexpr GLuint UNUSED = ~0u; ///< Vertex not remapped yet
+
+	std::vector<GLuint> remap(vertices.size() / stride, UNUSED);
+	std::vector<GLfloat> result;
+	GLuint next = 0;
+
+	result.reserve(vertices.size());
+
+	for (GLuint& index : indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = next++;
+			result.insert(result.end(), vertices.begin() + index * stride, vertices.begin() + (index + 1) * stride);
+		}
+
+		index = remap[index];
+	}
+
+	vertices.swap(result);
+}
+
+float MeshOptimizer::VertexScore(GLint position, GLuint valence)
+{
+	// no triangles left to use this vertex
+	if (valence == 0)
+		return -1.0f;
+
+	float score = 0.0f;
+
+	if (position >= 0)
+	{
+		// last triangle vertices get fixed score, so the strip doesn't turn back
+		if (position < 3)
+			score = 0.75f;
+		else
+			score = std::pow(1.0f - (float)(position - 3) / (CACHE_SIZE - 3), 1.5f);
+	}
+
+	// low valence vertices are preferred, so they don't stay alone at the end
+	return score + 2.0f / std::sqrt((float)valence);
+}
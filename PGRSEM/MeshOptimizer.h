@@ -0,0 +1,125 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MeshOptimizer.h
+ * \author     Dominik Pupala
+ * \date       2021/23/05
+ * \brief      Header file for mesh optimizer.
+ *
+ *  Header file containing definitions for MeshOptimizer and MeshStatistics classes.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+
+/// Struct that contains vertex cache statistics.
+/**
+	This struct contains vertex cache statistics of the mesh.
+*/
+struct MeshStatistics
+{
+	float ACMR; ///< Average cache miss ratio, transformed vertices per triangle
+	float ATVR; ///< Average transformed to vertex ratio, transformed vertices per vertex
+};
+
+/// Static class that optimizes mesh geometry.
+/**
+  This static class reorders triangles and vertices of the mesh for the GPU.
+  Triangles are reordered for vertex cache locality first, then clusters of them
+  are reordered for lower overdraw and at last vertices are remapped in fetch order.
+  Vertices are expected to start with three float position.
+*/
+class MeshOptimizer
+{
+public:
+	static constexpr GLuint PASS_VERTEX_CACHE = 1; ///< Forsyth triangle reordering
+	static constexpr GLuint PASS_OVERDRAW = 2; ///< Cluster reordering from outside in
+	static constexpr GLuint PASS_VERTEX_FETCH = 4; ///< Vertex remapping in order of first use
+	static constexpr GLuint PASS_ALL = PASS_VERTEX_CACHE | PASS_OVERDRAW | PASS_VERTEX_FETCH; ///< All passes
+
+	static constexpr size_t CACHE_SIZE = 32; ///< Size of the LRU cache used by Forsyth scoring
+	static constexpr size_t FIFO_SIZE = 16; ///< Size of the FIFO cache used by statistics
+
+private:
+	static GLuint _passes; ///< Enabled passes
+
+public:
+	/// Initialize optimizer.
+	/**
+		Enables given passes.
+
+		\param[in] passes	Bit mask of enabled passes.
+	*/
+	static void Initialize(GLuint passes = PASS_ALL);
+	/// Passes getter.
+	/**
+		Returns enabled passes, optimized data are valid only for the same passes.
+	*/
+	static GLuint GetPasses() { return _passes; }
+	/// Optimize mesh.
+	/**
+		Runs enabled passes on the mesh and reports vertex cache statistics before and after.
+
+		\param[in] name				Mesh name used in report.
+		\param[in,out] vertices		Interleaved float vertex data.
+		\param[in,out] indices		Face data.
+		\param[in] stride			Number of floats per vertex.
+	*/
+	static void Optimize(const std::string& name, std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, size_t stride);
+	/// Analyze mesh.
+	/**
+		Simulates FIFO vertex cache and returns its statistics.
+
+		\param[in] indices		Face data.
+		\param[in] vertexCount	Number of vertices.
+	*/
+	static MeshStatistics Analyze(const std::vector<GLuint>& indices, size_t vertexCount);
+	/// Optimize vertex cache.
+	/**
+		Reorders triangles for vertex cache locality using Forsyth scoring.
+
+		\param[in,out] indices	Face data.
+		\param[in] vertexCount	Number of vertices.
+	*/
+	static void OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount);
+	/// Optimize overdraw.
+	/**
+		Splits the cache optimized triangles into clusters and sorts them so the ones
+		facing outwards are drawn first.
+
+		\param[in,out] indices	Face data.
+		\param[in] vertices		Interleaved float vertex data.
+		\param[in] stride		Number of floats per vertex.
+	*/
+	static void OptimizeOverdraw(std::vector<GLuint>& indices, const std::vector<GLfloat>& vertices, size_t stride);
+	/// Optimize vertex fetch.
+	/**
+		Remaps vertices in order of their first use and drops unused ones.
+
+		\param[in,out] vertices		Interleaved float vertex data.
+		\param[in,out] indices		Face data.
+		\param[in] stride			Number of floats per vertex.
+	*/
+	static void OptimizeVertexFetch(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, size_t stride);
+
+private:
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	MeshOptimizer() { }
+	/// Vertex score.
+	/**
+		Returns Forsyth score of the vertex.
+
+		\param[in] position		Position in the LRU cache, negative if not cached.
+		\param[in] valence		Number of triangles not emitted yet.
+	*/
+	static float VertexScore(GLint position, GLuint valence);
+};
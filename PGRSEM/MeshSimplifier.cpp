@@ -0,0 +1,290 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MeshSimplifier.cpp
+ * \author     Dominik Pupala
+ * \date       2021/27/05
+ * \brief      Source file for mesh simplifier.
+ *
+ *  Source file containing declarations for MeshSimplifier class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <map>
+#include <cmath>
+#include <tuple>
+#include <numeric>
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+const GLfloat MeshSimplifier::LOD_SIZES[MeshSimplifier::LOD_COUNT] = { 0.3f, 0.15f, 0.075f };
+
+void MeshSimplifier::Quadric::AddPlane(const glm::vec3& normal, double d)
+{
+	double plane[4] = { normal.x, normal.y, normal.z, d };
+
+	for (size_t row = 0, i = 0; row < 4; ++row)
+		for (size_t column = row; column < 4; ++column)
+			A[i++] += plane[row] * plane[column];
+}
+
+void MeshSimplifier::Quadric::Add(const Quadric& other)
+{
+	for (size_t i = 0; i < 10; ++i)
+		A[i] += other.A[i];
+}
+
+double MeshSimplifier::Quadric::Evaluate(const glm::vec3& point) const
+{
+	double x = point.x, y = point.y, z = point.z;
+
+	// v^T * A * v with v = (x, y, z, 1), off diagonal terms counted twice
+	return A[0] * x * x + 2.0 * A[1] * x * y + 2.0 * A[2] * x * z + 2.0 * A[3] * x
+		+ A[4] * y * y + 2.0 * A[5] * y * z + 2.0 * A[6] * y
+		+ A[7] * z * z + 2.0 * A[8] * z
+		+ A[9];
+}
+
+std::vector<std::vector<GLuint>> MeshSimplifier::GenerateLods(const std::string& name, const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, size_t stride)
+{
+	std::vector<std::vector<GLuint>> lods;
+	size_t vertexCount = stride >= 3 ? vertices.size() / stride : 0;
+
+	if (vertexCount == 0 || indices.empty())
+		return lods;
+
+	glm::vec3 lower(vertices[0], vertices[1], vertices[2]);
+	glm::vec3 upper = lower;
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		glm::vec3 position(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]);
+		lower = glm::min(lower, position);
+		upper = glm::max(upper, position);
+	}
+
+	GLfloat maxError = MAX_ERROR * glm::length(upper - lower);
+
+	std::cout << "Simplified " << name << ": " << indices.size() / 3;
+
+	for (size_t level = 0; level < LOD_COUNT; ++level)
+	{
+		const std::vector<GLuint>& previous = level == 0 ? indices : lods.back();
+		size_t target = (size_t)(indices.size() / 3 * std::pow(LOD_RATIO, level + 1)) * 3;
+
+		std::vector<GLuint> lod = Simplify(vertices, previous, stride, target, maxError);
+
+		// level that barely differs isn't worth the memory, coarser ones would stall as well
+		if (lod.empty() || lod.size() * 10 > previous.size() * 9)
+			break;
+
+		if (MeshOptimizer::GetPasses() & MeshOptimizer::PASS_VERTEX_CACHE)
+			MeshOptimizer::OptimizeVertexCache(lod, vertexCount);
+
+		std::cout << " -> " << lod.size() / 3;
+		lods.push_back(std::move(lod));
+	}
+
+	std::cout << " triangles" << std::endl;
+
+	return lods;
+}
+
+std::vector<GLuint> MeshSimplifier::Simplify(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, size_t stride, size_t targetCount, GLfloat maxError)
+{
+	size_t vertexCount = vertices.size() / stride;
+
+	auto position = [&](GLuint index) { return glm::vec3(vertices[index * stride], vertices[index * stride + 1], vertices[index * stride + 2]); };
+
+	// vertices sharing position differ in attributes, moving one of them would tear the surface
+	std::vector<GLuint> canonical(vertexCount);
+	std::vector<GLubyte> flags(vertexCount, 0);
+	std::map<std::tuple<GLfloat, GLfloat, GLfloat>, GLuint> welded;
+
+	for (GLuint v = 0; v < vertexCount; ++v)
+	{
+		glm::vec3 p = position(v);
+		auto found = welded.emplace(std::make_tuple(p.x, p.y, p.z), v);
+		canonical[v] = found.first->second;
+
+		if (!found.second)
+		{
+			flags[v] |= VERTEX_SEAM;
+			flags[canonical[v]] |= VERTEX_SEAM;
+		}
+	}
+
+	// edges used by single triangle are open, seams are welded so they don't count
+	std::unordered_map<uint64_t, GLuint> edges;
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		for (size_t e = 0; e < 3; ++e)
+		{
+			GLuint a = canonical[indices[i + e]];
+			GLuint b = canonical[indices[i + (e + 1) % 3]];
+			++edges[(uint64_t)std::min(a, b) << 32 | std::max(a, b)];
+		}
+	}
+
+	for (const auto& edge : edges)
+	{
+		if (edge.second == 1)
+		{
+			flags[edge.first >> 32] |= VERTEX_BORDER;
+			flags[edge.first & 0xFFFFFFFF] |= VERTEX_BORDER;
+		}
+	}
+
+	for (GLuint v = 0; v < vertexCount; ++v)
+		flags[v] |= flags[canonical[v]];
+
+	std::vector<Quadric> quadrics(vertexCount);
+
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		glm::vec3 a = position(indices[i]), b = position(indices[i + 1]), c = position(indices[i + 2]);
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		GLfloat length = glm::length(normal);
+
+		if (length == 0.0f)
+			continue;
+
+		normal /= length;
+
+		for (size_t k = 0; k < 3; ++k)
+			quadrics[indices[i + k]].AddPlane(normal, -glm::dot(normal, a));
+	}
+
+	double limit = (double)maxError * maxError;
+	std::vector<GLuint> result(indices);
+
+	while (result.size() > targetCount)
+	{
+		// triangles around each vertex
+		std::vector<GLuint> offsets(vertexCount + 1, 0);
+		std::vector<GLuint> adjacency(result.size());
+
+		for (GLuint index : result)
+			++offsets[index + 1];
+
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		std::vector<GLuint> cursor(offsets.begin(), offsets.end() - 1);
+
+		for (size_t i = 0; i < result.size(); ++i)
+			adjacency[cursor[result[i]]++] = (GLuint)(i / 3);
+
+		// every interior edge is visited once in each direction
+		std::vector<Collapse> collapses;
+
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (size_t e = 0; e < 3; ++e)
+			{
+				GLuint from = result[i + e];
+				GLuint to = result[i + (e + 1) % 3];
+
+				if (flags[from] != 0 || (flags[to] & VERTEX_SEAM))
+					continue;
+
+				Quadric quadric = quadrics[from];
+				quadric.Add(quadrics[to]);
+				double cost = quadric.Evaluate(position(to));
+
+				if (cost <= limit)
+					collapses.push_back({ from, to, cost });
+			}
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.Cost < b.Cost; });
+
+		// each collapse removes two triangles on average
+		size_t needed = (result.size() - targetCount) / 6 + 1;
+		size_t performed = 0;
+
+		std::vector<GLuint> remap(vertexCount);
+		std::iota(remap.begin(), remap.end(), 0);
+		std::vector<bool> touched(vertexCount, false);
+
+		for (const Collapse& collapse : collapses)
+		{
+			if (performed >= needed)
+				break;
+
+			if (touched[collapse.From] || touched[collapse.To])
+				continue;
+
+			bool flipped = false;
+
+			// triangles kept after the collapse must not turn around
+			for (GLuint t = offsets[collapse.From]; t < offsets[collapse.From + 1] && !flipped; ++t)
+			{
+				const GLuint* triangle = &result[adjacency[t] * 3];
+
+				if (triangle[0] == collapse.To || triangle[1] == collapse.To || triangle[2] == collapse.To)
+					continue;
+
+				glm::vec3 before[3], after[3];
+
+				for (size_t c = 0; c < 3; ++c)
+				{
+					before[c] = position(triangle[c]);
+					after[c] = position(triangle[c] == collapse.From ? collapse.To : triangle[c]);
+				}
+
+				glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+				glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+				flipped = glm::dot(normalBefore, normalAfter) <= 0.0f;
+			}
+
+			if (flipped)
+				continue;
+
+			// neighbourhood stays fixed for the rest of the pass, so the flip test holds
+			for (GLuint t = offsets[collapse.From]; t < offsets[collapse.From + 1]; ++t)
+				for (size_t c = 0; c < 3; ++c)
+					touched[result[adjacency[t] * 3 + c]] = true;
+
+			remap[collapse.From] = collapse.To;
+			quadrics[collapse.To].Add(quadrics[collapse.From]);
+			++performed;
+		}
+
+		if (performed == 0)
+			break;
+
+		size_t write = 0;
+
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			GLuint a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+
+			if (a == b || b == c || a == c)
+				continue;
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+
+		result.resize(write);
+	}
+
+	return result;
+}
+
+size_t MeshSimplifier::SelectLod(GLfloat size, size_t current, size_t count)
+{
+	size_t lod = 0;
+
+	// crossing a threshold towards the current level is harder than away from it
+	while (lod + 1 < count && lod < LOD_COUNT && size < LOD_SIZES[lod] * (lod < current ? 1.0f + HYSTERESIS : 1.0f - HYSTERESIS))
+		++lod;
+
+	return lod;
+}
@@ -0,0 +1,128 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       MeshSimplifier.h
+ * \author     Dominik Pupala
+ * \date       2021/27/05
+ * \brief      Header file for mesh simplifier.
+ *
+ *  Header file containing definitions for MeshSimplifier class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "pgr.h"
+
+/// Static class that generates levels of detail.
+/**
+  This static class simplifies meshes by collapsing edges in order of their quadric error.
+  Vertices are only moved onto their neighbours, so the simplified levels are just index
+  data referencing the vertices of the full detail mesh and can share its buffers.
+  Vertices on borders and attribute seams are never moved.
+  Vertices are expected to start with three float position.
+*/
+class MeshSimplifier
+{
+public:
+	static constexpr size_t LOD_COUNT = 3; ///< Simplified levels generated below the full detail one
+	static constexpr GLfloat LOD_RATIO = 0.5f; ///< Triangle ratio between consecutive levels
+	static constexpr GLfloat MAX_ERROR = 0.02f; ///< Largest error of single collapse relative to mesh extent
+	static constexpr GLfloat HYSTERESIS = 0.15f; ///< Relative band around thresholds in which the level is kept
+
+	static const GLfloat LOD_SIZES[LOD_COUNT]; ///< Screen height fractions below which the levels are used
+
+private:
+	/// Struct that contains error quadric.
+	/**
+		This struct contains symmetric 4x4 matrix summing squared distances to planes.
+	*/
+	struct Quadric
+	{
+		double A[10] = {}; ///< Upper triangle of the matrix by rows
+
+		/// Add plane.
+		/**
+			Adds squared distance to the plane.
+
+			\param[in] normal	Unit normal of the plane.
+			\param[in] d		Distance of the plane from origin.
+		*/
+		void AddPlane(const glm::vec3& normal, double d);
+		/// Add quadric.
+		/**
+			Adds other quadric to this one.
+
+			\param[in] other	Added quadric.
+		*/
+		void Add(const Quadric& other);
+		/// Evaluate quadric.
+		/**
+			Returns sum of squared distances of the point to the planes.
+
+			\param[in] point	Evaluated point.
+		*/
+		double Evaluate(const glm::vec3& point) const;
+	};
+
+	/// Struct that contains edge collapse.
+	/**
+		This struct contains candidate collapse of the vertex onto its neighbour.
+	*/
+	struct Collapse
+	{
+		GLuint From; ///< Moved vertex
+		GLuint To; ///< Target vertex
+		double Cost; ///< Quadric error of the collapse
+	};
+
+	static constexpr GLubyte VERTEX_SEAM = 1; ///< Vertex shares position with other vertex
+	static constexpr GLubyte VERTEX_BORDER = 2; ///< Vertex lies on open edge
+
+public:
+	/// Generate levels of detail.
+	/**
+		Simplifies the mesh into LOD_COUNT levels at most, each with LOD_RATIO triangles
+		of the previous one, and reports their triangle counts. Generation stops once
+		the error limit doesn't allow further simplification.
+
+		\param[in] name			Mesh name used in report.
+		\param[in] vertices		Interleaved float vertex data.
+		\param[in] indices		Face data of the full detail mesh.
+		\param[in] stride		Number of floats per vertex.
+	*/
+	static std::vector<std::vector<GLuint>> GenerateLods(const std::string& name, const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, size_t stride);
+	/// Simplify mesh.
+	/**
+		Collapses edges with the lowest error until the mesh has at most the target number
+		of indices or no collapse is within the error limit.
+
+		\param[in] vertices		Interleaved float vertex data.
+		\param[in] indices		Face data.
+		\param[in] stride		Number of floats per vertex.
+		\param[in] targetCount	Target number of indices.
+		\param[in] maxError		Largest allowed distance error of single collapse.
+	*/
+	static std::vector<GLuint> Simplify(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, size_t stride, size_t targetCount, GLfloat maxError);
+	/// Select level of detail.
+	/**
+		Returns level for the given screen size, the current level is kept while
+		the size stays within the hysteresis band around its thresholds.
+
+		\param[in] size		Fraction of the screen height covered by the mesh.
+		\param[in] current	Currently used level.
+		\param[in] count	Number of available levels including the full detail one.
+	*/
+	static size_t SelectLod(GLfloat size, size_t current, size_t count);
+
+private:
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	MeshSimplifier() { }
+};
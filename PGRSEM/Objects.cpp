@@ -12,148 +12,260 @@
 
 #include "Curve.h"
 #include "Objects.h"
+#include "MeshCache.h"
 #include "SkyboxData.h"
 #include "PyramidGenerator.h"
 #include "SpectateParameters.h"
 
+#include <cstdlib>
+#include <numeric>
 #include <iostream>
 
-Pyramid GeneratedPyramid, StonePyramid, QuartzPyramid;
-LandScape Desert;
+EntityRegistry Scene;
+RenderQueue SceneQueue;
+std::vector<std::shared_ptr<PropBatch>> Props;
+
+EntityRegistry::Entity GeneratedPyramid, StonePyramid, QuartzPyramid;
+EntityRegistry::Entity Desert;
+EntityRegistry::Entity Aloe, Cactus0, Cactus1;
+EntityRegistry::Entity Rock0, Rock1;
+EntityRegistry::Entity InfiniteTexture, Billboard;
 MeshData Sky;
-Flora Aloe, Cactus0, Cactus1;
-Rock Rock0, Rock1;
-Plane InfiniteTexture, Billboard;
 Car Player, Police;
 
+static const glm::vec3 StonePyramidPosition = glm::vec3(14.0f, 0.0f, 0.0f);
+static const glm::vec2 GroundLower = glm::vec2(-30.0f, -20.0f);
+static const glm::vec2 GroundUpper = glm::vec2(30.0f, 20.0f);
+static constexpr GLfloat GROUND_CELL_SIZE = 0.25f;
+static std::vector<glm::vec3> Rock0Diffuses;
+static size_t Rock0Index = 0;
+static LightBlock Lights;
+
 Camera Spectate = Camera(glm::vec3(0.0f, 1.0f, 3.0f));
 CameraSystem CameraManager;
 
-void transformUniforms(Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model)
+/// Uniform handles of object shaders.
+static const struct
+{
+	Shader::Uniform TexSampler = Shader::GetUniform("texSampler");
+	Shader::Uniform LightSampler = Shader::GetUniform("lightSampler");
+	Shader::Uniform ClusterSampler = Shader::GetUniform("clusterSampler");
+	Shader::Uniform IndexSampler = Shader::GetUniform("indexSampler");
+	Shader::Uniform Alpha = Shader::GetUniform("alpha");
+	Shader::Uniform Time = Shader::GetUniform("time");
+} Uniforms;
+
+UniformBuffer* FrameUniforms;
+UniformBuffer* LightUniforms;
+UniformBuffer* FogUniforms;
+RingBuffer* ObjectUniforms;
+
+CollisionWorld Collisions;
+Heightfield Ground;
+
+static FrustumCuller EntityCuller;
+static FrustumCuller PropCuller;
+
+void objectUniforms(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model, const MaterialData& material)
 {
-	glm::mat4 PVM = projection * view * model;
 	glm::mat4 modelRotationMatrix = glm::mat4(
 		model[0],
 		model[1],
 		model[2],
 		glm::vec4(0.0f, 0.0f, 0.0f, 1.0f)
 	);
-	glm::mat4 normalMatrix = glm::transpose(glm::inverse(modelRotationMatrix));
 
-	shader.SetUniformMatrix4fv("pvmMatrix", 1, GL_FALSE, glm::value_ptr(PVM));
-	shader.SetUniformMatrix4fv("viewMatrix", 1, GL_FALSE, glm::value_ptr(view));
-	shader.SetUniformMatrix4fv("modelMatrix", 1, GL_FALSE, glm::value_ptr(model));
-	shader.SetUniformMatrix4fv("normalMatrix", 1, GL_FALSE, glm::value_ptr(normalMatrix));
+	ObjectBlock object;
+	object.PVM = projection * view * model;
+	object.Model = model;
+	object.Normal = glm::transpose(glm::inverse(modelRotationMatrix));
+
+	object.Diffuse = material.Diffuse;
+	object.Ambient = material.Ambient;
+	object.Specular = material.Specular;
+	object.Shininess = material.Shininess;
+	object.TexUse = material.Texture ? 1 : 0;
+
+	ObjectUniforms->Push(&object, sizeof(object));
 }
 
-void materialUniforms(Shader& shader, const MeshData& object)
+void initUniformBlocks()
 {
-	shader.SetUniform3fv("material.Diffuse", 1, glm::value_ptr(object.Diffuse));
-	shader.SetUniform3fv("material.Ambient", 1, glm::value_ptr(object.Ambient));
-	shader.SetUniform3fv("material.Specular", 1, glm::value_ptr(object.Specular));
-	shader.SetUniform1f("material.Shininess", object.Shininess);
+	FrameUniforms = new UniformBuffer(sizeof(FrameBlock), FrameBlock::BINDING);
+	LightUniforms = new UniformBuffer(sizeof(LightBlock), LightBlock::BINDING);
+	FogUniforms = new UniformBuffer(sizeof(FogBlock), FogBlock::BINDING);
+	ObjectUniforms = new RingBuffer(ObjectBlock::CAPACITY * sizeof(ObjectBlock), ObjectBlock::BINDING);
+
+	Lights.Sunlight.Diffuse = glm::vec3(1.0f, 1.0f, 0.3f);
+	Lights.Sunlight.Ambient = glm::vec3(0.13f, 0.13f, 0.13f);
+	Lights.Sunlight.Specular = glm::vec3(1.0f, 1.0f, 1.0f);
+	Lights.Sunlight.Position = glm::vec3(13.873f, 35.399f, -21.242f);
+
+	// sun doesn't move, single upload serves every frame
+	LightUniforms->SetData(&Lights, sizeof(Lights));
+}
 
-	if (object.Texture != 0)
-	{
-		shader.SetUniform1i("texUse", 1);
-		shader.SetUniform1i("texSampler", 0);
-		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, object.Texture);
-	}
-	else
-	{
-		shader.SetUniform1i("texUse", 0);
-	}
+void bindUniformBlocks(Shader& shader)
+{
+	shader.BindBlock("FrameData", FrameBlock::BINDING);
+	shader.BindBlock("LightData", LightBlock::BINDING);
+	shader.BindBlock("FogData", FogBlock::BINDING);
+	shader.BindBlock("ObjectData", ObjectBlock::BINDING);
+	shader.BindBlock("ClusterData", ClusterBlock::BINDING);
+
+	// textured parts always sample the first unit, light list stays on its own units
+	shader.Bind();
+	shader.SetUniform1i(Uniforms.TexSampler, 0);
+	shader.SetUniform1i(Uniforms.LightSampler, LightClusters::LIGHT_UNIT);
+	shader.SetUniform1i(Uniforms.ClusterSampler, LightClusters::GRID_UNIT);
+	shader.SetUniform1i(Uniforms.IndexSampler, LightClusters::INDEX_UNIT);
 }
 
-void lightUniforms(Shader& shader, const Camera& camera)
+void updateUniformBlocks(const glm::mat4& projection, const glm::mat4& view, const Camera& camera)
 {
-	shader.SetUniform3fv("cameraPosition", 1, glm::value_ptr(camera.GetPosition()));
+	FrameBlock frame;
+	frame.Projection = projection;
+	frame.View = view;
+	frame.PV = projection * view;
+	frame.CameraPosition = camera.GetPosition();
 
-	shader.SetUniform3f("sunlight.Diffuse", 1.0f, 1.0f, 0.3f);
-	shader.SetUniform3f("sunlight.Ambient", 0.13f, 0.13f, 0.13f);
-	shader.SetUniform3f("sunlight.Specular", 1.0f, 1.0f, 1.0f);
-	shader.SetUniform3f("sunlight.Position", 13.873f, 35.399f, -21.242f);
+	FogBlock fog;
+	fog.Color = glm::vec3(1.0f, 0.85f, 0.75f);
+	fog.Density = 0.07f + 0.03f * cos(CameraManager.CurrentTime / 3);
+	fog.Gradient = 0.5f + 0.75f * sin(CameraManager.CurrentTime / 3);
 
-	shader.SetUniform3f("spotlight.Diffuse", 1.0f, 1.0f, 1.0f);
-	shader.SetUniform3f("spotlight.Ambient", 0.13f, 0.13f, 0.13f);
-	shader.SetUniform3f("spotlight.Specular", 1.0f, 1.0f, 1.0f);
-	shader.SetUniform3f("spotlight.Position", 4.47f, 2.69f, 1.2f);
-	shader.SetUniform3f("spotlight.Direction", 3.0f, 1.3f, -1.0f);
-	shader.SetUniform1f("spotlight.CutoffInn", 0.91f);
-	shader.SetUniform1f("spotlight.CutoffOut", 0.82f);
+	FrameUniforms->SetData(&frame, sizeof(frame));
+	FogUniforms->SetData(&fog, sizeof(fog));
 
-	shader.SetUniform3f("pointlight.Diffuse", 1.0f, 1.0f, 1.0f);
-	shader.SetUniform3f("pointlight.Ambient", 0.13f, 0.13f, 0.13f);
-	shader.SetUniform3f("pointlight.Specular", 1.0f, 1.0f, 1.0f);
-	shader.SetUniform3f("pointlight.Position", 0.0f, 10.0f, -13.0f);
-	shader.SetUniform1f("pointlight.Constant", 0.05f);
-	shader.SetUniform1f("pointlight.Linear", 0.09f);
-	shader.SetUniform1f("pointlight.Quadratic", 0.0032f);
+	ObjectUniforms->BeginFrame();
 }
 
-void fogUniforms(Shader& shader)
+void cleanupUniformBlocks()
 {
-	shader.SetUniform3f("fog.Color", 1.0f, 0.85f, 0.75f);
-	shader.SetUniform1f("fog.Density", 0.07f + 0.03f * cos(CameraManager.CurrentTime / 3));
-	shader.SetUniform1f("fog.Gradient", 0.5f + 0.75f * sin(CameraManager.CurrentTime / 3));
+	delete FrameUniforms;
+	delete LightUniforms;
+	delete FogUniforms;
+	delete ObjectUniforms;
 }
 
-void setBuffers(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, const std::vector<GLuint>& sequence, MeshData& outObject)
+GLfloat screenSize(const MeshResource& mesh, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model)
 {
-	outObject.VB = new VertexBuffer(&vertices[0], vertices.size() * sizeof(float));
-	outObject.EB = new ElementBuffer(&indices[0], indices.size());
+	if (mesh.Radius <= 0.0f)
+		return 1.0f;
 
-	outObject.VBL = new VertexBufferLayout();
+	glm::vec4 center = view * model * glm::vec4(mesh.Center, 1.0f);
+	GLfloat scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+	GLfloat radius = mesh.Radius * scale;
+	GLfloat distance = glm::length(glm::vec3(center));
 
-	for (size_t i = 0; i < sequence.size(); ++i)
-		outObject.VBL->Push<float>(sequence[i]);
+	// camera inside the bounding sphere sees the mesh in full detail
+	if (distance <= radius)
+		return 1.0f;
 
-	outObject.VAO = new VertexArray();
-	outObject.VAO->AddBuffer(*outObject.VB, *outObject.VBL);
+	// projected diameter over screen height, projection[1][1] is cotangent of half the vertical fov
+	return radius * projection[1][1] / distance;
 }
 
-void loadMeshGeometry(const aiMesh& mesh, MeshData& outObject)
+void submitEntity(RenderQueue& queue, EntityRegistry::Entity entity, const glm::mat4& projection, const glm::mat4& view)
 {
-	std::vector<GLuint> indices;
-	std::vector<GLfloat> vertices;
+	const MeshResource& mesh = *Scene.Meshes[entity];
+	const glm::mat4& model = Scene.Transforms[entity];
+
+	Scene.Lods[entity] = MeshSimplifier::SelectLod(screenSize(mesh, projection, view, model), Scene.Lods[entity], mesh.GetLodCount());
+
+	BlendMode blend = BlendMode::NONE;
+
+	if (Scene.Flags[entity] & EntityRegistry::FLAG_ADDITIVE)
+		blend = BlendMode::ADDITIVE;
+	else if (Scene.Flags[entity] & EntityRegistry::FLAG_TRANSPARENT)
+		blend = BlendMode::ALPHA;
+
+	GLfloat depth = -(view * model * glm::vec4(mesh.Center, 1.0f)).z;
+
+	for (size_t i = 0; i < mesh.Submeshes.size(); ++i)
+	{
+		// material of the entity overrides the first part
+		const MaterialData& material = i == 0 ? Scene.Materials[entity] : mesh.Submeshes[i].Material;
+
+		queue.Submit(*Scene.Shaders[entity], mesh, mesh.Submeshes[i], Scene.Lods[entity], material, depth, blend, entity);
+	}
+}
+
+void setBuffers(const GLvoid* vertices, GLsizeiptr vertexSize, const GLvoid* indices, GLuint indexCount, GLenum indexType, const VertexBufferLayout& layout, MeshData& outObject)
+{
+	outObject.Mesh = std::make_shared<MeshResource>();
+	MeshResource& mesh = *outObject.Mesh;
 
+	// parts of pooled mesh need base vertex to reach their vertices
+	if (Renderer::HasBaseVertex() && GeometryPool::Allocate(vertices, vertexSize, indices, indexCount, indexType, layout, mesh))
+		return;
+
+	mesh.VB = new VertexBuffer(vertices, vertexSize);
+	mesh.EB = new ElementBuffer(indices, indexCount, indexType);
+
+	mesh.VBL = new VertexBufferLayout(layout);
+
+	mesh.VAO = new VertexArray();
+	mesh.VAO->AddBuffer(*mesh.VB, *mesh.VBL);
+
+	mesh.Size = vertexSize + indexCount * VertexBufferElement::GetSizeOfType(indexType);
+
+	// single part covering all indices, callers with more parts replace it
+	mesh.Submeshes.resize(1);
+	mesh.Submeshes[0].Count = indexCount;
+}
+
+void setBuffers(const PackedMesh& mesh, MeshData& outObject)
+{
+	VertexBufferLayout layout;
+
+	for (const auto& element : mesh.Layout)
+		layout.Push(element.Count, element.Type, element.Normalized);
+
+	setBuffers(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.IndexCount, mesh.IndexType, layout, outObject);
+}
+
+void setBuffers(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, const std::vector<GLuint>& sequence, MeshData& outObject)
+{
+	setBuffers(VertexQuantizer::Pack(vertices, indices, sequence), outObject);
+}
+
+void loadMeshGeometry(const aiMesh& mesh, std::vector<GLfloat>& outVertices, std::vector<GLuint>& outIndices)
+{
 	for (size_t i = 0; i < mesh.mNumVertices; ++i)
 	{
-		vertices.push_back(mesh.mVertices[i].x);
-		vertices.push_back(mesh.mVertices[i].y);
-		vertices.push_back(mesh.mVertices[i].z);
+		outVertices.push_back(mesh.mVertices[i].x);
+		outVertices.push_back(mesh.mVertices[i].y);
+		outVertices.push_back(mesh.mVertices[i].z);
 
 		if (mesh.HasNormals())
 		{
-			vertices.push_back(mesh.mNormals[i].x);
-			vertices.push_back(mesh.mNormals[i].y);
-			vertices.push_back(mesh.mNormals[i].z);
+			outVertices.push_back(mesh.mNormals[i].x);
+			outVertices.push_back(mesh.mNormals[i].y);
+			outVertices.push_back(mesh.mNormals[i].z);
 		}
 
 		if (mesh.HasTextureCoords(0))
 		{
-			vertices.push_back(mesh.mTextureCoords[0][i].x);
-			vertices.push_back(mesh.mTextureCoords[0][i].y);
+			outVertices.push_back(mesh.mTextureCoords[0][i].x);
+			outVertices.push_back(mesh.mTextureCoords[0][i].y);
 		}
 		else
 		{
-			vertices.push_back(0.0f);
-			vertices.push_back(0.0f);
+			outVertices.push_back(0.0f);
+			outVertices.push_back(0.0f);
 		}
 	}
 
 	for (size_t i = 0; i < mesh.mNumFaces; ++i)
 	{
-		indices.push_back(mesh.mFaces[i].mIndices[0]);
-		indices.push_back(mesh.mFaces[i].mIndices[1]);
-		indices.push_back(mesh.mFaces[i].mIndices[2]);
+		outIndices.push_back(mesh.mFaces[i].mIndices[0]);
+		outIndices.push_back(mesh.mFaces[i].mIndices[1]);
+		outIndices.push_back(mesh.mFaces[i].mIndices[2]);
 	}
-
-	setBuffers(vertices, indices, { 3, 3, 2 }, outObject);
 }
 
-void loadMeshMaterial(const aiMaterial& material, const std::string& path, MeshData& outObject)
+void loadMeshMaterial(const aiMaterial& material, const std::string& path, SubmeshAsset& outAsset)
 {
 	aiColor4D color;
 	aiString name;
@@ -163,13 +275,13 @@ void loadMeshMaterial(const aiMaterial& material, const std::string& path, MeshD
 	material.Get(AI_MATKEY_NAME, name);
 
 	if (aiGetMaterialColor(&material, AI_MATKEY_COLOR_DIFFUSE, &color) == AI_SUCCESS)
-		outObject.Diffuse = glm::vec3(color.r, color.g, color.b);
+		outAsset.Diffuse = glm::vec3(color.r, color.g, color.b);
 
 	if (aiGetMaterialColor(&material, AI_MATKEY_COLOR_AMBIENT, &color) == AI_SUCCESS)
-		outObject.Ambient = glm::vec3(color.r, color.g, color.b);
+		outAsset.Ambient = glm::vec3(color.r, color.g, color.b);
 
 	if (aiGetMaterialColor(&material, AI_MATKEY_COLOR_SPECULAR, &color) == AI_SUCCESS)
-		outObject.Specular = glm::vec3(color.r, color.g, color.b);
+		outAsset.Specular = glm::vec3(color.r, color.g, color.b);
 
 	if (aiGetMaterialFloatArray(&material, AI_MATKEY_SHININESS, &shininess, &(max = 1)) != AI_SUCCESS)
 		shininess = 1.0f;
@@ -177,75 +289,541 @@ void loadMeshMaterial(const aiMaterial& material, const std::string& path, MeshD
 	if (aiGetMaterialFloatArray(&material, AI_MATKEY_SHININESS_STRENGTH, &strength, &(max = 1)) != AI_SUCCESS)
 		strength = 1.0f;
 
-	outObject.Shininess = shininess * strength;
-	outObject.Texture = 0;
+	outAsset.Shininess = shininess * strength;
+	outAsset.Texture.clear();
 
 	if (material.GetTextureCount(aiTextureType_DIFFUSE) < 1)
 		return;
 
 	aiString temp;
 	aiReturn texFound = material.GetTexture(aiTextureType_DIFFUSE, 0, &temp);
-	std::string textureName = temp.data;
+	outAsset.Texture = temp.data;
 
 	size_t found = path.find_last_of("/\\");
 
 	if (found != std::string::npos)
-		textureName.insert(0, path.substr(0, found + 1));
+		outAsset.Texture.insert(0, path.substr(0, found + 1));
+}
 
-	outObject.Texture = pgr::createTexture(textureName);
+void loadMeshBounds(const std::vector<GLfloat>& vertices, size_t stride, glm::vec3& outLower, glm::vec3& outUpper, glm::vec3& outCenter, GLfloat& outRadius)
+{
+	size_t count = vertices.size() / stride;
+
+	if (count == 0)
+		return;
+
+	glm::vec3 lower(vertices[0], vertices[1], vertices[2]);
+	glm::vec3 upper = lower;
+
+	for (size_t v = 1; v < count; ++v)
+	{
+		glm::vec3 position(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]);
+		lower = glm::min(lower, position);
+		upper = glm::max(upper, position);
+	}
+
+	outLower = lower;
+	outUpper = upper;
+	outCenter = (lower + upper) * 0.5f;
+	outRadius = 0.0f;
+
+	for (size_t v = 0; v < count; ++v)
+		outRadius = std::max(outRadius, glm::length(glm::vec3(vertices[v * stride], vertices[v * stride + 1], vertices[v * stride + 2]) - outCenter));
 }
 
-bool loadMesh(const std::string& path, MeshData& outObject)
+std::shared_ptr<TextureResource> loadMeshTexture(const std::string& texture)
+{
+	return texture.empty() ? nullptr : ResourceRegistry::AcquireTexture(texture);
+}
+
+std::vector<GLuint> rebaseIndices(const GLvoid* indices, GLuint indexCount, GLenum indexType, const std::vector<SubmeshAsset>& submeshes)
+{
+	std::vector<GLuint> rebased(indexCount);
+
+	for (const auto& submesh : submeshes)
+	{
+		// simplified levels share the base vertex of the part
+		std::vector<IndexRange> ranges(submesh.Lods);
+		ranges.push_back(IndexRange());
+		ranges.back().First = submesh.First;
+		ranges.back().Count = submesh.Count;
+
+		for (const auto& range : ranges)
+		{
+			for (GLuint i = range.First; i < range.First + range.Count; ++i)
+			{
+				GLuint index = indexType == GL_UNSIGNED_SHORT ? static_cast<const GLushort*>(indices)[i] : static_cast<const GLuint*>(indices)[i];
+				rebased[i] = index + submesh.BaseVertex;
+			}
+		}
+	}
+
+	return rebased;
+}
+
+void loadMeshCollision(MeshAsset& outAsset)
+{
+	const GLvoid* vertices = outAsset.Cache ? outAsset.Cache->GetVertices() : outAsset.Geometry.Vertices.data();
+	const GLvoid* indices = outAsset.Cache ? outAsset.Cache->GetIndices() : outAsset.Geometry.Indices.data();
+	GLsizeiptr vertexSize = outAsset.Cache ? outAsset.Cache->GetHeader().VertexSize : outAsset.Geometry.Vertices.size();
+	GLenum indexType = outAsset.Cache ? outAsset.Cache->GetHeader().IndexType : outAsset.Geometry.IndexType;
+
+	VertexBufferLayout layout;
+
+	if (outAsset.Cache)
+		layout = outAsset.Cache->GetLayout();
+	else
+		for (const auto& element : outAsset.Geometry.Layout)
+			layout.Push(element.Count, element.Type, element.Normalized);
+
+	std::vector<GLuint> triangles;
+
+	// simplified levels would only add coarser copies of the same surface
+	for (const auto& submesh : outAsset.Submeshes)
+	{
+		for (GLuint i = submesh.First; i < submesh.First + submesh.Count; ++i)
+		{
+			GLuint index = indexType == GL_UNSIGNED_SHORT ? static_cast<const GLushort*>(indices)[i] : static_cast<const GLuint*>(indices)[i];
+			triangles.push_back(index + submesh.BaseVertex);
+		}
+	}
+
+	outAsset.Collision = std::make_shared<MeshBVH>();
+	outAsset.Collision->Build(VertexQuantizer::UnpackPositions(vertices, vertexSize, layout), std::move(triangles));
+}
+
+bool loadMeshCache(const std::string& path, uint64_t hash, MeshAsset& outAsset)
+{
+	auto cache = std::make_shared<MeshCache>(MeshCache::GetCachePath(path));
+
+	if (!cache->IsValid(hash, VertexQuantizer::GetMode(), MeshOptimizer::GetPasses()))
+		return false;
+
+	const MeshCacheHeader& header = cache->GetHeader();
+
+	outAsset.Center = glm::vec3(header.Center[0], header.Center[1], header.Center[2]);
+	outAsset.Radius = header.Radius;
+	outAsset.BoundsMin = glm::vec3(header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2]);
+	outAsset.BoundsMax = glm::vec3(header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2]);
+	outAsset.Submeshes = cache->GetSubmeshes();
+
+	// geometry stays mapped, pages are faulted in here instead of during upload
+	cache->Prefetch();
+	outAsset.Cache = cache;
+
+	return true;
+}
+
+bool parseMesh(const std::string& path, MeshAsset& outAsset)
 {
+	uint64_t hash = MeshCache::HashSource(path);
+
+	outAsset.Source = path;
+	outAsset.SourceHash = hash;
+
+	// same mesh is uploaded already, there is nothing to parse
+	if ((outAsset.Shared = ResourceRegistry::FindMesh(path, hash)))
+		return true;
+
+	if (loadMeshCache(path, hash, outAsset))
+	{
+		loadMeshCollision(outAsset);
+		return true;
+	}
+
 	Assimp::Importer importer;
 
 	importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
 	const aiScene* scn = importer.ReadFile(path.c_str(), 0 | aiProcess_Triangulate | aiProcess_PreTransformVertices | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices);
 
-	if (scn == NULL || scn->mNumMeshes != 1)
+	if (scn == NULL || scn->mNumMeshes < 1)
 		return false;
 
-	loadMeshGeometry(*scn->mMeshes[0], outObject);
-	loadMeshMaterial(*scn->mMaterials[scn->mMeshes[0]->mMaterialIndex], path, outObject);
+	// position, normal and texture coordinates
+	static const std::vector<GLuint> sequence = { 3, 3, 2 };
+	static const size_t stride = std::accumulate(sequence.begin(), sequence.end(), (size_t)0);
+
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+
+	// pretransformed scene has one mesh per material, all of them share the buffers
+	for (unsigned int i = 0; i < scn->mNumMeshes; ++i)
+	{
+		std::vector<GLfloat> partVertices;
+		std::vector<GLuint> partIndices;
+
+		std::string name = scn->mNumMeshes > 1 ? path + " [" + std::to_string(i) + "]" : path;
+
+		loadMeshGeometry(*scn->mMeshes[i], partVertices, partIndices);
+		MeshOptimizer::Optimize(name, partVertices, partIndices, stride);
+
+		SubmeshAsset submesh;
+		submesh.First = (GLuint)indices.size();
+		submesh.Count = (GLuint)partIndices.size();
+		submesh.BaseVertex = (GLint)(vertices.size() / stride);
+
+		loadMeshMaterial(*scn->mMaterials[scn->mMeshes[i]->mMaterialIndex], path, submesh);
+
+		// indices stay relative to the part, base vertex is applied on draw
+		vertices.insert(vertices.end(), partVertices.begin(), partVertices.end());
+		indices.insert(indices.end(), partIndices.begin(), partIndices.end());
+
+		// simplified levels follow the full detail one in the same buffer
+		for (const auto& lod : MeshSimplifier::GenerateLods(name, partVertices, partIndices, stride))
+		{
+			IndexRange range;
+			range.First = (GLuint)indices.size();
+			range.Count = (GLuint)lod.size();
+			submesh.Lods.push_back(range);
+
+			indices.insert(indices.end(), lod.begin(), lod.end());
+		}
+
+		outAsset.Submeshes.push_back(submesh);
+	}
+
+	loadMeshBounds(vertices, stride, outAsset.BoundsMin, outAsset.BoundsMax, outAsset.Center, outAsset.Radius);
+	outAsset.Geometry = VertexQuantizer::Pack(vertices, indices, sequence);
+	loadMeshCollision(outAsset);
+
+	if (!MeshCache::Write(MeshCache::GetCachePath(path), hash, outAsset))
+		std::cout << "writing mesh cache for " << path << " has failed!" << std::endl;
 
 	return true;
 }
 
-void drawLights(Shader& shader)
+void uploadMesh(const MeshAsset& asset, MeshData& outObject)
 {
-	shader.Bind();
-	lightUniforms(shader, *CameraManager.Current);
+	// same mesh may have been uploaded while this one was parsed
+	outObject.Mesh = asset.Shared ? asset.Shared : ResourceRegistry::FindMesh(asset.Source, asset.SourceHash);
+
+	if (!outObject.Mesh)
+	{
+		// mapped data goes straight to the buffers, no intermediate copy
+		const GLvoid* vertices = asset.Cache ? asset.Cache->GetVertices() : asset.Geometry.Vertices.data();
+		const GLvoid* indices = asset.Cache ? asset.Cache->GetIndices() : asset.Geometry.Indices.data();
+		GLsizeiptr vertexSize = asset.Cache ? asset.Cache->GetHeader().VertexSize : asset.Geometry.Vertices.size();
+		GLuint indexCount = asset.Cache ? asset.Cache->GetHeader().IndexCount : asset.Geometry.IndexCount;
+		GLenum indexType = asset.Cache ? asset.Cache->GetHeader().IndexType : asset.Geometry.IndexType;
+
+		VertexBufferLayout layout;
+
+		if (asset.Cache)
+			layout = asset.Cache->GetLayout();
+		else
+			for (const auto& element : asset.Geometry.Layout)
+				layout.Push(element.Count, element.Type, element.Normalized);
+
+		// without base vertex draws the parts are offset here, indices may outgrow 16 bits
+		std::vector<GLuint> rebased;
+
+		if (!Renderer::HasBaseVertex() && asset.Submeshes.size() > 1)
+		{
+			rebased = rebaseIndices(indices, indexCount, indexType, asset.Submeshes);
+			indices = rebased.data();
+			indexType = GL_UNSIGNED_INT;
+		}
+
+		setBuffers(vertices, vertexSize, indices, indexCount, indexType, layout, outObject);
+
+		// single part spans the ranges given to the mesh, zero for its own buffers
+		Submesh block = outObject.Mesh->Submeshes[0];
+
+		outObject.Mesh->Center = asset.Center;
+		outObject.Mesh->Radius = asset.Radius;
+		outObject.Mesh->BoundsMin = asset.BoundsMin;
+		outObject.Mesh->BoundsMax = asset.BoundsMax;
+		outObject.Mesh->Collision = asset.Collision;
+		outObject.Mesh->Submeshes.clear();
+
+		for (const auto& part : asset.Submeshes)
+		{
+			Submesh submesh;
+			submesh.First = block.First + part.First;
+			submesh.Count = part.Count;
+			submesh.BaseVertex = block.BaseVertex + (rebased.empty() ? part.BaseVertex : 0);
+			submesh.Lods = part.Lods;
+
+			for (IndexRange& range : submesh.Lods)
+				range.First += block.First;
+
+			submesh.Material.Diffuse = part.Diffuse;
+			submesh.Material.Ambient = part.Ambient;
+			submesh.Material.Specular = part.Specular;
+			submesh.Material.Shininess = part.Shininess;
+			submesh.Material.Texture = loadMeshTexture(part.Texture);
+
+			outObject.Mesh->Submeshes.push_back(submesh);
+		}
+
+		ResourceRegistry::AddMesh(asset.Source, asset.SourceHash, outObject.Mesh);
+	}
+
+	// objects start with the default material of the first part
+	static_cast<MaterialData&>(outObject) = outObject.Mesh->Submeshes[0].Material;
 }
 
-void drawFog(Shader& shader)
+bool loadMesh(const std::string& path, MeshData& outObject)
 {
-	shader.Bind();
-	fogUniforms(shader);
+	MeshAsset asset;
+
+	if (!parseMesh(path, asset))
+		return false;
+
+	uploadMesh(asset, outObject);
+
+	return true;
+}
+
+void loadMeshAsync(AssetLoader& loader, const std::string& path, MeshData& outObject, std::function<void(bool)> done)
+{
+	auto asset = std::make_shared<MeshAsset>();
+
+	loader.Enqueue(path,
+		[path, asset]() { return parseMesh(path, *asset); },
+		[asset, &outObject, done](bool loaded)
+		{
+			if (loaded)
+				uploadMesh(*asset, outObject);
+
+			done(loaded);
+		});
+}
+
+void loadEntitiesAsync(AssetLoader& loader, const std::string& path, const std::vector<EntityRegistry::Entity>& entities, std::function<void(bool)> done)
+{
+	auto asset = std::make_shared<MeshAsset>();
+
+	loader.Enqueue(path,
+		[path, asset]() { return parseMesh(path, *asset); },
+		[asset, entities, done](bool loaded)
+		{
+			if (loaded)
+			{
+				MeshData object;
+				uploadMesh(*asset, object);
+
+				for (EntityRegistry::Entity entity : entities)
+					Scene.SetMesh(entity, object);
+			}
+
+			done(loaded);
+		});
+}
+
+void loadPyramidAsync(AssetLoader& loader, unsigned int layers, EntityRegistry::Entity entity)
+{
+	auto pyramid = std::make_shared<PackedMesh>();
+	auto bounds = std::make_shared<PyramidData>();
+	auto collision = std::make_shared<MeshBVH>();
+
+	loader.Enqueue("pyramid (" + std::to_string(layers) + " layers)",
+		[pyramid, bounds, collision, layers]()
+		{
+			PyramidData data = PyramidGenerator::Generate(layers);
+			*pyramid = VertexQuantizer::Pack(data.Vertices, data.Triangles, { 3, 3 });
+
+			std::vector<glm::vec3> positions;
+
+			for (size_t i = 0; i + 2 < data.Vertices.size(); i += 6)
+				positions.push_back(glm::vec3(data.Vertices[i], data.Vertices[i + 1], data.Vertices[i + 2]));
+
+			collision->Build(std::move(positions), data.Triangles);
+
+			// packed mesh keeps no positions to measure, bounds come from the generator
+			data.Vertices.clear();
+			data.Triangles.clear();
+			*bounds = std::move(data);
+			return true;
+		},
+		[pyramid, bounds, collision, entity](bool)
+		{
+			MeshData object;
+			setBuffers(*pyramid, object);
+
+			object.Mesh->BoundsMin = bounds->BoundsMin;
+			object.Mesh->BoundsMax = bounds->BoundsMax;
+			object.Mesh->Center = bounds->Center;
+			object.Mesh->Radius = bounds->Radius;
+			object.Mesh->Collision = collision;
+
+			Scene.Meshes[entity] = object.Mesh;
+		});
+}
+
+void loadPropsAsync(AssetLoader& loader, const std::string& path, std::shared_ptr<PropBatch> batch, Shader& shader, std::function<void(bool)> done)
+{
+	auto asset = std::make_shared<MeshAsset>();
+
+	loader.Enqueue(path,
+		[path, asset]() { return parseMesh(path, *asset); },
+		[asset, batch, &shader, done](bool loaded)
+		{
+			GLint location = shader.GetAttribLocation("instanceModel");
+
+			if (!loaded || location < 0)
+			{
+				done(false);
+				return;
+			}
+
+			MeshData object;
+			uploadMesh(*asset, object);
+
+			batch->Mesh = object.Mesh;
+			batch->Material = object;
+			batch->Instances = new VertexBuffer(batch->Transforms.data(), batch->Transforms.size() * sizeof(glm::mat4));
+
+			// mat4 attribute takes four consecutive locations
+			VertexBufferLayout layout(1);
+
+			for (size_t column = 0; column < 4; ++column)
+				layout.Push<GLfloat>(4);
+
+			batch->VAO = new VertexArray();
+			batch->VAO->AddBuffer(*batch->Mesh->VB, *batch->Mesh->VBL);
+			batch->VAO->AddBuffer(*batch->Instances, layout, location);
+
+			done(true);
+		});
+}
+
+void placeEntity(EntityRegistry::Entity entity, const glm::vec3& position, float lift, const glm::vec3& scale)
+{
+	glm::mat4 model = glm::mat4(1.0f);
+	model = glm::translate(model, position + glm::vec3(0.0f, lift, 0.0f));
+	model = glm::scale(model, scale);
+
+	Scene.Transforms[entity] = model;
+}
+
+void prepareEntities(const glm::mat4& projection, const glm::mat4& view)
+{
+	SceneQueue.Clear();
+	EntityCuller.Clear();
+
+	std::vector<EntityRegistry::Entity> culled;
+
+	for (EntityRegistry::Entity i = 0; i < Scene.GetCount(); ++i)
+	{
+		if (!Scene.Meshes[i] || !(Scene.Flags[i] & EntityRegistry::FLAG_VISIBLE))
+			continue;
+
+		const MeshResource& mesh = *Scene.Meshes[i];
+
+		// meshes without bounds can't be culled
+		if (mesh.Radius <= 0.0f)
+		{
+			submitEntity(SceneQueue, i, projection, view);
+			continue;
+		}
+
+		// pulsing vertices leave the bounds of the mesh
+		GLfloat pad = Scene.Effects[i] == EntityRegistry::Effect::PULSE ? 0.5f : 0.0f;
+
+		EntityCuller.Add(Scene.Transforms[i], mesh.BoundsMin - pad, mesh.BoundsMax + pad, mesh.Center, mesh.Radius + pad);
+		culled.push_back(i);
+	}
+
+	EntityCuller.Cull(Camera::ExtractFrustum(projection * view));
+
+	for (size_t i = 0; i < culled.size(); ++i)
+	{
+		if (EntityCuller.IsVisible(i))
+			submitEntity(SceneQueue, culled[i], projection, view);
+	}
+
+	// all passes of the frame draw the same order
+	SceneQueue.Sort();
+}
+
+void drawEntitiesDepth(const glm::mat4& projection, const glm::mat4& view, Renderer& renderer, const DepthPrepass& prepass)
+{
+	renderer.ExecuteDepth(SceneQueue, prepass, [&](const DrawItem& item)
+	{
+		objectUniforms(projection, view, Scene.Transforms[item.Owner], *item.Material);
+	});
+}
+
+void drawEntitiesGeometry(const glm::mat4& projection, const glm::mat4& view, Renderer& renderer, const DeferredShading& deferred)
+{
+	renderer.ExecuteGeometry(SceneQueue, deferred, [&](const DrawItem& item)
+	{
+		objectUniforms(projection, view, Scene.Transforms[item.Owner], *item.Material);
+	});
+}
+
+void drawEntities(const glm::mat4& projection, const glm::mat4& view, Renderer& renderer, const DepthPrepass& prepass, const DeferredShading& deferred, float elapsedTime)
+{
+	renderer.Execute(SceneQueue, [&](const DrawItem& item)
+	{
+		Shader& shader = *item.Program;
+		bool animated = (Scene.Flags[item.Owner] & EntityRegistry::FLAG_ANIMATED) != 0;
+
+		objectUniforms(projection, view, Scene.Transforms[item.Owner], *item.Material);
+
+		switch (Scene.Effects[item.Owner])
+		{
+		case EntityRegistry::Effect::PULSE:
+			shader.SetUniform1f(Uniforms.Alpha, animated ? 0.5f * sin(elapsedTime) : 0.0f);
+			break;
+		case EntityRegistry::Effect::SCROLL:
+			shader.SetUniform1f(Uniforms.Time, animated ? elapsedTime : 0.0f);
+			break;
+		default:
+			break;
+		}
+	}, &prepass, &deferred);
 }
 
 void initSky()
 {
 	std::string path = "data/skybox";
-	Sky.VB = new VertexBuffer(&SkyboxVertices[0], SkyboxVertices.size() * sizeof(float));
+	Sky.Mesh = std::make_shared<MeshResource>();
+	Sky.Mesh->VB = new VertexBuffer(&SkyboxVertices[0], SkyboxVertices.size() * sizeof(float));
+
+	Sky.Mesh->VBL = new VertexBufferLayout();
+	Sky.Mesh->VBL->Push<float>(3);
 
-	Sky.VBL = new VertexBufferLayout();
-	Sky.VBL->Push<float>(3);
+	Sky.Mesh->VAO = new VertexArray();
+	Sky.Mesh->VAO->AddBuffer(*Sky.Mesh->VB, *Sky.Mesh->VBL);
 
-	Sky.VAO = new VertexArray();
-	Sky.VAO->AddBuffer(*Sky.VB, *Sky.VBL);
+	Sky.Texture = std::make_shared<TextureResource>();
 
-	glActiveTexture(GL_TEXTURE0);
-	glGenTextures(1, &Sky.Texture);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, Sky.Texture);
+	glGenTextures(1, &Sky.Texture->ID);
 
-	GLuint targets[] =
+	std::vector<GLenum> targets =
 	{
 		GL_TEXTURE_CUBE_MAP_POSITIVE_X, GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
 		GL_TEXTURE_CUBE_MAP_POSITIVE_Y, GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
 		GL_TEXTURE_CUBE_MAP_POSITIVE_Z, GL_TEXTURE_CUBE_MAP_NEGATIVE_Z
 	};
 
-	for (int i = 0; i < SkyboxSuffix.size(); ++i)
+	std::vector<CookedTexture> images(SkyboxSuffix.size());
+	bool cooked = TextureCooker::IsSupported();
+
+	for (int i = 0; i < SkyboxSuffix.size() && cooked; ++i)
+	{
+		std::string texture = path + "_" + SkyboxSuffix[i] + ".png";
+		std::cout << "Loading cube map texture: " << texture << std::endl;
+
+		cooked = TextureCooker::OpenCooked(texture, images[i]);
+	}
+
+	// faces have to match, otherwise the cube map is incomplete
+	for (int i = 1; i < SkyboxSuffix.size() && cooked; ++i)
+		cooked = images[i].Format == images[0].Format && images[i].Width == images[0].Width && images[i].Levels.size() == images[0].Levels.size();
+
+	// cooking binds textures of its own, so the cube map is bound once the faces are open
+	StateTracker::ActiveTexture(GL_TEXTURE0);
+	StateTracker::BindTexture(GL_TEXTURE_CUBE_MAP, Sky.Texture->ID);
+
+	// coarse levels of all faces are uploaded now, finer ones are streamed
+	if (cooked)
+		TextureStreamer::Stream(Sky.Texture->ID, GL_TEXTURE_CUBE_MAP, targets, images);
+
+	// any face without cooked file sends all of them through the source images
+	for (int i = 0; i < SkyboxSuffix.size() && !cooked; ++i)
 	{
 		std::string texture = path + "_" + SkyboxSuffix[i] + ".png";
 		std::cout << "Loading cube map texture: " << texture << std::endl;
@@ -259,367 +837,583 @@ void initSky()
 	glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	glTexParameterf(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-	glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+
+	// cooked faces come with their mip chains
+	if (!cooked)
+		glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 }
 
-void drawSky(const glm::mat4& projection, const glm::mat4& view, Shader& shader)
+void drawSky(Shader& shader)
 {
-	glDepthMask(GL_FALSE);
-
-	glm::mat4 v = glm::mat4(glm::mat3(view));
+	StateTracker::DepthMask(GL_FALSE);
 
 	shader.Bind();
-	shader.SetUniformMatrix4fv("viewMatrix", 1, GL_FALSE, glm::value_ptr(v));
-	shader.SetUniformMatrix4fv("projectionMatrix", 1, GL_FALSE, glm::value_ptr(projection));
 
-	Sky.VAO->Bind();
+	Sky.Mesh->VAO->Bind();
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_CUBE_MAP, Sky.Texture);
+	StateTracker::ActiveTexture(GL_TEXTURE0);
+	StateTracker::BindTexture(GL_TEXTURE_CUBE_MAP, Sky.Texture->ID);
 
 	glDrawArrays(GL_TRIANGLES, 0, 36);
-	glBindVertexArray(0);
+	Sky.Mesh->VAO->Unbind();
 
-	glDepthMask(GL_TRUE);
+	StateTracker::DepthMask(GL_TRUE);
 }
 
-void initGeneratedPyramid()
+void initGeneratedPyramid(AssetLoader& loader, Shader& shader)
 {
-	PyramidData p = PyramidGenerator::Generate(30);
+	GeneratedPyramid = Scene.Create("generated pyramid", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID);
+	placeEntity(GeneratedPyramid, glm::vec3(0.0f, 0.0f, -15.0f), 5.0f, glm::vec3(5.0f));
 
-	GeneratedPyramid.Position = glm::vec3(0.0f, 0.0f, -15.0f);
-	GeneratedPyramid.Scale = glm::vec3(5.0f);
+	Scene.Effects[GeneratedPyramid] = EntityRegistry::Effect::PULSE;
+	Scene.PickIds[GeneratedPyramid] = 1;
 
-	GeneratedPyramid.Animate = false;
+	MaterialData& material = Scene.Materials[GeneratedPyramid];
+	material.Diffuse = glm::vec3(1.0f, 0.55f, 0.172f);
+	material.Ambient = glm::vec3(0.251208007f);
+	material.Specular = glm::vec3(0.700483024f);
+	material.Shininess = 3.82f;
 
-	GeneratedPyramid.Diffuse = glm::vec3(1.0f, 0.55f, 0.172f);
-	GeneratedPyramid.Ambient = glm::vec3(0.251208007f);
-	GeneratedPyramid.Specular = glm::vec3(0.700483024f);
-	GeneratedPyramid.Shininess = 3.82f;
+	loadPyramidAsync(loader, 30, GeneratedPyramid);
+}
 
-	setBuffers(p.Vertices, p.Triangles, { 3, 3 }, GeneratedPyramid);
+void clickGeneratedPyramid()
+{
+	Scene.Toggle(GeneratedPyramid, EntityRegistry::FLAG_ANIMATED);
 }
 
-void drawGeneratedPyramid(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer, float elapsedTime)
+void initStonePyramid(AssetLoader& loader, Shader& shader)
 {
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, GeneratedPyramid.Position + glm::vec3(0.0f, GeneratedPyramid.Scale.y, 0.0f));
-	model = glm::scale(model, GeneratedPyramid.Scale);
+	StonePyramid = Scene.Create("stone pyramid", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID);
+	placeEntity(StonePyramid, StonePyramidPosition, 2.0f, glm::vec3(3.0f, 2.0f, 3.0f));
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, GeneratedPyramid);
-	shader.SetUniform1f("alpha", GeneratedPyramid.Animate ? 0.5f * sin(elapsedTime) : 0.0f);
+	MaterialData& material = Scene.Materials[StonePyramid];
+	material.Diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+	material.Ambient = glm::vec3(0.215f, 0.2345f, 0.215f);
+	material.Specular = glm::vec3(0.633f, 0.727811f, 0.633f);
+	material.Shininess = 76.8f;
 
-	renderer.Draw(*GeneratedPyramid.VAO, *GeneratedPyramid.EB, shader, GL_TRIANGLES);
+	loadPyramidAsync(loader, 6, StonePyramid);
 }
 
-void clickGeneratedPyramid()
+void initQuartzPyramid(AssetLoader& loader, Shader& shader)
 {
-	GeneratedPyramid.Animate = !GeneratedPyramid.Animate;
+	QuartzPyramid = Scene.Create("quartz pyramid", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID);
+	placeEntity(QuartzPyramid, glm::vec3(-2.0f, 0.0f, 17.0f), 7.0f, glm::vec3(7.0f));
+
+	MaterialData& material = Scene.Materials[QuartzPyramid];
+	material.Diffuse = glm::vec3(1.0f, 0.829f, 0.829f);
+	material.Ambient = glm::vec3(0.25f, 0.20725f, 0.20725f);
+	material.Specular = glm::vec3(0.296648f, 0.296648f, 0.296648f);
+	material.Shininess = 11.264f;
+
+	loadPyramidAsync(loader, 80, QuartzPyramid);
 }
 
-void initStonePyramid()
+void initDesert(AssetLoader& loader, Shader& shader)
 {
-	PyramidData p = PyramidGenerator::Generate(6);
-
-	StonePyramid.Position = glm::vec3(14.0f, 0.0f, 0.0f);
-	StonePyramid.Scale = glm::vec3(3.0f, 2.0f, 3.0f);
+	Desert = Scene.Create("desert", &shader);
+	placeEntity(Desert, glm::vec3(0.0f, 0.0f, 0.0f), 3.0f, glm::vec3(30.0f));
 
-	StonePyramid.Animate = false;
-	StonePyramid.Diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
-	StonePyramid.Ambient = glm::vec3(0.215f, 0.2345f, 0.215f);
-	StonePyramid.Specular = glm::vec3(0.633f, 0.727811f, 0.633f);
+	loadEntitiesAsync(loader, "data/desert_test.obj", { Desert }, [](bool loaded)
+	{
+		if (!loaded)
+			std::cout << "initializing desert has failed!" << std::endl;
+	});
+}
 
-	StonePyramid.Shininess = 76.8f;
+void initAloe(AssetLoader& loader, Shader& shader)
+{
+	Aloe = Scene.Create("aloe", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID);
+	placeEntity(Aloe, glm::vec3(-14.5f, 0.0f, -1.0f), 0.175f, glm::vec3(0.35f));
 
-	setBuffers(p.Vertices, p.Triangles, { 3, 3 }, StonePyramid);
+	loadEntitiesAsync(loader, "data/aloe.obj", { Aloe }, [](bool loaded)
+	{
+		if (!loaded)
+			std::cout << "initializing aloe has failed!" << std::endl;
+	});
 }
 
-void drawStonePyramid(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
+void initCactus0(AssetLoader& loader, Shader& shader)
 {
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, StonePyramid.Position + glm::vec3(0.0f, StonePyramid.Scale.y, 0.0f));
-	model = glm::scale(model, StonePyramid.Scale);
+	Cactus0 = Scene.Create("cactus0", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID);
+	placeEntity(Cactus0, glm::vec3(-22.0f, 0.0f, -1.0f), 0.25f, glm::vec3(0.5f));
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, StonePyramid);
+	loadEntitiesAsync(loader, "data/cactus00.obj", { Cactus0 }, [](bool loaded)
+	{
+		if (!loaded)
+			std::cout << "initializing cactus has failed!" << std::endl;
+	});
+}
+
+void initCactus1(AssetLoader& loader, Shader& shader)
+{
+	Cactus1 = Scene.Create("cactus1", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID);
+	placeEntity(Cactus1, glm::vec3(-22.0f, 0.0f, 5.0f), 0.25f, glm::vec3(0.25f));
 
-	renderer.Draw(*StonePyramid.VAO, *StonePyramid.EB, shader, GL_TRIANGLES);
+	loadEntitiesAsync(loader, "data/cactus01.obj", { Cactus1 }, [](bool loaded)
+	{
+		if (!loaded)
+			std::cout << "initializing cactus has failed!" << std::endl;
+	});
 }
 
-void initQuartzPyramid()
+void initRock0(AssetLoader& loader, Shader& shader)
 {
-	PyramidData p = PyramidGenerator::Generate(80);
+	Rock0 = Scene.Create("rock0", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID);
+	placeEntity(Rock0, glm::vec3(-15.0f, 0.0f, 5.0f), 0.25f, glm::vec3(0.5f));
 
-	QuartzPyramid.Position = glm::vec3(-2.0f, 0.0f, 17.0f);
-	QuartzPyramid.Scale = glm::vec3(7.0f);
+	Scene.PickIds[Rock0] = 3;
 
-	QuartzPyramid.Animate = false;
-	QuartzPyramid.Diffuse = glm::vec3(1.0f, 0.829f, 0.829f);
-	QuartzPyramid.Ambient = glm::vec3(0.25f, 0.20725f, 0.20725f);
-	QuartzPyramid.Specular = glm::vec3(0.296648f, 0.296648f, 0.296648f);
+	loadEntitiesAsync(loader, "data/rock00.obj", { Rock0 }, [](bool loaded)
+	{
+		if (!loaded)
+		{
+			std::cout << "initializing rock0 has failed!" << std::endl;
+			return;
+		}
 
-	QuartzPyramid.Shininess = 11.264f;
+		Rock0Index = 0;
+		Rock0Diffuses =
+		{
+			Scene.Materials[Rock0].Diffuse,
+			glm::vec3(1.0f, 0.0f, 0.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::vec3(0.0f, 0.0f, 1.0f),
+			glm::vec3(1.0f, 1.0f, 0.0f),
+			glm::vec3(1.0f, 0.0f, 1.0f),
+			glm::vec3(0.0f, 1.0f, 1.0f),
+			glm::vec3(1.0f, 1.0f, 1.0f)
+		};
+	});
+}
 
-	setBuffers(p.Vertices, p.Triangles, { 3, 3 }, QuartzPyramid);
+void clickRock0()
+{
+	if (!Rock0Diffuses.empty())
+		Scene.Materials[Rock0].Diffuse = Rock0Diffuses[++Rock0Index % Rock0Diffuses.size()];
 }
 
-void drawQuartzPyramid(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
+void initRock1(AssetLoader& loader, Shader& shader)
 {
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, QuartzPyramid.Position + glm::vec3(0.0f, QuartzPyramid.Scale.y, 0.0f));
-	model = glm::scale(model, QuartzPyramid.Scale);
+	Rock1 = Scene.Create("rock1", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID | EntityRegistry::FLAG_ADDITIVE);
+	placeEntity(Rock1, glm::vec3(-18.0f, 0.0f, 2.0f), 0.4f, glm::vec3(0.8f));
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, QuartzPyramid);
+	loadEntitiesAsync(loader, "data/rock01.obj", { Rock1 }, [](bool loaded)
+	{
+		if (!loaded)
+		{
+			std::cout << "initializing rock1 has failed!" << std::endl;
+			return;
+		}
 
-	renderer.Draw(*QuartzPyramid.VAO, *QuartzPyramid.EB, shader, GL_TRIANGLES);
+		Scene.Materials[Rock1].Diffuse = glm::vec3(0.8f, 0.0f, 0.6f);
+	});
 }
 
-void initDesert()
+void initInfiniteTexture(AssetLoader& loader, Shader& shader)
 {
-	Desert.Position = glm::vec3(0.0f, 0.0f, 0.0f);
-	Desert.Scale = glm::vec3(30.0f);
+	InfiniteTexture = Scene.Create("infinite texture", &shader);
+	placeEntity(InfiniteTexture, glm::vec3(0.0f, 0.0f, 0.0f), 0.02f, glm::vec3(1.0f));
+
+	Scene.Effects[InfiniteTexture] = EntityRegistry::Effect::SCROLL;
+	Scene.PickIds[InfiniteTexture] = 2;
 
-	if (!loadMesh("data/desert_test.obj", Desert))
+	loadEntitiesAsync(loader, "data/plane.obj", { InfiniteTexture }, [](bool loaded)
 	{
-		std::cout << "initializing desert has failed!" << std::endl;
-		return;
-	}
+		if (!loaded)
+		{
+			std::cout << "initializing infinite texture has failed!" << std::endl;
+			return;
+		}
+
+		Scene.Materials[InfiniteTexture].Diffuse = glm::vec3(0.0f, 1.0f, 0.0f);
+	});
 }
 
-void drawDesert(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
+void clickInfiniteTexture()
 {
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, Desert.Position + glm::vec3(0.0f, Desert.Scale.y / 10.0f, 0.0f));
-	model = glm::scale(model, Desert.Scale);
+	Scene.Toggle(InfiniteTexture, EntityRegistry::FLAG_ANIMATED);
+}
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Desert);
+void initBillboard(AssetLoader& loader, Shader& shader)
+{
+	Billboard = Scene.Create("billboard", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID | EntityRegistry::FLAG_ANIMATED | EntityRegistry::FLAG_TRANSPARENT);
+	placeEntity(Billboard, glm::vec3(-8.0f, 0.0f, -12.0f), 0.7f, glm::vec3(0.7f));
 
-	renderer.Draw(*Desert.VAO, *Desert.EB, shader, GL_TRIANGLES);
+	Scene.Effects[Billboard] = EntityRegistry::Effect::SCROLL;
+
+	loadEntitiesAsync(loader, "data/billboard.obj", { Billboard }, [](bool loaded)
+	{
+		if (!loaded)
+			std::cout << "initializing billboard texture has failed!" << std::endl;
+	});
 }
 
-void initAloe()
+void initScatter(AssetLoader& loader, Shader& shader, Shader& instancedShader, size_t count)
 {
-	Aloe.Position = glm::vec3(-14.5f, 0.0f, -1.0f);
-	Aloe.Scale = glm::vec3(0.35f);
+	static const std::vector<std::string> paths = { "data/rock00.obj", "data/rock01.obj", "data/cactus00.obj", "data/cactus01.obj" };
+	std::vector<std::vector<glm::mat4>> transforms(paths.size());
+
+	// fixed seed keeps the scene the same between runs
+	std::srand(7);
 
-	if (!loadMesh("data/aloe.obj", Aloe))
+	for (size_t i = 0; i < count; ++i)
 	{
-		std::cout << "initializing aloe has failed!" << std::endl;
-		return;
+		glm::vec3 position(-24.0f + 48.0f * std::rand() / RAND_MAX, 0.0f, -24.0f + 48.0f * std::rand() / RAND_MAX);
+		float scale = 0.2f + 0.3f * std::rand() / RAND_MAX;
+
+		glm::mat4 model = glm::mat4(1.0f);
+		model = glm::translate(model, position + glm::vec3(0.0f, scale / 2.0f, 0.0f));
+		model = glm::scale(model, glm::vec3(scale));
+
+		transforms[i % paths.size()].push_back(model);
 	}
-}
 
-void drawAloe(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
-{
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, Aloe.Position + glm::vec3(0.0f, Aloe.Scale.y / 2.0f, 0.0f));
-	model = glm::scale(model, Aloe.Scale);
+	// each mesh is parsed and uploaded once, all its props share it
+	for (size_t kind = 0; kind < paths.size(); ++kind)
+	{
+		if (transforms[kind].empty())
+			continue;
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Aloe);
+		auto done = [](bool loaded)
+		{
+			if (!loaded)
+				std::cout << "initializing scattered props has failed!" << std::endl;
+		};
+
+		if (Renderer::HasInstancing())
+		{
+			auto batch = std::make_shared<PropBatch>();
+			batch->Transforms = std::move(transforms[kind]);
+
+			Props.push_back(batch);
+			loadPropsAsync(loader, paths[kind], batch, instancedShader, done);
+			continue;
+		}
+
+		// without per instance attributes every prop is its own entity
+		std::vector<EntityRegistry::Entity> entities;
+		Scene.Reserve(Scene.GetCount() + transforms[kind].size());
 
-	renderer.Draw(*Aloe.VAO, *Aloe.EB, shader, GL_TRIANGLES);
+		for (const glm::mat4& model : transforms[kind])
+		{
+			entities.push_back(Scene.Create("scatter", &shader, EntityRegistry::FLAG_VISIBLE | EntityRegistry::FLAG_SOLID));
+			Scene.Transforms[entities.back()] = model;
+		}
+
+		loadEntitiesAsync(loader, paths[kind], entities, done);
+	}
 }
 
-void initCactus0()
+void prepareProps(const glm::mat4& projection, const glm::mat4& view)
 {
-	Cactus0.Position = glm::vec3(-22.0f, 0.0f, -1.0f);
-	Cactus0.Scale = glm::vec3(0.5f);
+	if (Props.empty())
+		return;
+
+	// all populations are culled in single pass
+	PropCuller.Clear();
 
-	if (!loadMesh("data/cactus00.obj", Cactus0))
+	for (const auto& batch : Props)
 	{
-		std::cout << "initializing cactus has failed!" << std::endl;
-		return;
+		if (!batch->Mesh || !batch->VAO)
+			continue;
+
+		const MeshResource& mesh = *batch->Mesh;
+
+		for (const glm::mat4& model : batch->Transforms)
+			PropCuller.Add(model, mesh.BoundsMin, mesh.BoundsMax, mesh.Center, mesh.Radius);
 	}
-}
 
-void drawCactus0(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
-{
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, Cactus0.Position + glm::vec3(0.0f, Cactus0.Scale.y / 2.0f, 0.0f));
-	model = glm::scale(model, Cactus0.Scale);
+	PropCuller.Cull(Camera::ExtractFrustum(projection * view));
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Cactus0);
+	size_t index = 0;
+
+	for (const auto& batch : Props)
+	{
+		if (!batch->Mesh || !batch->VAO)
+			continue;
+
+		const MeshResource& mesh = *batch->Mesh;
+
+		batch->Visible.clear();
+
+		for (const glm::mat4& model : batch->Transforms)
+		{
+			if (PropCuller.IsVisible(index++))
+				batch->Visible.push_back(model);
+		}
 
-	renderer.Draw(*Cactus0.VAO, *Cactus0.EB, shader, GL_TRIANGLES);
+		if (batch->Visible.empty())
+			continue;
+
+		// visible matrices are packed to the front of the instance buffer
+		batch->Instances->SetData(batch->Visible.data(), batch->Visible.size() * sizeof(glm::mat4), 0);
+
+		// nearest prop picks the level, so no prop is drawn coarser than its own size allows
+		GLfloat size = 0.0f;
+
+		for (const glm::mat4& model : batch->Visible)
+			size = std::max(size, screenSize(mesh, projection, view, model));
+
+		batch->Lod = MeshSimplifier::SelectLod(size, batch->Lod, mesh.GetLodCount());
+	}
 }
 
-void initCactus1()
+void drawPropsDepth(Shader& shader, const Renderer& renderer)
 {
-	Cactus1.Position = glm::vec3(-22.0f, 0.0f, 5.0f);
-	Cactus1.Scale = glm::vec3(0.25f);
+	shader.Bind();
 
-	if (!loadMesh("data/cactus01.obj", Cactus1))
+	for (const auto& batch : Props)
 	{
-		std::cout << "initializing cactus has failed!" << std::endl;
-		return;
+		if (!batch->Mesh || !batch->VAO || batch->Visible.empty())
+			continue;
+
+		const MeshResource& mesh = *batch->Mesh;
+
+		for (size_t i = 0; i < mesh.Submeshes.size(); ++i)
+			renderer.DrawInstanced(*batch->VAO, *mesh.EB, mesh.Submeshes[i], batch->Lod, (GLsizei)batch->Visible.size(), shader);
 	}
 }
 
-void drawCactus1(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
+/// Draw props.
+/**
+  Draws visible props of all populations with the bound instanced shader,
+  materials of the parts go through the object block.
+
+  \param[in] projection		Global projection matrix.
+  \param[in] view			Global view matrix.
+  \param[in] shader			Bound instanced shader program.
+  \param[in] renderer		Target renderer.
+*/
+static void drawPropBatches(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
 {
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, Cactus1.Position + glm::vec3(0.0f, Cactus1.Scale.y, 0.0f));
-	model = glm::scale(model, Cactus1.Scale);
+	for (const auto& batch : Props)
+	{
+		if (!batch->Mesh || !batch->VAO || batch->Visible.empty())
+			continue;
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Cactus1);
+		const MeshResource& mesh = *batch->Mesh;
+
+		for (size_t i = 0; i < mesh.Submeshes.size(); ++i)
+		{
+			const MaterialData& material = i == 0 ? batch->Material : mesh.Submeshes[i].Material;
+			// instances carry their own matrices, the block only serves the material
+			objectUniforms(projection, view, glm::mat4(1.0f), material);
 
-	renderer.Draw(*Cactus1.VAO, *Cactus1.EB, shader, GL_TRIANGLES);
+			if (material.Texture)
+			{
+				StateTracker::ActiveTexture(GL_TEXTURE0);
+				StateTracker::BindTexture(GL_TEXTURE_2D, material.Texture->ID);
+			}
+
+			renderer.DrawInstanced(*batch->VAO, *mesh.EB, mesh.Submeshes[i], batch->Lod, (GLsizei)batch->Visible.size(), shader);
+		}
+	}
 }
 
-void initRock0()
+void drawPropsGeometry(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
 {
-	Rock0.Position = glm::vec3(-15.0f, 0.0f, 5.0f);
-	Rock0.Scale = glm::vec3(0.5f);
-
-	if (!loadMesh("data/rock00.obj", Rock0))
-	{
-		std::cout << "initializing rock0 has failed!" << std::endl;
+	if (Props.empty())
 		return;
-	}
 
-	Rock0.Index = 0;
-	Rock0.Diffuses =
-	{
-		Rock0.Diffuse,
-		glm::vec3(1.0f, 0.0f, 0.0f),
-		glm::vec3(0.0f, 1.0f, 0.0f),
-		glm::vec3(0.0f, 0.0f, 1.0f),
-		glm::vec3(1.0f, 1.0f, 0.0f),
-		glm::vec3(1.0f, 0.0f, 1.0f),
-		glm::vec3(0.0f, 1.0f, 1.0f),
-		glm::vec3(1.0f, 1.0f, 1.0f)
-	};
-	Rock0.Diffuse = Rock0.Diffuses[0];
+	shader.Bind();
+	drawPropBatches(projection, view, shader, renderer);
 }
 
-void drawRock0(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
+void drawProps(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer, const DepthPrepass& prepass, const DeferredShading& deferred)
 {
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, Rock0.Position + glm::vec3(0.0f, Rock0.Scale.y / 2.0f, 0.0f));
-	model = glm::scale(model, Rock0.Scale);
+	// props are in the G-buffer and lit already
+	if (Props.empty() || (deferred.IsEnabled() && deferred.GetShader(shader)))
+		return;
+
+	// depth of the props is laid down already, only the fragments matching it are shaded
+	bool prepassed = prepass.IsActive() && prepass.GetShader(shader);
+
+	if (prepassed)
+	{
+		StateTracker::DepthFunc(GL_EQUAL);
+		StateTracker::DepthMask(GL_FALSE);
+	}
 
 	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Rock0);
+	drawPropBatches(projection, view, shader, renderer);
 
-	renderer.Draw(*Rock0.VAO, *Rock0.EB, shader, GL_TRIANGLES);
+	if (prepassed)
+	{
+		StateTracker::DepthFunc(GL_LESS);
+		StateTracker::DepthMask(GL_TRUE);
+	}
 }
 
-void clickRock0()
+void reportCulling()
 {
-	Rock0.Diffuse = Rock0.Diffuses[++Rock0.Index % Rock0.Diffuses.size()];
+	EntityCuller.Report("entities");
+	PropCuller.Report("props");
 }
 
-void initRock1()
+void initGround()
 {
-	Rock1.Position = glm::vec3(-18.0f, 0.0f, 2.0f);
-	Rock1.Scale = glm::vec3(0.8f);
+	const auto& mesh = Scene.Meshes[Desert];
 
-	if (!loadMesh("data/rock01.obj", Rock1))
+	if (!mesh || !mesh->Collision)
 	{
-		std::cout << "initializing rock1 has failed!" << std::endl;
+		std::cout << "initializing ground has failed!" << std::endl;
 		return;
 	}
 
-	Rock1.Diffuse = glm::vec3(0.8f, 0.0f, 0.6f);
+	// heights follow the desert where it is drawn
+	if (!Ground.Bake(*mesh->Collision, Scene.Transforms[Desert], GroundLower, GroundUpper, GROUND_CELL_SIZE))
+		std::cout << "initializing ground has failed!" << std::endl;
 }
 
-void drawRock1(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
+void placeCars()
 {
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE);
+	Car* cars[] = { &Player, &Police };
+	const size_t count = sizeof(cars) / sizeof(cars[0]);
 
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, Rock1.Position + glm::vec3(0.0f, Rock1.Scale.y / 2.0f, 0.0f));
-	model = glm::scale(model, Rock1.Scale);
-
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Rock1);
+	GLfloat x[count], z[count], heights[count];
+	glm::vec3 normals[count];
 
-	renderer.Draw(*Rock1.VAO, *Rock1.EB, shader, GL_TRIANGLES);
+	for (size_t i = 0; i < count; ++i)
+	{
+		x[i] = cars[i]->Position.x;
+		z[i] = cars[i]->Position.z;
+	}
 
-	glDisable(GL_BLEND);
-}
+	Ground.Sample(x, z, count, heights, normals);
 
-void initInfiniteTexture()
-{
-	InfiniteTexture.Position = glm::vec3(0.0f, 0.0f, 0.0f);
-	InfiniteTexture.Scale = glm::vec3(1.0f);
+	for (size_t i = 0; i < count; ++i)
+	{
+		Car& car = *cars[i];
+		car.Position.y = heights[i];
+		car.Normal = normals[i];
 
-	InfiniteTexture.Animate = false;
+		// model faces along x, the lift keeps wheels on the ground
+		glm::mat4 model = Curve::AlignObject(car.Position + car.Normal * (-0.05f + car.Scale.y / 2.0f), car.Direction, car.Normal);
+		model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(0, 1, 0));
+		model = glm::scale(model, car.Scale);
 
-	if (!loadMesh("data/plane.obj", InfiniteTexture))
-	{
-		std::cout << "initializing infinite texture has failed!" << std::endl;
-		return;
+		Scene.Transforms[car.Handle] = model;
 	}
 
-	InfiniteTexture.Diffuse = glm::vec3(0.0f, 1.0f, 0.0f);
+	Player.Cam.SetPosition(glm::vec3(0.0f, 0.375f, 0.0f) + Player.Position);
+	Player.Cam.SetDirection(Player.Direction);
+
+	Police.Cam.SetPosition(glm::vec3(0.0f, -0.05f + Police.Scale.y / 2.0f + 0.132f, 0.0f) + Police.Position);
+	Police.Cam.SetDirection(Police.Direction);
 }
 
-void drawInfiniteTexture(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer, float elapsedTime)
+void submitLights(LightClusters& lights, float elapsedTime)
 {
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, InfiniteTexture.Position + glm::vec3(0.0f, 0.02f, 0.0f));
-	model = glm::scale(model, InfiniteTexture.Scale);
+	// scene lights are white, the sun is lit by its own uniform block
+	LightSource point;
+	point.Position = glm::vec3(0.0f, 10.0f, -13.0f);
+	point.Range = 60.0f;
+	point.Ambient = 0.13f;
+	point.Attenuation = glm::vec3(0.05f, 0.09f, 0.0032f);
+
+	// spot light aims at its direction point and doesn't fade
+	LightSource spot;
+	spot.Position = glm::vec3(4.47f, 2.69f, 1.2f);
+	spot.Range = 40.0f;
+	spot.Ambient = 0.13f;
+	spot.Direction = glm::normalize(glm::vec3(3.0f, 1.3f, -1.0f) - spot.Position);
+	spot.CutoffInn = 0.91f;
+	spot.CutoffOut = 0.82f;
+
+	lights.AddLight(point);
+	lights.AddLight(spot);
+
+	for (const Car* car : { &Player, &Police })
+	{
+		glm::vec3 side = glm::normalize(glm::cross(car->Direction, car->Normal));
+		glm::vec3 front = car->Position + car->Direction * (2.0f * car->Radius) + car->Normal * car->Radius;
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, InfiniteTexture);
-	shader.SetUniform1f("time", InfiniteTexture.Animate ? elapsedTime : 0);
+		// beams dip a little towards the road
+		for (GLfloat offset : { -0.6f, 0.6f })
+		{
+			LightSource lamp;
+			lamp.Position = front + side * (offset * car->Radius);
+			lamp.Range = Car::HEADLIGHT_RANGE;
+			lamp.Color = glm::vec3(1.0f, 0.95f, 0.8f);
+			lamp.Direction = glm::normalize(car->Direction - 0.15f * car->Normal);
+			lamp.CutoffInn = cos(glm::radians(15.0f));
+			lamp.CutoffOut = cos(glm::radians(25.0f));
+			lamp.Attenuation = glm::vec3(1.0f, 0.09f, 0.032f);
+
+			lights.AddLight(lamp);
+		}
+	}
 
-	renderer.Draw(*InfiniteTexture.VAO, *InfiniteTexture.EB, shader, GL_TRIANGLES);
-}
+	// siren on the roof alternates red and blue
+	glm::vec3 side = glm::normalize(glm::cross(Police.Direction, Police.Normal));
+	glm::vec3 roof = Police.Position + Police.Normal * (Police.Scale.y - 0.05f);
+	GLfloat phase = 0.5f + 0.5f * sin(elapsedTime * 8.0f);
 
-void clickInfiniteTexture()
-{
-	InfiniteTexture.Animate = !InfiniteTexture.Animate;
+	for (int i = 0; i < 2; ++i)
+	{
+		LightSource siren;
+		siren.Position = roof + side * (i == 0 ? -0.1f : 0.1f);
+		siren.Range = 4.0f;
+		siren.Color = i == 0 ? glm::vec3(2.0f * phase, 0.0f, 0.0f) : glm::vec3(0.0f, 0.0f, 2.0f * (1.0f - phase));
+		siren.Attenuation = glm::vec3(1.0f, 0.7f, 1.8f);
+
+		lights.AddLight(siren);
+	}
 }
 
-void initBillboard()
+void initColliders()
 {
-	Billboard.Position = glm::vec3(-8.0f, 0.0f, -12.0f);
-	Billboard.Scale = glm::vec3(0.7f);
+	for (EntityRegistry::Entity i = 0; i < Scene.GetCount(); ++i)
+	{
+		if (!Scene.Meshes[i] || !Scene.Has(i, EntityRegistry::FLAG_SOLID))
+			continue;
 
-	Billboard.Animate = true;
+		const MeshResource& mesh = *Scene.Meshes[i];
 
-	if (!loadMesh("data/billboard.obj", Billboard))
+		// kept triangles follow the shape, meshes without them collide by their box
+		if (mesh.Collision)
+			Collisions.AddMesh(Scene.Transforms[i], mesh.Collision);
+		else if (mesh.Radius > 0.0f)
+			Collisions.AddBox(Scene.Transforms[i], mesh.BoundsMin, mesh.BoundsMax);
+	}
+
+	// props are too many for triangle tests, their boxes are enough
+	for (const auto& batch : Props)
 	{
-		std::cout << "initializing billboard texture has failed!" << std::endl;
-		return;
+		if (!batch->Mesh)
+			continue;
+
+		for (const glm::mat4& model : batch->Transforms)
+			Collisions.AddBox(model, batch->Mesh->BoundsMin, batch->Mesh->BoundsMax);
 	}
-}
 
-void drawBillboard(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer, float elapsedTime)
-{
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, Billboard.Position + glm::vec3(0.0f, Billboard.Scale.y, 0.0f));
-	model = glm::scale(model, Billboard.Scale);
+	for (Car* car : { &Player, &Police })
+	{
+		const auto& mesh = Scene.Meshes[car->Handle];
 
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Billboard);
-	shader.SetUniform1f("time", Billboard.Animate ? elapsedTime : 0);
+		// sphere spans the width of the car, its ends may reach a bit into obstacles
+		if (mesh && mesh->Radius > 0.0f)
+			car->Radius = 0.5f * std::min(mesh->BoundsMax.x - mesh->BoundsMin.x, mesh->BoundsMax.z - mesh->BoundsMin.z) * car->Scale.x;
+
+		car->Body = Collisions.AddBody(bodyCenter(*car, car->Position), car->Radius);
+	}
+
+	// player stays on the road around the pyramids
+	glm::vec3 reach = glm::vec3(Player.Radius);
+	Collisions.SetBounds(Player.Body, glm::vec3(-13.0f, -50.0f, -9.5f) - reach, glm::vec3(25.0f, 50.0f, 9.0f) + reach);
+}
 
-	renderer.Draw(*Billboard.VAO, *Billboard.EB, shader, GL_TRIANGLES);
+glm::vec3 bodyCenter(const Car& car, const glm::vec3& position)
+{
+	return glm::vec3(position.x, Ground.GetHeight(position.x, position.z) + car.Radius, position.z);
 }
 
-void initPlayer()
+void initPlayer(AssetLoader& loader, Shader& shader)
 {
+	Player.Handle = Scene.Create("player", &shader);
+
 	Player.Position = glm::vec3(0.0f, 0.0f, 0.0f);
 	Player.Scale = glm::vec3(0.5f);
 
@@ -627,25 +1421,11 @@ void initPlayer()
 	Player.Pitch = 0.0f;
 	Player.Speed = 0.0f;
 
-	if (!loadMesh("data/car.obj", Player))
+	loadEntitiesAsync(loader, "data/car.obj", { Player.Handle }, [](bool loaded)
 	{
-		std::cout << "initializing player car has failed!" << std::endl;
-		return;
-	}
-}
-
-void drawPlayer(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
-{
-	glm::mat4 model = glm::mat4(1.0f);
-	model = glm::translate(model, Player.Position + glm::vec3(0.0f, -0.05f + Player.Scale.y / 2.0f, 0.0f));
-	model = glm::rotate(model, glm::radians(-Player.Yaw - 180.0f), glm::vec3(0, 1, 0));
-	model = glm::scale(model, Player.Scale);
-
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Player);
-
-	renderer.Draw(*Player.VAO, *Player.EB, shader, GL_TRIANGLES);
+		if (!loaded)
+			std::cout << "initializing player car has failed!" << std::endl;
+	});
 }
 
 void increaseSpeedPlayer()
@@ -714,26 +1494,22 @@ void updatePlayer(float elapsedTime)
 		if (abs(Player.Speed) < 0.03f)
 			Player.Speed = 0;
 	}
-
-	Player.Cam.SetPosition(glm::vec3(0.0f, 0.375f, 0.0f) + Player.Position);
-	Player.Cam.SetDirection(Player.Direction);
 }
 
 void movePlayer(float elapsedTime)
 {
-	glm::vec3 temp = Player.Position;
 	float timeDelta = elapsedTime - Player.CurrentTime;
 	Player.CurrentTime = elapsedTime;
-	Player.Position += timeDelta * Player.Speed * Player.Direction;
 
-	if (Player.Position.x < -13.0f || Player.Position.x > 25.0f ||
-		Player.Position.y < -0.029f || Player.Position.y > 0.029f ||
-		Player.Position.z < -9.5f || Player.Position.z > 9.0f ||
-		glm::distance(Player.Position, StonePyramid.Position) <= 0.65f + 3.0f)
-	{
-		Player.Position = temp;
+	if (Player.Speed == 0.0f)
+		return;
+
+	glm::vec3 position = Player.Position + timeDelta * Player.Speed * Player.Direction;
+
+	if (Collisions.Move(Player.Body, bodyCenter(Player, position)))
+		Player.Position = position;
+	else
 		Player.Speed = 0.0f;
-	}
 }
 
 void switchToPlayer()
@@ -744,33 +1520,21 @@ void switchToPlayer()
 	CameraManager.SwitchTo(&Player.Cam);
 }
 
-void initPolice()
+void initPolice(AssetLoader& loader, Shader& shader)
 {
+	Police.Handle = Scene.Create("police", &shader);
+
 	Police.Scale = glm::vec3(0.5f);
 
 	Police.Yaw = 0.0f;
 	Police.Pitch = 0.0f;
 	Police.Speed = 0.0f;
 
-	if (!loadMesh("data/police.obj", Police))
+	loadEntitiesAsync(loader, "data/police.obj", { Police.Handle }, [](bool loaded)
 	{
-		std::cout << "initializing police car has failed!" << std::endl;
-		return;
-	}
-}
-
-void drawPolice(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer)
-{
-	glm::mat4 model = glm::mat4(1.0f);
-	model = Curve::AlignObject(Police.Position, Police.Direction);
-	model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(0, 1, 0));
-	model = glm::scale(model, Police.Scale);
-
-	shader.Bind();
-	transformUniforms(shader, projection, view, model);
-	materialUniforms(shader, Police);
-
-	renderer.Draw(*Police.VAO, *Police.EB, shader, GL_TRIANGLES);
+		if (!loaded)
+			std::cout << "initializing police car has failed!" << std::endl;
+	});
 }
 
 void updatePolice(float elapsedTime)
@@ -788,13 +1552,41 @@ void updatePolice(float elapsedTime)
 
 	static float speed = 0.3f;
 	static glm::mat4 base = Curve::BasisMatrix(15.0f);
-	static glm::vec3 origin = glm::vec3(-18.0f, -0.05f + Player.Scale.y / 2.0f, 2.0f);
+	static glm::vec3 origin = glm::vec3(-18.0f, 0.0f, 2.0f);
 
-	Police.Position = origin + Curve::EvalCurve(curve, base, Police.CurrentTime * speed);
-	Police.Direction = glm::normalize(Curve::EvalCurveDerivate(curve, base, Police.CurrentTime * speed));
+	float travel = Police.Travel + timeDelta * speed;
 
-	Police.Cam.SetPosition(glm::vec3(0.0f, 0.132f, 0.0f) + Police.Position);
-	Police.Cam.SetDirection(Police.Direction);
+	// scripted path ignores props, police only waits for cars standing in its way
+	if (Collisions.Move(Police.Body, bodyCenter(Police, origin + Curve::EvalCurve(curve, base, travel)), CollisionWorld::TEST_BODIES))
+		Police.Travel = travel;
+
+	Police.Position = origin + Curve::EvalCurve(curve, base, Police.Travel);
+	Police.Direction = glm::normalize(Curve::EvalCurveDerivate(curve, base, Police.Travel));
+}
+
+void updatePoliceSight()
+{
+	glm::vec3 eye = Police.Cam.GetPosition();
+	// ray ends in the middle of the player car, its surface is hit on the way
+	glm::vec3 target = glm::vec3(Scene.Transforms[Player.Handle][3]);
+	glm::vec3 offset = target - eye;
+	float distance = glm::length(offset);
+
+	bool spotted = false;
+
+	// player behind the police car or too far isn't looked for
+	if (distance > 0.0f && distance <= Car::SIGHT && glm::dot(offset, Police.Direction) > 0.0f)
+	{
+		RayHit hit = Scene.Raycast(eye, offset / distance, distance, Police.Handle);
+		spotted = hit.Hit && hit.Entity == Player.Handle;
+	}
+
+	Police.Spotted = spotted;
+}
+
+void reportPoliceSight()
+{
+	std::cout << "Police sight: player " << (Police.Spotted ? "spotted" : "not in sight") << std::endl;
 }
 
 void switchToPolice()
@@ -12,71 +12,164 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Shader.h"
 #include "Renderer.h"
+#include "StateTracker.h"
+#include "RenderQueue.h"
+#include "RingBuffer.h"
+#include "FrustumCuller.h"
+#include "DepthPrepass.h"
+#include "RenderGraph.h"
+#include "DeferredShading.h"
+#include "LightClusters.h"
+#include "CollisionWorld.h"
+#include "Heightfield.h"
+#include "UniformBuffer.h"
 #include "MeshData.h"
+#include "MeshCache.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "AssetLoader.h"
+#include "TextureCooker.h"
+#include "TextureStreamer.h"
 #include "CameraSystem.h"
+#include "EntityRegistry.h"
 
-/// Struct that wrapps additional context for pyramid.
+/// Struct that contains instanced props.
 /**
-  This struct contains data context for pyramid.
+  This struct contains population of props sharing single mesh, drawn in one call per part.
+  Model matrices of the props live in their own buffer advancing once per instance.
 */
-struct Pyramid : public MeshData
+struct PropBatch
 {
-	glm::vec3 Position;
-	glm::vec3 Scale;
-
-	bool Animate;
+	std::shared_ptr<MeshResource> Mesh; ///< Shared mesh, empty until loaded
+	MaterialData Material; ///< Material of the first part
+	std::vector<glm::mat4> Transforms; ///< Model matrices of the props
+	std::vector<glm::mat4> Visible; ///< Model matrices of the props inside the frustum
+
+	VertexArray* VAO = nullptr; ///< Mesh data with instance data
+	VertexBuffer* Instances = nullptr; ///< Instance data
+
+	size_t Lod = 0; ///< Level of detail drawn last frame
+
+	/// Destructor
+	/**
+		Deletes allocated memory.
+	*/
+	inline ~PropBatch()
+	{
+		delete VAO;
+		delete Instances;
+	}
 };
-/// Struct that wrapps additional context for landscape.
+
+/// Struct that contains light of uniform block.
 /**
-  This struct contains data context for landscape.
+  This struct mirrors std140 layout of the light structure in shaders,
+  vectors take four components.
 */
-struct LandScape : public MeshData
+struct LightData
 {
-	glm::vec3 Position;
-	glm::vec3 Scale;
+	glm::vec3 Diffuse = glm::vec3(0.0f);
+	GLfloat Padding0 = 0.0f;
+	glm::vec3 Ambient = glm::vec3(0.0f);
+	GLfloat Padding1 = 0.0f;
+	glm::vec3 Specular = glm::vec3(0.0f);
+	GLfloat Padding2 = 0.0f;
+	glm::vec3 Position = glm::vec3(0.0f);
+	GLfloat Padding3 = 0.0f;
+	glm::vec3 Direction = glm::vec3(0.0f);
+
+	GLfloat CutoffInn = 0.0f;
+	GLfloat CutoffOut = 0.0f;
+
+	GLfloat Constant = 0.0f;
+	GLfloat Linear = 0.0f;
+	GLfloat Quadratic = 0.0f;
 };
-/// Struct that wrapps additional context for flora.
+
+/// Struct that contains light uniform block.
 /**
-  This struct contains data context for flora.
+  This struct mirrors std140 layout of the LightData block. The sun lights every fragment,
+  other lights come from the light list.
 */
-struct Flora : public MeshData
+struct LightBlock
 {
-	glm::vec3 Position;
-	glm::vec3 Scale;
+	static constexpr GLuint BINDING = 1;
+
+	LightData Sunlight;
 };
-/// Struct that wrapps additional context for rock.
+
+/// Struct that contains fog uniform block.
 /**
-  This struct contains data context for rock.
+  This struct mirrors std140 layout of the FogData block.
 */
-struct Rock : public MeshData
+struct FogBlock
 {
-	glm::vec3 Position;
-	glm::vec3 Scale;
+	static constexpr GLuint BINDING = 2;
 
-	size_t Index;
-	std::vector<glm::vec3> Diffuses;
+	glm::vec3 Color = glm::vec3(0.0f);
+	GLfloat Density = 0.0f;
+	GLfloat Gradient = 0.0f;
+	GLfloat Padding[3] = {};
 };
-/// Struct that wrapps additional context for plane.
+
+/// Struct that contains frame uniform block.
 /**
-  This struct contains data context for plane.
+  This struct mirrors std140 layout of the FrameData block.
 */
-struct Plane : public MeshData
+struct FrameBlock
 {
-	glm::vec3 Position;
-	glm::vec3 Scale;
+	static constexpr GLuint BINDING = 0;
+
+	glm::mat4 Projection;
+	glm::mat4 View;
+	glm::mat4 PV;
+	glm::vec3 CameraPosition;
+	GLfloat Padding = 0.0f;
+};
 
-	bool Animate;
+/// Struct that contains object uniform block.
+/**
+  This struct mirrors std140 layout of the ObjectData block, written once per draw.
+*/
+struct ObjectBlock
+{
+	static constexpr GLuint BINDING = 3;
+	static constexpr GLsizeiptr CAPACITY = 4096; ///< Blocks per frame before the ring waits
+
+	glm::mat4 PVM;
+	glm::mat4 Model;
+	glm::mat4 Normal;
+	glm::vec3 Diffuse = glm::vec3(0.0f);
+	GLfloat Padding0 = 0.0f;
+	glm::vec3 Ambient = glm::vec3(0.0f);
+	GLfloat Padding1 = 0.0f;
+	glm::vec3 Specular = glm::vec3(0.0f);
+	GLfloat Shininess = 1.0f;
+	GLint TexUse = 0;
+	GLfloat Padding2[3] = {};
 };
+
+static_assert(sizeof(LightData) == 96, "LightData doesn't match std140 layout");
+static_assert(sizeof(FogBlock) == 32, "FogBlock doesn't match std140 layout");
+static_assert(sizeof(FrameBlock) == 208, "FrameBlock doesn't match std140 layout");
+static_assert(sizeof(ObjectBlock) == 256, "ObjectBlock doesn't match std140 layout");
+
 /// Struct that wrapps additional context for car.
 /**
   This struct contains data context for car.
 */
-struct Car : public MeshData
+struct Car
 {
 	static constexpr float SPEED = 0.1f;
 	static constexpr float STEER = 2.5f;
+	static constexpr float SIGHT = 12.0f; ///< Range of the line of sight
+	static constexpr float HEADLIGHT_RANGE = 10.0f; ///< Range of the headlights
+
+	EntityRegistry::Entity Handle; ///< Drawn entity
 
 	glm::vec3 Direction;
 	glm::vec3 Position;
@@ -88,43 +181,100 @@ struct Car : public MeshData
 	float Pitch;
 	float Speed;
 	float CurrentTime;
+
+	bool Spotted = false; ///< Other car is in the line of sight
+
+	CollisionWorld::Body Body = 0; ///< Collision body
+	float Radius = 0.25f; ///< Radius of the collision body
+	float Travel = 0.0f; ///< Distance along the path of scripted car
+	glm::vec3 Normal = glm::vec3(0.0f, 1.0f, 0.0f); ///< Ground normal under the car
 };
-/// Transform uniform setup
+/// Object uniform setup
 /**
-  Sets up transform matrices via uniforms.
+  Writes transform matrices and material of a object or its part into the ring
+  and binds them to the ObjectData block. The texture itself is bound by the renderer.
 
-  \param[in] shader			Target shader.
   \param[in] projection		Global projection matrix.
   \param[in] view			Global view matrix.
   \param[in] model			Objects model matrix.
+  \param[in] material		Source material.
 */
-void transformUniforms(Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model);
-/// Material uniform setup
+void objectUniforms(const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model, const MaterialData& material);
+/// Uniform blocks setup
 /**
-  Sets up material properties of a object via uniforms.
+  Creates uniform buffers of frame, light and fog blocks bound to their binding points,
+  ring of object blocks and uploads the lights, which don't change.
+*/
+void initUniformBlocks();
+/// Uniform blocks assignment
+/**
+  Assigns frame, light, fog and object blocks of the shader to their binding points.
+  Blocks the shader doesn't use are skipped.
 
   \param[in] shader		Target shader.
-  \param[in] object		Source object.
 */
-void materialUniforms(Shader& shader, const MeshData& object);
-/// Light uniform setup
+void bindUniformBlocks(Shader& shader);
+/// Uniform blocks update
 /**
-  Sets up global light properties via uniforms.
+  Writes frame and fog blocks once for all shaders and moves the object ring
+  to the region of the new frame.
 
-  \param[in] shader		Target shader.
+  \param[in] projection		Global projection matrix.
+  \param[in] view			Global view matrix.
   \param[in] camera		Active camera.
 */
-void lightUniforms(Shader& shader, const Camera& camera);
-/// Fog uniform setup
+void updateUniformBlocks(const glm::mat4& projection, const glm::mat4& view, const Camera& camera);
+/// Uniform blocks cleanup
 /**
-  Sets up global fog properties via uniforms.
+  Deletes uniform buffers of the blocks.
+*/
+void cleanupUniformBlocks();
+/// Screen size of mesh
+/**
+  Returns fraction of the screen height covered by the bounding sphere of the mesh.
 
-  \param[in] shader		Target shader.
+  \param[in] mesh			Shared mesh.
+  \param[in] projection		Global projection matrix.
+  \param[in] view			Global view matrix.
+  \param[in] model			Objects model matrix.
+*/
+GLfloat screenSize(const MeshResource& mesh, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model);
+/// Submit entity
+/**
+  Submits all parts of the entity mesh into the queue at the level of detail
+  picked by its screen size. Material of the entity replaces the first part one,
+  the other parts keep their own materials.
+
+  \param[in,out] queue		Queue of the frame.
+  \param[in] entity		Submitted entity.
+  \param[in] projection		Global projection matrix.
+  \param[in] view			Global view matrix.
+*/
+void submitEntity(RenderQueue& queue, EntityRegistry::Entity entity, const glm::mat4& projection, const glm::mat4& view);
+/// Typical OpenGL context setup 
+/**
+  Sets up OpenGL context of a object from already packed data.
+
+  \param[in] vertices		Packed vertex data for target object.
+  \param[in] vertexSize		Size of vertex data in bytes.
+  \param[in] indices		Face data for target object.
+  \param[in] indexCount		Number of indices in face data.
+  \param[in] indexType		Datatype of indices.
+  \param[in] layout			Layout of the packed vertex data.
+  \param[out] outObject		Target object to be setup.
 */
-void fogUniforms(Shader& shader);
+void setBuffers(const GLvoid* vertices, GLsizeiptr vertexSize, const GLvoid* indices, GLuint indexCount, GLenum indexType, const VertexBufferLayout& layout, MeshData& outObject);
 /// Typical OpenGL context setup 
 /**
-  Sets up OpenGL context of a object the usual way.
+  Sets up OpenGL context of a object from packed mesh.
+
+  \param[in] mesh			Packed mesh.
+  \param[out] outObject		Target object to be setup.
+*/
+void setBuffers(const PackedMesh& mesh, MeshData& outObject);
+/// Typical OpenGL context setup 
+/**
+  Sets up OpenGL context of a object the usual way, vertex data are quantized first.
 
   \param[in] vertices		Vertex data for target object.
   \param[in] indices		Face data for target object.
@@ -137,70 +287,210 @@ void setBuffers(const std::vector<GLfloat>& vertices, const std::vector<GLuint>&
   Loads geometry of the mesh from assimp context.
 
   \param[in] mesh			Assimp context.
-  \param[out] outObject		Target object to be setup.
+  \param[out] outVertices	Interleaved vertex data.
+  \param[out] outIndices	Face data.
 */
-void loadMeshGeometry(const aiMesh& mesh, MeshData& outObject);
+void loadMeshGeometry(const aiMesh& mesh, std::vector<GLfloat>& outVertices, std::vector<GLuint>& outIndices);
 /// Load material from assimp context.
 /**
-  Loads material of the object from assimp context.
+  Loads material of the object part from assimp context.
 
   \param[in] material		Assimp context.
   \param[in] path			Path context.
+  \param[out] outAsset		Target part to be setup.
+*/
+void loadMeshMaterial(const aiMaterial& material, const std::string& path, SubmeshAsset& outAsset);
+/// Load bounds of the object.
+/**
+  Computes bounding box of the vertices and bounding sphere around its center.
+
+  \param[in] vertices		Interleaved float vertex data starting with position.
+  \param[in] stride		Number of floats per vertex.
+  \param[out] outLower	Lower corner of the box.
+  \param[out] outUpper	Upper corner of the box.
+  \param[out] outCenter	Center of the sphere.
+  \param[out] outRadius	Radius of the sphere.
+*/
+void loadMeshBounds(const std::vector<GLfloat>& vertices, size_t stride, glm::vec3& outLower, glm::vec3& outUpper, glm::vec3& outCenter, GLfloat& outRadius);
+/// Load texture of the object.
+/**
+  Loads diffuse texture of the object part, returns nullptr if there is none.
+
+  \param[in] texture		Texture path, empty if there is none.
+*/
+std::shared_ptr<TextureResource> loadMeshTexture(const std::string& texture);
+/// Rebase indices of the object parts.
+/**
+  Adds base vertex of each part to its indices, so the parts can be drawn
+  without base vertex support.
+
+  \param[in] indices		Packed face data.
+  \param[in] indexCount		Number of indices in face data.
+  \param[in] indexType		Datatype of indices.
+  \param[in] submeshes		Parts of the object.
+*/
+std::vector<GLuint> rebaseIndices(const GLvoid* indices, GLuint indexCount, GLenum indexType, const std::vector<SubmeshAsset>& submeshes);
+/// Load collision of the object.
+/**
+  Keeps positions and full detail triangles of all parts of the packed object
+  and builds hierarchy over them for ray queries.
+
+  \param[in,out] outAsset	Parsed asset with packed or cached geometry.
+*/
+void loadMeshCollision(MeshAsset& outAsset);
+/// Load object from binary mesh cache.
+/**
+  Loads object from the .pgrmesh cache that belongs to the given source, if the cache is up to date.
+
+  \param[in] path			Path context.
+  \param[in] hash			Hash of the source files.
+  \param[out] outAsset		Target asset to be setup.
+*/
+bool loadMeshCache(const std::string& path, uint64_t hash, MeshAsset& outAsset);
+/// Parse object from wavefront file.
+/**
+  Parses object from the binary mesh cache, or from the file using assimp
+  and regenerates the cache. Parsing is skipped if the registry has the mesh already.
+  Triangles for ray queries are kept as well.
+  Doesn't touch OpenGL, so it can run on any thread.
+
+  \param[in] path			Path context.
+  \param[out] outAsset		Target asset to be setup.
+*/
+bool parseMesh(const std::string& path, MeshAsset& outAsset);
+/// Upload parsed object.
+/**
+  Uploads parsed object into OpenGL buffers and loads its texture,
+  unless the registry has the mesh already.
+
+  \param[in] asset			Parsed object.
   \param[out] outObject		Target object to be setup.
 */
-void loadMeshMaterial(const aiMaterial& material, const std::string& path, MeshData& outObject);
+void uploadMesh(const MeshAsset& asset, MeshData& outObject);
 /// Load object from wavefront file.
 /**
-  Loads object from the file using assimp.
+  Parses and uploads object on the calling thread.
 
   \param[in] path			Path context.
   \param[out] outObject		Target object to be setup.
 */
 bool loadMesh(const std::string& path, MeshData& outObject);
-/// Draw lights using shader.
+/// Load object from wavefront file asynchronously.
 /**
-  Sets up the shader with lighting.
+  Parses object on the loader worker and uploads it once the loader finishes.
 
-  \param[in] shader		Target shader.
+  \param[in] loader			Asset loader.
+  \param[in] path			Path context.
+  \param[out] outObject		Target object to be setup.
+  \param[in] done			Called after the upload with the load result.
 */
-void drawLights(Shader& shader);
-/// Draw fog using shader.
+void loadMeshAsync(AssetLoader& loader, const std::string& path, MeshData& outObject, std::function<void(bool)> done);
+/// Load entities from wavefront file asynchronously.
 /**
-  Sets up the shader with fog.
+  Parses object once on the loader worker, uploads it once the loader finishes
+  and assigns it with its default material to all given entities.
 
-  \param[in] shader		Target shader.
+  \param[in] loader			Asset loader.
+  \param[in] path			Path context.
+  \param[in] entities		Target entities.
+  \param[in] done			Called after the upload with the load result.
 */
-void drawFog(Shader& shader);
-/// Initialize skybox.
+void loadEntitiesAsync(AssetLoader& loader, const std::string& path, const std::vector<EntityRegistry::Entity>& entities, std::function<void(bool)> done);
+/// Generate pyramid asynchronously.
 /**
-  Initializes skybox.
+  Generates pyramid on the loader worker and uploads it once the loader finishes.
+  Material of the entity is kept.
+
+  \param[in] loader			Asset loader.
+  \param[in] layers			Number of pyramid layers.
+  \param[in] entity			Target entity.
 */
-void initSky();
-/// Draw skybox.
+void loadPyramidAsync(AssetLoader& loader, unsigned int layers, EntityRegistry::Entity entity);
+/// Load instanced props from wavefront file asynchronously.
+/**
+  Parses object on the loader worker, uploads it once the loader finishes
+  and builds vertex array of the batch with per instance model matrices.
+
+  \param[in] loader			Asset loader.
+  \param[in] path			Path context.
+  \param[in] batch			Target batch with its transforms set.
+  \param[in] shader			Instanced shader program.
+  \param[in] done			Called after the upload with the load result.
+*/
+void loadPropsAsync(AssetLoader& loader, const std::string& path, std::shared_ptr<PropBatch> batch, Shader& shader, std::function<void(bool)> done);
+/// Place entity.
+/**
+  Sets transform of the entity standing on the ground.
+
+  \param[in] entity			Target entity.
+  \param[in] position		Ground position.
+  \param[in] lift			Vertical offset of the origin.
+  \param[in] scale			Scale of the entity.
+*/
+void placeEntity(EntityRegistry::Entity entity, const glm::vec3& position, float lift, const glm::vec3& scale);
+/// Prepare entities.
 /**
-  Draws skybox.
+  Submits all visible entities with loaded mesh into the scene queue.
+  Entities with bounds outside the view frustum are skipped, the queue is sorted
+  once for all passes of the frame.
 
   \param[in] projection		Global projection matrix.
   \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
 */
-void drawSky(const glm::mat4& projection, const glm::mat4& view, Shader& shader);
-/// Initialize generated pyramid.
+void prepareEntities(const glm::mat4& projection, const glm::mat4& view);
+/// Draw depth of entities.
 /**
-  Initializes generated pyramid.
+  Draws depth of opaque entities in the scene queue whose shader has depth pair.
+
+  \param[in] projection		Global projection matrix.
+  \param[in] view			Global view matrix.
+  \param[in] renderer		Target renderer.
+  \param[in] prepass		Depth pre-pass.
 */
-void initGeneratedPyramid();
-/// Draw generated pyramid.
+void drawEntitiesDepth(const glm::mat4& projection, const glm::mat4& view, Renderer& renderer, const DepthPrepass& prepass);
+/// Draw geometry of entities.
 /**
-  Draws generated pyramid.
+  Draws opaque entities in the scene queue whose shader has geometry pair into the G-buffer.
+
+  \param[in] projection		Global projection matrix.
+  \param[in] view			Global view matrix.
+  \param[in] renderer		Target renderer.
+  \param[in] deferred		Deferred path.
+*/
+void drawEntitiesGeometry(const glm::mat4& projection, const glm::mat4& view, Renderer& renderer, const DeferredShading& deferred);
+/// Draw entities.
+/**
+  Executes the scene queue, entities drawn by active pre-pass only shade their visible fragments.
+  Entities lit by enabled deferred path are skipped.
 
   \param[in] projection		Global projection matrix.
   \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
   \param[in] renderer		Target renderer.
+  \param[in] prepass		Depth pre-pass.
+  \param[in] deferred		Deferred path.
   \param[in] elapsedTime	Time context.
 */
-void drawGeneratedPyramid(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer, float elapsedTime);
+void drawEntities(const glm::mat4& projection, const glm::mat4& view, Renderer& renderer, const DepthPrepass& prepass, const DeferredShading& deferred, float elapsedTime);
+/// Initialize skybox.
+/**
+  Initializes skybox.
+*/
+void initSky();
+/// Draw skybox.
+/**
+  Draws skybox, matrices come from the frame block.
+
+  \param[in] shader			Target shader.
+*/
+void drawSky(Shader& shader);
+/// Initialize generated pyramid.
+/**
+  Initializes generated pyramid.
+
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
+*/
+void initGeneratedPyramid(AssetLoader& loader, Shader& shader);
 /// Handle click on generated pyramid.
 /**
   Handles click on generated pyramid.
@@ -209,108 +499,59 @@ void clickGeneratedPyramid();
 /// Initialize stone pyramid.
 /**
   Initializes stone pyramid.
-*/
-void initStonePyramid();
-/// Draw stone pyramid.
-/**
-  Draws stone pyramid.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawStonePyramid(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initStonePyramid(AssetLoader& loader, Shader& shader);
 /// Initialize quartz pyramid.
 /**
   Initializes quartz pyramid.
-*/
-void initQuartzPyramid();
-/// Draw quartz pyramid.
-/**
-  Draws quartz pyramid.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawQuartzPyramid(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initQuartzPyramid(AssetLoader& loader, Shader& shader);
 /// Initialize desert.
 /**
   Initializes desert.
-*/
-void initDesert();
-/// Draw desert.
-/**
-  Draws desert.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawDesert(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initDesert(AssetLoader& loader, Shader& shader);
 /// Initialize aloe.
 /**
   Initializes aloe.
-*/
-void initAloe();
-/// Draw aloe.
-/**
-  Draws aloe.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawAloe(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initAloe(AssetLoader& loader, Shader& shader);
 /// Initialize cactus0.
 /**
   Initializes cactus0.
-*/
-void initCactus0();
-/// Draw cactus0.
-/**
-  Draws cactus0.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawCactus0(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initCactus0(AssetLoader& loader, Shader& shader);
 /// Initialize cactus1.
 /**
   Initializes cactus1.
-*/
-void initCactus1();
-/// Draw cactus1.
-/**
-  Draws cactus1.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawCactus1(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initCactus1(AssetLoader& loader, Shader& shader);
 /// Initialize rock0.
 /**
   Initializes rock0.
-*/
-void initRock0();
-/// Draw rock0.
-/**
-  Draws rock0.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawRock0(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initRock0(AssetLoader& loader, Shader& shader);
 /// Handle click on rock0.
 /**
   Handles click on rock0.
@@ -319,34 +560,19 @@ void clickRock0();
 /// Initialize rock1.
 /**
   Initializes rock1.
-*/
-void initRock1();
-/// Draw rock1.
-/**
-  Draws rock1.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawRock1(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initRock1(AssetLoader& loader, Shader& shader);
 /// Initialize infinite texture.
 /**
   Initializes infinite texture.
-*/
-void initInfiniteTexture();
-/// Draw infinite texture.
-/**
-  Draws infinite texture.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
-  \param[in] elapsedTime	Time context.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawInfiniteTexture(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer, float elapsedTime);
+void initInfiniteTexture(AssetLoader& loader, Shader& shader);
 /// Handle click on infinite texture.
 /**
   Handles click on infinite texture.
@@ -355,34 +581,112 @@ void clickInfiniteTexture();
 /// Initialize billboard.
 /**
   Initializes billboard.
+
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
+*/
+void initBillboard(AssetLoader& loader, Shader& shader);
+/// Initialize scattered props.
+/**
+  Initializes props scattered around the desert, all props of one kind share single mesh.
+  Props are drawn instanced if the context supports it, otherwise they become entities.
+
+  \param[in] loader			Asset loader.
+  \param[in] shader			Shader program of entities.
+  \param[in] instancedShader	Shader program of instanced props.
+  \param[in] count			Number of props.
 */
-void initBillboard();
-/// Draw billboard.
+void initScatter(AssetLoader& loader, Shader& shader, Shader& instancedShader, size_t count);
+/// Prepare scattered props.
 /**
-  Draws billboard.
+  Culls props of all populations in single pass, uploads matrices of the visible ones
+  and selects level of detail of every population.
 
   \param[in] projection		Global projection matrix.
   \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
+*/
+void prepareProps(const glm::mat4& projection, const glm::mat4& view);
+/// Draw depth of scattered props.
+/**
+  Draws depth of visible props, every population in single call per part.
+
+  \param[in] shader			Instanced depth shader program.
   \param[in] renderer		Target renderer.
-  \param[in] elapsedTime	Time context.
 */
-void drawBillboard(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer, float elapsedTime);
-/// Initialize player.
+void drawPropsDepth(Shader& shader, const Renderer& renderer);
+/// Draw geometry of scattered props.
 /**
-  Initializes player.
+  Draws visible props into the G-buffer, every population in single call per part.
+
+  \param[in] projection		Global projection matrix.
+  \param[in] view			Global view matrix.
+  \param[in] shader			Instanced geometry shader program.
+  \param[in] renderer		Target renderer.
 */
-void initPlayer();
-/// Draw player.
+void drawPropsGeometry(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+/// Draw scattered props.
 /**
-  Draws player.
+  Draws visible props, every instanced population in single call per part.
+  Props drawn by active pre-pass only shade their visible fragments,
+  props lit by enabled deferred path aren't drawn.
 
   \param[in] projection		Global projection matrix.
   \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
+  \param[in] shader			Instanced shader program.
   \param[in] renderer		Target renderer.
+  \param[in] prepass		Depth pre-pass.
+  \param[in] deferred		Deferred path.
+*/
+void drawProps(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer, const DepthPrepass& prepass, const DeferredShading& deferred);
+/// Report culling.
+/**
+  Prints statistics of the last culling pass of entities and props.
 */
-void drawPlayer(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void reportCulling();
+/// Initialize ground.
+/**
+  Bakes the desert into heightfield over the area cars drive in.
+  Has to be called once the desert is loaded, cars drive on flat ground without it.
+*/
+void initGround();
+/// Place cars.
+/**
+  Puts all cars onto the ground in one batch, tilts them to its slope
+  and updates their cameras and model matrices.
+*/
+void placeCars();
+/// Submit lights.
+/**
+  Adds point light and spot light of the scene, headlights of the cars
+  and siren of the police to the light list.
+
+  \param[in] lights		Light list of the frame.
+  \param[in] elapsedTime	Time context.
+*/
+void submitLights(LightClusters& lights, float elapsedTime);
+/// Initialize colliders.
+/**
+  Registers solid entities, props and cars in the collision world. Entities collide
+  by their kept triangles, props by their boxes and cars as spheres.
+  Has to be called once all meshes are loaded.
+*/
+void initColliders();
+/// Body center of the car.
+/**
+  Returns center of the collision body resting on the ground under the car.
+
+  \param[in] car			Target car.
+  \param[in] position		Position of the car.
+*/
+glm::vec3 bodyCenter(const Car& car, const glm::vec3& position);
+/// Initialize player.
+/**
+  Initializes player.
+
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
+*/
+void initPlayer(AssetLoader& loader, Shader& shader);
 /// Increase player's speed.
 /**
   Increases player's speed.
@@ -412,7 +716,7 @@ void turnRightPlayer();
 void updatePlayer(float elapsedTime);
 /// Move player.
 /**
-  Moves player, including collision and boundary checks.
+  Moves player through the collision world, blocked move stops the car.
 
   \param[in] elapsedTime	Time context.
 */
@@ -425,18 +729,11 @@ void switchToPlayer();
 /// Initialize police.
 /**
   Initializes police.
-*/
-void initPolice();
-/// Draw police.
-/**
-  Draws police.
 
-  \param[in] projection		Global projection matrix.
-  \param[in] view			Global view matrix.
-  \param[in] shader			Target shader.
-  \param[in] renderer		Target renderer.
+  \param[in] loader		Asset loader.
+  \param[in] shader		Shader program.
 */
-void drawPolice(const glm::mat4& projection, const glm::mat4& view, Shader& shader, const Renderer& renderer);
+void initPolice(AssetLoader& loader, Shader& shader);
 /// Update police.
 /**
   Updates police.
@@ -444,6 +741,17 @@ void drawPolice(const glm::mat4& projection, const glm::mat4& view, Shader& shad
   \param[in] elapsedTime	Time context.
 */
 void updatePolice(float elapsedTime);
+/// Update police sight.
+/**
+  Casts ray from police to player and keeps whether the player is in the line
+  of sight. Uses the scene hierarchy of the last update.
+*/
+void updatePoliceSight();
+/// Report police sight.
+/**
+  Prints whether the police saw the player on the last update.
+*/
+void reportPoliceSight();
 /// Switch to police.
 /**
   Switches to police's camera.
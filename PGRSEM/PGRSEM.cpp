@@ -16,10 +16,24 @@ Shader* ObjectShader;
 Shader* PyramidShader;
 Shader* InfiniteShader;
 Shader* BillboardShader;
+Shader* InstancedShader;
+Shader* DepthShader;
+Shader* DepthInstancedShader;
+Shader* GBufferShader;
+Shader* GBufferInstancedShader;
+Shader* DeferredShader;
+Shader* LightVolumeShader;
 // Renderer
 Renderer* CoreRenderer;
+DepthPrepass* Prepass;
+DeferredShading* Deferred;
+LightClusters* Clusters;
+RenderGraph* Graph;
 
 extern CameraSystem CameraManager; ///< Global app camera handler
+extern RingBuffer* ObjectUniforms; ///< Per draw uniform blocks
+extern EntityRegistry Scene; ///< Global scene entities
+extern CollisionWorld Collisions; ///< Global colliders
 
 /// Struct that wrapps application state context.
 /**
@@ -44,17 +58,31 @@ struct AppState
 } AppState;
 /// Evaluate clicked object.
 /**
-  Evaluates which object clicked was clicked.
+  Evaluates which object clicked was clicked, casts ray from the camera
+  through the clicked pixel into the scene.
 
   \param[in] x	Mouse position x.
   \param[in] y	Mouse position y.
 */
 void setClickedObject(int x, int y)
 {
-	uint8_t clickedObjectID;
-	glReadPixels(x, AppState.Height - y - 1, 1, 1, GL_STENCIL_INDEX, GL_UNSIGNED_BYTE, &clickedObjectID);
+	glm::mat4 inverse = glm::inverse(Projection * View);
+	float ndcX = 2.0f * (x + 0.5f) / AppState.Width - 1.0f;
+	float ndcY = 1.0f - 2.0f * (y + 0.5f) / AppState.Height;
 
-	switch (clickedObjectID)
+	// pixel on the near and far plane
+	glm::vec4 nearPoint = inverse * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverse * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+
+	glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 target = glm::vec3(farPoint) / farPoint.w;
+
+	RayHit hit = Scene.Raycast(origin, glm::normalize(target - origin), glm::distance(origin, target));
+
+	if (!hit.Hit)
+		return;
+
+	switch (Scene.PickIds[hit.Entity])
 	{
 	case 1:
 		clickGeneratedPyramid();
@@ -93,23 +121,12 @@ float setCurrentTime(float& objectTime)
 */
 void initialize()
 {
-	Renderer::Initialize(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), []() { glEnable(GL_DEPTH_TEST); glutSetCursor(GLUT_CURSOR_NONE); });
-
-	// initialize objects
-	initSky();
-	initGeneratedPyramid();
-	initInfiniteTexture();
-	initQuartzPyramid();
-	initStonePyramid();
-	initBillboard();
-	initDesert();
-	initAloe();
-	initRock0();
-	initRock1();
-	initPlayer();
-	initPolice();
-	initCactus0();
-	initCactus1();
+	Renderer::Initialize(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), []() { StateTracker::Enable(GL_DEPTH_TEST); glutSetCursor(GLUT_CURSOR_NONE); });
+	VertexQuantizer::Initialize();
+	MeshOptimizer::Initialize();
+	TextureCooker::Initialize();
+	TextureStreamer::Initialize();
+	GeometryPool::Initialize();
 
 	// initializes shaders
 	SkyboxShader = new Shader("skybox_shader.vert", "skybox_shader.frag");
@@ -117,12 +134,86 @@ void initialize()
 	PyramidShader = new Shader("per_fragment_shader_geometry.vert", "per_fragment_shader_geometry.frag");
 	InfiniteShader = new Shader("per_fragment_shader_move.vert", "per_fragment_shader_move.frag");
 	BillboardShader = new Shader("per_fragment_shader_billboard.vert", "per_fragment_shader_billboard.frag");
+	InstancedShader = new Shader("per_fragment_shader_instanced.vert", "per_fragment_shader.frag");
+	DepthShader = new Shader("depth_shader.vert", "depth_shader.frag");
+	DepthInstancedShader = new Shader("depth_shader_instanced.vert", "depth_shader.frag");
+	GBufferShader = new Shader("per_fragment_shader.vert", "gbuffer_shader.frag");
+	GBufferInstancedShader = new Shader("per_fragment_shader_instanced.vert", "gbuffer_shader.frag");
+	DeferredShader = new Shader("deferred_shader.vert", "deferred_shader.frag");
+	LightVolumeShader = new Shader("light_volume_shader.vert", "light_volume_shader.frag");
+
+	// geometry shaders write the G-buffer targets in order of their attachments
+	GBufferShader->BindOutputs({ "albedo_final", "specular_final", "normal_final", "ambient_final" });
+	GBufferInstancedShader->BindOutputs({ "albedo_final", "specular_final", "normal_final", "ambient_final" });
+
+	// mesh attributes take the locations of the mesh vertex arrays, instance matrix follows them
+	InstancedShader->BindAttributes({ "vertexPosition", "vertexNormal", "texCoord", "instanceModel" });
+
+	// depth and geometry shaders read the vertex arrays of their lighting shaders
+	DepthShader->MatchAttributes(*ObjectShader);
+	DepthInstancedShader->MatchAttributes(*InstancedShader);
+	GBufferShader->MatchAttributes(*ObjectShader);
+	GBufferInstancedShader->MatchAttributes(*InstancedShader);
+
+	// initializes uniform blocks shared by all shaders
+	initUniformBlocks();
+
+	for (Shader* shader : { SkyboxShader, ObjectShader, PyramidShader, InfiniteShader, BillboardShader, InstancedShader, DepthShader, DepthInstancedShader,
+		GBufferShader, GBufferInstancedShader, DeferredShader, LightVolumeShader })
+		bindUniformBlocks(*shader);
+
+	// pyramids, billboard and moving plane shift their vertices, they are lit without pre-pass
+	Prepass = new DepthPrepass();
+	Prepass->AddShader(*ObjectShader, *DepthShader);
+	Prepass->AddShader(*InstancedShader, *DepthInstancedShader);
+
+	// the same shaders are lit by the deferred path, the others stay forward
+	Deferred = new DeferredShading(*DeferredShader, *LightVolumeShader);
+	Deferred->AddShader(*ObjectShader, *GBufferShader);
+	Deferred->AddShader(*InstancedShader, *GBufferInstancedShader);
+
+	// forward shaders loop over lights of their cluster, light volumes read the same list
+	Clusters = new LightClusters();
+
+	// initialize objects, parsing runs on workers while this thread uploads
+	// entities are drawn in creation order, pickable and blended ones last
+	AssetLoader loader;
+
+	initQuartzPyramid(loader, *ObjectShader);
+	initStonePyramid(loader, *ObjectShader);
+	initBillboard(loader, *BillboardShader);
+	initCactus0(loader, *ObjectShader);
+	initCactus1(loader, *ObjectShader);
+	initDesert(loader, *ObjectShader);
+	initPlayer(loader, *ObjectShader);
+	initPolice(loader, *ObjectShader);
+	initAloe(loader, *ObjectShader);
+	initScatter(loader, *ObjectShader, *InstancedShader, SCATTER_COUNT);
+	initGeneratedPyramid(loader, *PyramidShader);
+	initInfiniteTexture(loader, *InfiniteShader);
+	initRock0(loader, *ObjectShader);
+	initRock1(loader, *ObjectShader);
+
+	initSky();
+	loader.Finish();
+
+	// ground and colliders need loaded meshes, bodies rest on the ground
+	initGround();
+	initColliders();
+
+	// uploads bind through pgr helpers behind the tracker
+	StateTracker::Invalidate();
+	StateTracker::Enable(GL_DEPTH_TEST);
+
+	ResourceRegistry::Report();
+	GeometryPool::Report();
 
 	// initializes renderer
 	CoreRenderer = new Renderer();
+	Graph = new RenderGraph();
 
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	glEnable(GL_BLEND);
+	StateTracker::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	StateTracker::Enable(GL_BLEND);
 }
 /// Updates application.
 /**
@@ -165,7 +256,12 @@ void update()
 	// update dynamic objects
 	updatePlayer(AppState.ElapsedTime);
 	updatePolice(AppState.ElapsedTime);
+	placeCars();
 	updateSpectate(AppState.ElapsedTime);
+
+	// ray queries see the objects where they are drawn this frame
+	Scene.UpdateHierarchy();
+	updatePoliceSight();
 }
 /// Draws application.
 /**
@@ -173,44 +269,71 @@ void update()
 */
 void draw()
 {
-	// draw lights
-	drawLights(*ObjectShader);
-	drawLights(*PyramidShader);
-	drawLights(*InfiniteShader);
-	drawLights(*BillboardShader);
-
-	// draw fog
-	drawFog(*ObjectShader);
-	drawFog(*PyramidShader);
-	drawFog(*InfiniteShader);
-	drawFog(*BillboardShader);
-
-	// draw skybox
-	drawSky(Projection, View, *SkyboxShader);
-
-	// draw objects
-	drawQuartzPyramid(Projection, View, *ObjectShader, *CoreRenderer);
-	drawStonePyramid(Projection, View, *ObjectShader, *CoreRenderer);
-	drawBillboard(Projection, View, *BillboardShader, *CoreRenderer, AppState.ElapsedTime);
-	drawCactus0(Projection, View, *ObjectShader, *CoreRenderer);
-	drawCactus1(Projection, View, *ObjectShader, *CoreRenderer);
-	drawDesert(Projection, View, *ObjectShader, *CoreRenderer);
-	drawPlayer(Projection, View, *ObjectShader, *CoreRenderer);
-	drawPolice(Projection, View, *ObjectShader, *CoreRenderer);
-	drawAloe(Projection, View, *ObjectShader, *CoreRenderer);
-
-	unsigned int id = 0;
-	glEnable(GL_STENCIL_TEST);
-	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
-	glStencilFunc(GL_ALWAYS, (id++) + 1, -1);
-	drawGeneratedPyramid(Projection, View, *PyramidShader, *CoreRenderer, AppState.ElapsedTime);
-	glStencilFunc(GL_ALWAYS, (id++) + 1, -1);
-	drawInfiniteTexture(Projection, View, *InfiniteShader, *CoreRenderer, AppState.ElapsedTime);
-	glStencilFunc(GL_ALWAYS, (id++) + 1, -1);
-	drawRock0(Projection, View, *ObjectShader, *CoreRenderer);
-	glDisable(GL_STENCIL_TEST);
-
-	drawRock1(Projection, View, *ObjectShader, *CoreRenderer);
+	// update camera and fog for all shaders
+	updateUniformBlocks(Projection, View, *CameraManager.Current);
+
+	// cull objects once, both passes draw the same ones
+	prepareProps(Projection, View);
+	prepareEntities(Projection, View);
+
+	// lights follow the cars, both paths read the same light list
+	Clusters->ClearLights();
+	submitLights(*Clusters, AppState.ElapsedTime);
+	Clusters->Assign(Projection, View, AppState.Width, AppState.Height);
+
+	// pre-pass is decided before the passes are declared
+	Prepass->Update();
+
+	Graph->Reset(AppState.Width, AppState.Height);
+
+	// skybox goes first without depth writes, the first pass clears the screen
+	RenderGraph::Pass sky = Graph->AddPass("sky", []()
+	{
+		drawSky(*SkyboxShader);
+	});
+	Graph->Write(sky, RenderGraph::BACKBUFFER);
+
+	if (Deferred->IsEnabled())
+	{
+		// G-buffer holds depth of its own, pre-pass isn't drawn
+		Deferred->AddPasses(*Graph, Projection, View, *Clusters, []()
+		{
+			Prepass->BeginMeasure(AppState.Width * AppState.Height);
+			drawPropsGeometry(Projection, View, *GBufferInstancedShader, *CoreRenderer);
+			drawEntitiesGeometry(Projection, View, *CoreRenderer, *Deferred);
+			Prepass->EndMeasure();
+		});
+	}
+	else if (Prepass->IsActive())
+	{
+		RenderGraph::Pass depth = Graph->AddPass("depth pre-pass", []()
+		{
+			// overdraw is counted in the first pass writing depth of the objects
+			Prepass->BeginMeasure(AppState.Width * AppState.Height);
+			Prepass->BeginPass();
+			drawPropsDepth(*DepthInstancedShader, *CoreRenderer);
+			drawEntitiesDepth(Projection, View, *CoreRenderer, *Prepass);
+			Prepass->EndPass();
+			Prepass->EndMeasure();
+		});
+		Graph->Write(depth, RenderGraph::BACKBUFFER);
+	}
+
+	// opaque props go before the queue ends with blended entities
+	// deferred path leaves only unpaired shaders and blended draws here
+	RenderGraph::Pass objects = Graph->AddPass("objects", []()
+	{
+		if (!Prepass->IsActive() && !Deferred->IsEnabled())
+			Prepass->BeginMeasure(AppState.Width * AppState.Height);
+
+		drawProps(Projection, View, *InstancedShader, *CoreRenderer, *Prepass, *Deferred);
+		drawEntities(Projection, View, *CoreRenderer, *Prepass, *Deferred, AppState.ElapsedTime);
+		Prepass->EndMeasure();
+	});
+	Graph->Write(objects, RenderGraph::BACKBUFFER);
+
+	Graph->Compile();
+	Graph->Execute();
 }
 /// Cleanup application.
 /**
@@ -218,13 +341,29 @@ void draw()
 */
 void cleanup()
 {
+	TextureStreamer::Shutdown();
+	GeometryPool::Shutdown();
+
 	delete CoreRenderer;
+	delete Prepass;
+	delete Deferred;
+	delete Clusters;
+	delete Graph;
+
+	cleanupUniformBlocks();
 
 	delete SkyboxShader;
 	delete ObjectShader;
 	delete PyramidShader;
 	delete InfiniteShader;
 	delete BillboardShader;
+	delete InstancedShader;
+	delete DepthShader;
+	delete DepthInstancedShader;
+	delete GBufferShader;
+	delete GBufferInstancedShader;
+	delete DeferredShader;
+	delete LightVolumeShader;
 }
 /// Callback for display func.
 /**
@@ -232,13 +371,14 @@ void cleanup()
 */
 void displayCB()
 {
-	CoreRenderer->Clear();
+	TextureStreamer::Update();
 
 	Projection = glm::perspective(glm::radians(60.0f), float(AppState.Width) / float(AppState.Height), 0.1f, 100.0f);
 	View = CameraManager.Current->GetViewMatrix();
 
 	draw();
 
+	StateTracker::EndFrame();
 	glutSwapBuffers();
 }
 /// Callback for reshape func.
@@ -297,6 +437,29 @@ void keyboardCB(unsigned char key, int, int)
 	case 'i':
 		switchToSpectate();
 		break;
+	case 'r':
+		CoreRenderer->Report();
+		StateTracker::Report();
+		GeometryPool::Report();
+		ObjectUniforms->Report();
+		reportCulling();
+		reportPoliceSight();
+		Collisions.Report();
+		Prepass->Report();
+		Deferred->Report();
+		Clusters->Report();
+		Graph->Report();
+		break;
+	case 'g':
+		// deferred path, forward shaders as fallback
+		Deferred->SetEnabled(!Deferred->IsEnabled());
+		Deferred->Report();
+		break;
+	case 'z':
+		// automatic mode, forced on, forced off
+		Prepass->SetMode(Prepass->GetMode() == PrepassMode::AUTO ? PrepassMode::ON : Prepass->GetMode() == PrepassMode::ON ? PrepassMode::OFF : PrepassMode::AUTO);
+		Prepass->Report();
+		break;
 	case KEY_1:
 		CameraManager.SwitchTo(&CameraManager.Cameras[0]);
 		CameraManager.IsStatic = true;
@@ -497,7 +660,7 @@ int main(int argc, char** argv)
 
 	glutInitContextVersion(pgr::OGL_VER_MAJOR, pgr::OGL_VER_MINOR);
 	glutInitContextFlags(GLUT_FORWARD_COMPATIBLE);
-	glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH | GLUT_STENCIL);
+	glutInitDisplayMode(GLUT_RGB | GLUT_DOUBLE | GLUT_DEPTH);
 
 	glutInitWindowSize(WIN_WIDTH, WIN_HEIGHT);
 	glutCreateWindow(WIN_TITLE);
@@ -14,7 +14,13 @@
 
 PyramidData PyramidGenerator::Generate(unsigned int layers)
 {
-	return { GenerateVertices(layers), GenerateTriangles(layers) };
+	PyramidData data;
+	data.Vertices = GenerateVertices(layers);
+	data.Triangles = GenerateTriangles(layers);
+
+	GenerateBounds(data);
+
+	return data;
 }
 
 std::vector<float> PyramidGenerator::GenerateVertices(unsigned int layers)
@@ -129,3 +135,25 @@ std::vector<unsigned int> PyramidGenerator::GenerateTriangles(unsigned int layer
 
 	return temp;
 }
+
+void PyramidGenerator::GenerateBounds(PyramidData& data)
+{
+	if (data.Vertices.size() < 3)
+		return;
+
+	glm::vec3 lower = glm::vec3(data.Vertices[0], data.Vertices[1], data.Vertices[2]);
+	glm::vec3 upper = lower;
+
+	// vertices are position followed by normal
+	for (size_t i = 0; i + 2 < data.Vertices.size(); i += 6)
+	{
+		glm::vec3 position = glm::vec3(data.Vertices[i], data.Vertices[i + 1], data.Vertices[i + 2]);
+		lower = glm::min(lower, position);
+		upper = glm::max(upper, position);
+	}
+
+	data.BoundsMin = lower;
+	data.BoundsMax = upper;
+	data.Center = (lower + upper) * 0.5f;
+	data.Radius = glm::length(upper - data.Center);
+}
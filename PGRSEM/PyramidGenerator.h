@@ -14,6 +14,8 @@
 
 #include <vector>
 
+#include "pgr.h"
+
 /// Struct that contains Pyramid render data.
 /**
 	This struct contains Pyramid data for render.
@@ -22,6 +24,11 @@ struct PyramidData
 {
 	std::vector<float> Vertices; ///< Positions
 	std::vector<unsigned int> Triangles; ///< Faces
+
+	glm::vec3 BoundsMin = glm::vec3(0.0f); ///< Lower corner of the bounding box
+	glm::vec3 BoundsMax = glm::vec3(0.0f); ///< Upper corner of the bounding box
+	glm::vec3 Center = glm::vec3(0.0f); ///< Center of the bounding sphere
+	float Radius = 0.0f; ///< Radius of the bounding sphere
 };
 
 /// Static class that generates pyramid objects.
@@ -60,4 +67,11 @@ private:
 		\param[in] layers	Number of pyramid layers.
 	*/
 	static std::vector<unsigned int> GenerateTriangles(unsigned int layers);
+	/// Generate bounds.
+	/**
+		Computes bounding box of generated vertices and bounding sphere around its center.
+
+		\param[in,out] data	Generated pyramid.
+	*/
+	static void GenerateBounds(PyramidData& data);
 };
\ No newline at end of file
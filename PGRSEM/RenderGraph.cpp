@@ -0,0 +1,384 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       RenderGraph.cpp
+ * \author     Dominik Pupala
+ * \date       2021/09/06
+ * \brief      Source file for render graph.
+ *
+ *  Source file containing declarations for RenderGraph class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "RenderGraph.h"
+#include "StateTracker.h"
+
+#include <iostream>
+#include <algorithm>
+
+RenderGraph::RenderGraph()
+	: _culled(0), _transientSize(0), _physicalSize(0)
+{
+	Reset(0, 0);
+}
+
+RenderGraph::~RenderGraph()
+{
+	for (const auto& framebuffer : _framebuffers)
+		StateTracker::DeleteFramebuffer(framebuffer.second);
+
+	for (const Texture& texture : _textures)
+		StateTracker::DeleteTexture(texture.ID);
+}
+
+void RenderGraph::Reset(GLsizei width, GLsizei height)
+{
+	_passes.clear();
+	_resources.clear();
+
+	// screen is imported, it's never allocated nor culled
+	_resources.push_back({ "backbuffer", width, height, GL_NONE, glm::vec4(0.0f), 0, 0, 0 });
+}
+
+RenderGraph::Resource RenderGraph::Create(const std::string& name, GLsizei width, GLsizei height, GLenum format, const glm::vec4& clearColor)
+{
+	_resources.push_back({ name, width, height, format, clearColor, 0, 0, 0 });
+
+	return _resources.size() - 1;
+}
+
+RenderGraph::Pass RenderGraph::AddPass(const std::string& name, std::function<void()> execute)
+{
+	PassNode pass;
+	pass.Name = name;
+	pass.Execute = std::move(execute);
+	pass.Alive = false;
+	pass.Framebuffer = 0;
+
+	_passes.push_back(std::move(pass));
+
+	return _passes.size() - 1;
+}
+
+void RenderGraph::Read(Pass pass, Resource resource)
+{
+	_passes[pass].Reads.push_back(resource);
+}
+
+void RenderGraph::Write(Pass pass, Resource resource)
+{
+	_passes[pass].Writes.push_back(resource);
+}
+
+void RenderGraph::Compile()
+{
+	std::vector<GLubyte> needed(_resources.size(), 0);
+	needed[BACKBUFFER] = 1;
+
+	_culled = 0;
+
+	// walking backwards, pass lives if a later living pass needs anything it writes
+	for (size_t i = _passes.size(); i-- > 0;)
+	{
+		PassNode& pass = _passes[i];
+		pass.Alive = false;
+		pass.Clears.clear();
+
+		for (Resource resource : pass.Writes)
+			pass.Alive = pass.Alive || needed[resource];
+
+		if (!pass.Alive)
+		{
+			++_culled;
+			continue;
+		}
+
+		// earlier writes are kept too, attached resources are drawn over
+		for (Resource resource : pass.Reads)
+			needed[resource] = 1;
+
+		for (Resource resource : pass.Writes)
+			needed[resource] = 1;
+	}
+
+	// lifetimes span living passes from the first use to the last one
+	std::vector<GLubyte> seen(_resources.size(), 0);
+
+	for (size_t i = 0; i < _passes.size(); ++i)
+	{
+		PassNode& pass = _passes[i];
+
+		if (!pass.Alive)
+			continue;
+
+		for (const auto* uses : { &pass.Reads, &pass.Writes })
+		{
+			for (Resource resource : *uses)
+			{
+				if (!seen[resource])
+				{
+					_resources[resource].First = i;
+
+					// resource read before any write holds nothing, it's cleared all the same
+					pass.Clears.push_back(resource);
+				}
+
+				seen[resource] = 1;
+				_resources[resource].Last = i;
+			}
+		}
+	}
+
+	for (Texture& texture : _textures)
+		texture.Used = false;
+
+	// physical textures return to the free list once their last pass is done
+	std::vector<size_t> free;
+	_transientSize = 0;
+
+	for (size_t i = 0; i < _passes.size(); ++i)
+	{
+		if (!_passes[i].Alive)
+			continue;
+
+		for (Resource resource = BACKBUFFER + 1; resource < _resources.size(); ++resource)
+		{
+			ResourceNode& node = _resources[resource];
+
+			if (seen[resource] && node.First == i)
+			{
+				node.Texture = Allocate(node, free);
+				_transientSize += (GLsizeiptr)node.Width * node.Height * GetPixelSize(node.Format);
+			}
+		}
+
+		for (Resource resource = BACKBUFFER + 1; resource < _resources.size(); ++resource)
+		{
+			if (seen[resource] && _resources[resource].Last == i)
+				free.push_back(_resources[resource].Texture);
+		}
+	}
+
+	// textures of other sizes and their framebuffers are released
+	for (size_t i = _textures.size(); i-- > 0;)
+	{
+		if (_textures[i].Used)
+			continue;
+
+		for (auto it = _framebuffers.begin(); it != _framebuffers.end();)
+		{
+			if (std::find(it->first.begin(), it->first.end(), _textures[i].ID) != it->first.end())
+			{
+				StateTracker::DeleteFramebuffer(it->second);
+				it = _framebuffers.erase(it);
+			}
+			else
+				++it;
+		}
+
+		_physicalSize -= (GLsizeiptr)_textures[i].Width * _textures[i].Height * GetPixelSize(_textures[i].Format);
+		StateTracker::DeleteTexture(_textures[i].ID);
+		_textures.erase(_textures.begin() + i);
+
+		// indices behind the erased texture move
+		for (ResourceNode& node : _resources)
+			if (node.Texture > i)
+				--node.Texture;
+	}
+
+	for (PassNode& pass : _passes)
+		pass.Framebuffer = pass.Alive ? GetFramebuffer(pass) : 0;
+}
+
+void RenderGraph::Execute()
+{
+	for (const PassNode& pass : _passes)
+	{
+		if (!pass.Alive)
+			continue;
+
+		const ResourceNode& target = _resources[pass.Writes.empty() ? BACKBUFFER : pass.Writes[0]];
+
+		StateTracker::BindFramebuffer(pass.Framebuffer);
+		glViewport(0, 0, target.Width, target.Height);
+
+		// clears obey the write masks, full writes are needed for them
+		if (!pass.Clears.empty())
+		{
+			StateTracker::ColorMask(GL_TRUE);
+			StateTracker::DepthMask(GL_TRUE);
+		}
+
+		GLint color = 0;
+
+		for (Resource resource : pass.Writes)
+		{
+			bool clear = std::find(pass.Clears.begin(), pass.Clears.end(), resource) != pass.Clears.end();
+
+			if (resource == BACKBUFFER)
+			{
+				if (clear)
+					glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+				continue;
+			}
+
+			const ResourceNode& node = _resources[resource];
+
+			if (IsDepth(node.Format))
+			{
+				GLfloat depth = 1.0f;
+
+				if (clear)
+					glClearBufferfv(GL_DEPTH, 0, &depth);
+			}
+			else
+			{
+				if (clear)
+					glClearBufferfv(GL_COLOR, color, &node.ClearColor[0]);
+
+				++color;
+			}
+		}
+
+		pass.Execute();
+	}
+
+	StateTracker::BindFramebuffer(0);
+	StateTracker::ColorMask(GL_TRUE);
+	StateTracker::DepthMask(GL_TRUE);
+	glViewport(0, 0, _resources[BACKBUFFER].Width, _resources[BACKBUFFER].Height);
+}
+
+GLuint RenderGraph::GetTexture(Resource resource) const
+{
+	size_t texture = _resources[resource].Texture;
+
+	return resource == BACKBUFFER || texture >= _textures.size() ? 0 : _textures[texture].ID;
+}
+
+void RenderGraph::Report() const
+{
+	std::cout << "Render graph: " << _passes.size() << " passes (" << _culled << " culled), "
+		<< (_resources.size() - 1) << " transient resources in " << _textures.size() << " textures, "
+		<< (_physicalSize >> 10) << " KB (" << (_transientSize >> 10) << " KB without aliasing)" << std::endl;
+}
+
+size_t RenderGraph::Allocate(const ResourceNode& resource, std::vector<size_t>& free)
+{
+	for (size_t i = 0; i < free.size(); ++i)
+	{
+		const Texture& texture = _textures[free[i]];
+
+		if (texture.Width == resource.Width && texture.Height == resource.Height && texture.Format == resource.Format)
+		{
+			size_t index = free[i];
+			free.erase(free.begin() + i);
+			_textures[index].Used = true;
+			return index;
+		}
+	}
+
+	// textures kept from previous frames come before new ones
+	for (size_t i = 0; i < _textures.size(); ++i)
+	{
+		Texture& texture = _textures[i];
+
+		if (!texture.Used && texture.Width == resource.Width && texture.Height == resource.Height && texture.Format == resource.Format)
+		{
+			texture.Used = true;
+			return i;
+		}
+	}
+
+	Texture texture;
+	texture.Width = resource.Width;
+	texture.Height = resource.Height;
+	texture.Format = resource.Format;
+	texture.Used = true;
+
+	bool depth = IsDepth(resource.Format);
+
+	glGenTextures(1, &texture.ID);
+	StateTracker::ActiveTexture(GL_TEXTURE0);
+	StateTracker::BindTexture(GL_TEXTURE_2D, texture.ID);
+
+	// format and type only describe data that isn't uploaded
+	glTexImage2D(GL_TEXTURE_2D, 0, resource.Format, resource.Width, resource.Height, 0, depth ? GL_DEPTH_COMPONENT : GL_RGBA, depth ? GL_FLOAT : GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	_physicalSize += (GLsizeiptr)resource.Width * resource.Height * GetPixelSize(resource.Format);
+	_textures.push_back(texture);
+
+	return _textures.size() - 1;
+}
+
+GLuint RenderGraph::GetFramebuffer(const PassNode& pass)
+{
+	std::vector<GLuint> key;
+
+	for (Resource resource : pass.Writes)
+	{
+		if (resource == BACKBUFFER)
+			return 0;
+
+		key.push_back(_textures[_resources[resource].Texture].ID);
+	}
+
+	if (key.empty())
+		return 0;
+
+	auto found = _framebuffers.find(key);
+
+	if (found != _framebuffers.end())
+		return found->second;
+
+	GLuint framebuffer;
+	glGenFramebuffers(1, &framebuffer);
+	StateTracker::BindFramebuffer(framebuffer);
+
+	std::vector<GLenum> buffers;
+
+	for (size_t i = 0; i < pass.Writes.size(); ++i)
+	{
+		GLenum attachment = IsDepth(_resources[pass.Writes[i]].Format) ? GL_DEPTH_ATTACHMENT : GL_COLOR_ATTACHMENT0 + (GLenum)buffers.size();
+
+		if (attachment != GL_DEPTH_ATTACHMENT)
+			buffers.push_back(attachment);
+
+		glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, key[i], 0);
+	}
+
+	// depth only pass draws no color
+	if (buffers.empty())
+		glDrawBuffer(GL_NONE);
+	else
+		glDrawBuffers((GLsizei)buffers.size(), buffers.data());
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cout << "creating framebuffer of pass " << pass.Name << " has failed!" << std::endl;
+
+	StateTracker::BindFramebuffer(0);
+	_framebuffers[key] = framebuffer;
+
+	return framebuffer;
+}
+
+bool RenderGraph::IsDepth(GLenum format)
+{
+	return format == GL_DEPTH_COMPONENT16 || format == GL_DEPTH_COMPONENT24 || format == GL_DEPTH_COMPONENT32F;
+}
+
+GLsizei RenderGraph::GetPixelSize(GLenum format)
+{
+	switch (format)
+	{
+	case GL_DEPTH_COMPONENT16:	return 2;
+	case GL_RGBA16F:			return 8;
+	case GL_RGBA32F:			return 16;
+	default:					return 4;
+	}
+}
@@ -0,0 +1,208 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       RenderGraph.h
+ * \author     Dominik Pupala
+ * \date       2021/09/06
+ * \brief      Header file for render graph.
+ *
+ *  Header file containing definitions for RenderGraph class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <functional>
+
+#include "pgr.h"
+
+/// Class that orders passes of single frame and owns their transient targets.
+/**
+  This class collects passes of the frame together with resources they read and write,
+  passes run in the order they were added. Written resources are attached to the framebuffer
+  of the pass, read ones are sampled by it. Passes whose writes reach neither the screen
+  nor any living pass are culled. Transient textures are only alive between their first
+  and last use, textures of equal size and format whose lifetimes don't overlap share
+  single physical texture. First write of every resource in the frame clears it.
+  Physical textures and framebuffers are kept for following frames of the same shape.
+*/
+class RenderGraph
+{
+public:
+	typedef size_t Resource; ///< Handle of resource of the frame
+	typedef size_t Pass; ///< Handle of pass of the frame
+
+	static constexpr Resource BACKBUFFER = 0; ///< Color and depth of the default framebuffer
+
+private:
+	/// Struct that contains declared resource.
+	struct ResourceNode
+	{
+		std::string Name; ///< Name of the resource
+		GLsizei Width; ///< Width in pixels
+		GLsizei Height; ///< Height in pixels
+		GLenum Format; ///< Internal format
+		glm::vec4 ClearColor; ///< Color of the first write, depth is cleared to one
+		size_t First; ///< First living pass using the resource
+		size_t Last; ///< Last living pass using the resource
+		size_t Texture; ///< Physical texture assigned by the compilation
+	};
+
+	/// Struct that contains declared pass.
+	struct PassNode
+	{
+		std::string Name; ///< Name of the pass
+		std::function<void()> Execute; ///< Draws of the pass
+		std::vector<Resource> Reads; ///< Sampled resources
+		std::vector<Resource> Writes; ///< Attached resources
+		std::vector<Resource> Clears; ///< Resources first written by the pass
+		bool Alive; ///< Pass contributes to the screen
+		GLuint Framebuffer; ///< Framebuffer assigned by the compilation
+	};
+
+	/// Struct that contains physical texture.
+	struct Texture
+	{
+		GLuint ID; ///< OpenGL ID handle
+		GLsizei Width; ///< Width in pixels
+		GLsizei Height; ///< Height in pixels
+		GLenum Format; ///< Internal format
+		bool Used; ///< Texture was assigned in the last compilation
+	};
+
+	std::vector<ResourceNode> _resources; ///< Resources of the frame, screen first
+	std::vector<PassNode> _passes; ///< Passes of the frame in order of execution
+	std::vector<Texture> _textures; ///< Physical textures
+	std::map<std::vector<GLuint>, GLuint> _framebuffers; ///< Framebuffers by attached textures
+
+	size_t _culled; ///< Passes culled by the last compilation
+	GLsizeiptr _transientSize; ///< Bytes of transient resources of the last compilation
+	GLsizeiptr _physicalSize; ///< Bytes of physical textures
+
+public:
+	/// Constructor
+	/**
+		Creates empty graph.
+	*/
+	RenderGraph();
+	/// Destructor
+	/**
+		Deletes physical textures and framebuffers.
+	*/
+	~RenderGraph();
+	/// Reset graph.
+	/**
+		Removes passes and resources of the previous frame, physical textures are kept.
+
+		\param[in] width	Width of the screen.
+		\param[in] height	Height of the screen.
+	*/
+	void Reset(GLsizei width, GLsizei height);
+	/// Create resource.
+	/**
+		Declares transient texture living only within the frame.
+
+		\param[in] name			Name of the resource.
+		\param[in] width		Width in pixels.
+		\param[in] height		Height in pixels.
+		\param[in] format		Internal format, four channel color or depth.
+		\param[in] clearColor	Color of the first write.
+	*/
+	Resource Create(const std::string& name, GLsizei width, GLsizei height, GLenum format, const glm::vec4& clearColor = glm::vec4(0.0f));
+	/// Add pass.
+	/**
+		Declares pass, its draws run with its framebuffer bound.
+
+		\param[in] name		Name of the pass.
+		\param[in] execute	Draws of the pass.
+	*/
+	Pass AddPass(const std::string& name, std::function<void()> execute);
+	/// Read resource.
+	/**
+		Declares resource sampled by the pass.
+
+		\param[in] pass			Reading pass.
+		\param[in] resource		Read resource.
+	*/
+	void Read(Pass pass, Resource resource);
+	/// Write resource.
+	/**
+		Declares resource attached to the framebuffer of the pass. Color attachments
+		follow the order of writes, screen can't be mixed with transient resources.
+
+		\param[in] pass			Writing pass.
+		\param[in] resource		Written resource.
+	*/
+	void Write(Pass pass, Resource resource);
+	/// Compile graph.
+	/**
+		Culls passes, assigns physical textures to living resources and framebuffers
+		to living passes. Physical textures left unused are deleted.
+	*/
+	void Compile();
+	/// Execute graph.
+	/**
+		Runs living passes, binds their framebuffers, sets viewport and clears resources
+		on their first write. Default framebuffer and full color and depth writes are
+		restored afterwards.
+	*/
+	void Execute();
+	/// Texture getter.
+	/**
+		Returns physical texture of the resource, valid while the graph executes.
+		Screen and culled resources have none.
+
+		\param[in] resource		Target resource.
+	*/
+	GLuint GetTexture(Resource resource) const;
+	/// Width getter.
+	/**
+		Returns width of the screen.
+	*/
+	inline GLsizei GetWidth() const { return _resources[BACKBUFFER].Width; }
+	/// Height getter.
+	/**
+		Returns height of the screen.
+	*/
+	inline GLsizei GetHeight() const { return _resources[BACKBUFFER].Height; }
+	/// Report statistics.
+	/**
+		Prints passes, culled passes and memory of transient resources of the last compilation.
+	*/
+	void Report() const;
+
+private:
+	/// Allocate texture.
+	/**
+		Returns physical texture of the size and format free during the lifetime,
+		a new one is created if there is none.
+
+		\param[in] resource		Allocated resource.
+		\param[in] free			Physical textures free at the start of the lifetime.
+	*/
+	size_t Allocate(const ResourceNode& resource, std::vector<size_t>& free);
+	/// Get framebuffer.
+	/**
+		Returns framebuffer with the textures attached, a new one is created if there is none.
+
+		\param[in] pass		Pass of the framebuffer.
+	*/
+	GLuint GetFramebuffer(const PassNode& pass);
+	/// Depth format test.
+	/**
+		Returns true if the internal format holds depth.
+
+		\param[in] format	Internal format.
+	*/
+	static bool IsDepth(GLenum format);
+	/// Format size.
+	/**
+		Returns bytes of single pixel of the internal format.
+
+		\param[in] format	Internal format.
+	*/
+	static GLsizei GetPixelSize(GLenum format);
+};
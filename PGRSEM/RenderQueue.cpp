@@ -0,0 +1,61 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       RenderQueue.cpp
+ * \author     Dominik Pupala
+ * \date       2021/29/05
+ * \brief      Source file for render queue.
+ *
+ *  Source file containing declarations for RenderQueue class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "RenderQueue.h"
+
+#include <cstring>
+#include <algorithm>
+
+void RenderQueue::Submit(Shader& shader, const MeshResource& mesh, const Submesh& part, size_t lod, const MaterialData& material, GLfloat depth, BlendMode blend, size_t owner)
+{
+	DrawItem item;
+	item.Program = &shader;
+	item.Mesh = &mesh;
+	item.Part = &part;
+	item.Material = &material;
+	item.Lod = lod;
+	item.Owner = owner;
+	item.Blend = blend;
+
+	GLuint texture = material.Texture ? material.Texture->ID : 0;
+	item.Key = MakeKey(blend == BlendMode::NONE ? PASS_OPAQUE : PASS_BLENDED, shader.GetID(), texture, mesh.VAO->GetID(), depth);
+
+	_items.push_back(item);
+}
+
+void RenderQueue::Sort()
+{
+	std::stable_sort(_items.begin(), _items.end(), [](const DrawItem& a, const DrawItem& b) { return a.Key < b.Key; });
+}
+
+uint64_t RenderQueue::MakeKey(uint64_t pass, GLuint shader, GLuint texture, GLuint va, GLfloat depth)
+{
+	// bit pattern of non-negative float grows with its value, its top bits keep the order
+	GLfloat clamped = std::max(depth, 0.0f);
+	uint32_t bits;
+	std::memcpy(&bits, &clamped, sizeof(bits));
+
+	uint64_t quantized = bits >> (32 - DEPTH_BITS);
+	uint64_t state = (uint64_t)(shader & ((1u << SHADER_BITS) - 1)) << (TEXTURE_BITS + VERTEX_ARRAY_BITS)
+		| (uint64_t)(texture & ((1u << TEXTURE_BITS) - 1)) << VERTEX_ARRAY_BITS
+		| (uint64_t)(va & ((1u << VERTEX_ARRAY_BITS) - 1));
+
+	uint64_t key = pass << (64 - PASS_BITS);
+
+	if (pass == PASS_OPAQUE)
+		return key | state << DEPTH_BITS | quantized;
+
+	// farther blended draws have to come first
+	quantized = ((1u << DEPTH_BITS) - 1) - quantized;
+
+	return key | quantized << (SHADER_BITS + TEXTURE_BITS + VERTEX_ARRAY_BITS) | state;
+}
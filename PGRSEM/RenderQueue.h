@@ -0,0 +1,105 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       RenderQueue.h
+ * \author     Dominik Pupala
+ * \date       2021/29/05
+ * \brief      Header file for render queue.
+ *
+ *  Header file containing definitions for RenderQueue class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+#include "Shader.h"
+#include "ResourceRegistry.h"
+
+/// Blending of the draw.
+enum class BlendMode { NONE, ALPHA, ADDITIVE };
+
+/// Struct that contains single draw.
+/**
+	This struct contains everything needed to draw single part of mesh.
+	Uniforms of the draw are set up by the owner once the shader is bound.
+*/
+struct DrawItem
+{
+	uint64_t Key = 0; ///< Sort key
+	Shader* Program = nullptr; ///< Shader program
+	const MeshResource* Mesh = nullptr; ///< Shared buffers
+	const Submesh* Part = nullptr; ///< Drawn part
+	const MaterialData* Material = nullptr; ///< Material of the part
+	size_t Lod = 0; ///< Level of detail
+	size_t Owner = 0; ///< Index of the submitting object
+	BlendMode Blend = BlendMode::NONE; ///< Blending of the draw
+};
+
+/// Class that collects draws of single frame.
+/**
+  This class collects draws and orders them by 64-bit key, so draws sharing
+  state end up next to each other. Opaque draws come first grouped by shader,
+  texture and vertex array and front to back inside the group. Blended draws
+  follow back to front, state only breaks ties.
+  Only low bits of OpenGL names fit into the key, names above them lose grouping.
+*/
+class RenderQueue
+{
+public:
+	static constexpr uint64_t PASS_OPAQUE = 0; ///< Pass of opaque draws
+	static constexpr uint64_t PASS_BLENDED = 1; ///< Pass of blended draws
+
+private:
+	static constexpr unsigned int PASS_BITS = 2; ///< Bits of the pass
+	static constexpr unsigned int SHADER_BITS = 10; ///< Bits of the shader name
+	static constexpr unsigned int TEXTURE_BITS = 14; ///< Bits of the texture name
+	static constexpr unsigned int VERTEX_ARRAY_BITS = 14; ///< Bits of the vertex array name
+	static constexpr unsigned int DEPTH_BITS = 24; ///< Bits of the depth
+
+	std::vector<DrawItem> _items; ///< Submitted draws
+
+public:
+	/// Submit draw.
+	/**
+		Adds single part of the mesh to the queue.
+
+		\param[in] shader	Shader program.
+		\param[in] mesh		Shared buffers.
+		\param[in] part		Drawn part.
+		\param[in] lod		Level of detail.
+		\param[in] material	Material of the part, has to outlive the queue.
+		\param[in] depth	Distance from the camera.
+		\param[in] blend	Blending of the draw.
+		\param[in] owner	Index of the submitting object.
+	*/
+	void Submit(Shader& shader, const MeshResource& mesh, const Submesh& part, size_t lod, const MaterialData& material, GLfloat depth, BlendMode blend, size_t owner);
+	/// Sort draws.
+	/**
+		Orders draws by their keys, draws with equal keys keep submission order.
+	*/
+	void Sort();
+	/// Clear queue.
+	/**
+		Removes all draws, the memory is kept for the next frame.
+	*/
+	inline void Clear() { _items.clear(); }
+	/// Draws getter.
+	/**
+		Returns submitted draws.
+	*/
+	inline const std::vector<DrawItem>& GetItems() const { return _items; }
+	/// Create sort key.
+	/**
+		Packs pass, state and quantized depth into single key.
+
+		\param[in] pass		Pass of the draw.
+		\param[in] shader	Shader name.
+		\param[in] texture	Texture name, zero if there is none.
+		\param[in] va		Vertex array name.
+		\param[in] depth	Distance from the camera.
+	*/
+	static uint64_t MakeKey(uint64_t pass, GLuint shader, GLuint texture, GLuint va, GLfloat depth);
+};
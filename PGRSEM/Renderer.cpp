@@ -11,6 +11,15 @@
 //----------------------------------------------------------------------------------------
 
 #include "Renderer.h"
+#include "StateTracker.h"
+
+#include <string>
+#include <iostream>
+#include <unordered_set>
+
+bool Renderer::_baseVertex = false;
+bool Renderer::_instancing = false;
+bool Renderer::_bufferStorage = false;
 
 void Renderer::Draw(const VertexArray& va, const ElementBuffer& eb, const Shader& shader, const GLenum& mode) const
 {
@@ -18,16 +27,258 @@ void Renderer::Draw(const VertexArray& va, const ElementBuffer& eb, const Shader
 	va.Bind();
 	eb.Bind();
 
-	glDrawElements(mode, eb.GetCount(), GL_UNSIGNED_INT, nullptr);
+	glDrawElements(mode, eb.GetCount(), eb.GetType(), nullptr);
+}
+
+void Renderer::Draw(const VertexArray& va, const ElementBuffer& eb, const Submesh& submesh, size_t lod, const Shader& shader, const GLenum& mode) const
+{
+	shader.Bind();
+	va.Bind();
+	eb.Bind();
+
+	DrawRange(eb, submesh, lod, mode);
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const ElementBuffer& eb, const Submesh& submesh, size_t lod, GLsizei count, const Shader& shader, const GLenum& mode) const
+{
+	shader.Bind();
+	va.Bind();
+	eb.Bind();
+
+	IndexRange range = submesh.GetLevel(lod);
+	const GLvoid* offset = reinterpret_cast<const GLvoid*>((size_t)range.First * VertexBufferElement::GetSizeOfType(eb.GetType()));
+
+	if (submesh.BaseVertex != 0)
+		glDrawElementsInstancedBaseVertex(mode, range.Count, eb.GetType(), offset, count, submesh.BaseVertex);
+	else
+		glDrawElementsInstanced(mode, range.Count, eb.GetType(), offset, count);
+}
+
+void Renderer::Execute(const RenderQueue& queue, const std::function<void(const DrawItem&)>& setup, const DepthPrepass* prepass, const DeferredShading* deferred)
+{
+	_stats = RenderStats();
+
+	const Shader* shader = nullptr;
+	const VertexArray* va = nullptr;
+	const ElementBuffer* eb = nullptr;
+	GLuint texture = 0;
+
+	// texture unit may hold anything left by other draws
+	bool textureKnown = false;
+
+	for (const DrawItem& item : queue.GetItems())
+	{
+		// surface is in the G-buffer and lit already
+		if (deferred && deferred->IsEnabled() && item.Blend == BlendMode::NONE && deferred->GetShader(*item.Program))
+			continue;
+
+		++_stats.Items;
+
+		if (item.Program != shader)
+		{
+			shader = item.Program;
+			shader->Bind();
+			++_stats.ShaderBinds;
+		}
+		else
+			++_stats.Avoided;
+
+		if (item.Mesh->VAO != va)
+		{
+			va = item.Mesh->VAO;
+			eb = item.Mesh->EB;
+			va->Bind();
+			eb->Bind();
+			++_stats.VertexArrayBinds;
+		}
+		else
+			++_stats.Avoided;
+
+		GLuint itemTexture = item.Material->Texture ? item.Material->Texture->ID : 0;
+
+		if (itemTexture != 0)
+		{
+			if (!textureKnown || itemTexture != texture)
+			{
+				texture = itemTexture;
+				textureKnown = true;
+				StateTracker::ActiveTexture(GL_TEXTURE0);
+				StateTracker::BindTexture(GL_TEXTURE_2D, texture);
+				++_stats.TextureBinds;
+			}
+			else
+				++_stats.Avoided;
+		}
+
+		// tracker drops the calls that repeat the state of the previous draw
+		if (item.Blend != BlendMode::NONE)
+		{
+			StateTracker::Enable(GL_BLEND);
+
+			if (item.Blend == BlendMode::ADDITIVE)
+				StateTracker::BlendFunc(GL_ONE, GL_ONE);
+			else
+				StateTracker::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		}
+		else
+			StateTracker::Disable(GL_BLEND);
+
+		// depth of the draw is laid down already, only the fragments matching it are shaded
+		if (prepass && prepass->IsActive() && item.Blend == BlendMode::NONE && prepass->GetShader(*item.Program))
+		{
+			StateTracker::DepthFunc(GL_EQUAL);
+			StateTracker::DepthMask(GL_FALSE);
+		}
+		else
+		{
+			StateTracker::DepthFunc(GL_LESS);
+			StateTracker::DepthMask(GL_TRUE);
+		}
+
+		setup(item);
+
+		DrawRange(*eb, *item.Part, item.Lod, GL_TRIANGLES);
+	}
+
+	StateTracker::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	StateTracker::Disable(GL_BLEND);
+	StateTracker::DepthFunc(GL_LESS);
+	StateTracker::DepthMask(GL_TRUE);
+}
+
+void Renderer::ExecuteDepth(const RenderQueue& queue, const DepthPrepass& prepass, const std::function<void(const DrawItem&)>& setup)
+{
+	const Shader* shader = nullptr;
+	const VertexArray* va = nullptr;
+	const ElementBuffer* eb = nullptr;
+
+	for (const DrawItem& item : queue.GetItems())
+	{
+		// blended draws keep depth of what lies behind them
+		if (item.Blend != BlendMode::NONE)
+			continue;
+
+		// shaders without pair may move vertices the depth shader doesn't know about
+		Shader* depth = prepass.GetShader(*item.Program);
+
+		if (!depth)
+			continue;
+
+		if (depth != shader)
+		{
+			shader = depth;
+			shader->Bind();
+		}
+
+		if (item.Mesh->VAO != va)
+		{
+			va = item.Mesh->VAO;
+			eb = item.Mesh->EB;
+			va->Bind();
+			eb->Bind();
+		}
+
+		setup(item);
+
+		DrawRange(*eb, *item.Part, item.Lod, GL_TRIANGLES);
+	}
+}
+
+void Renderer::ExecuteGeometry(const RenderQueue& queue, const DeferredShading& deferred, const std::function<void(const DrawItem&)>& setup)
+{
+	const Shader* shader = nullptr;
+	const VertexArray* va = nullptr;
+	const ElementBuffer* eb = nullptr;
+	GLuint texture = 0;
+
+	for (const DrawItem& item : queue.GetItems())
+	{
+		// G-buffer holds single surface per pixel, blended draws stay forward
+		if (item.Blend != BlendMode::NONE)
+			continue;
+
+		Shader* geometry = deferred.GetShader(*item.Program);
+
+		if (!geometry)
+			continue;
+
+		if (geometry != shader)
+		{
+			shader = geometry;
+			shader->Bind();
+		}
+
+		if (item.Mesh->VAO != va)
+		{
+			va = item.Mesh->VAO;
+			eb = item.Mesh->EB;
+			va->Bind();
+			eb->Bind();
+		}
+
+		GLuint itemTexture = item.Material->Texture ? item.Material->Texture->ID : 0;
+
+		// sorted parts sharing texture bind it once
+		if (itemTexture != 0 && itemTexture != texture)
+		{
+			texture = itemTexture;
+			StateTracker::ActiveTexture(GL_TEXTURE0);
+			StateTracker::BindTexture(GL_TEXTURE_2D, texture);
+		}
+
+		setup(item);
+
+		DrawRange(*eb, *item.Part, item.Lod, GL_TRIANGLES);
+	}
+}
+
+void Renderer::Report() const
+{
+	size_t binds = _stats.ShaderBinds + _stats.TextureBinds + _stats.VertexArrayBinds;
+
+	std::cout << "Render queue: " << _stats.Items << " draws, "
+		<< binds << " binds (" << _stats.ShaderBinds << " shader, " << _stats.TextureBinds << " texture, " << _stats.VertexArrayBinds << " vertex array), "
+		<< _stats.Avoided << " avoided" << std::endl;
+}
+
+void Renderer::DrawRange(const ElementBuffer& eb, const Submesh& submesh, size_t lod, GLenum mode) const
+{
+	IndexRange range = submesh.GetLevel(lod);
+	const GLvoid* offset = reinterpret_cast<const GLvoid*>((size_t)range.First * VertexBufferElement::GetSizeOfType(eb.GetType()));
+
+	if (submesh.BaseVertex != 0)
+		glDrawElementsBaseVertex(mode, range.Count, eb.GetType(), offset, submesh.BaseVertex);
+	else
+		glDrawElements(mode, range.Count, eb.GetType(), offset);
 }
 
 void Renderer::Clear() const
 {
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void Renderer::Initialize(const glm::vec4& color, void (*func)())
 {
+	GLint major = 0, minor = 0, count = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	std::unordered_set<std::string> extensions;
+
+	for (GLint i = 0; i < count; ++i)
+		extensions.insert(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+
+	// base vertex draws are core since OpenGL 3.2, attribute divisors since 3.3
+	_baseVertex = major > 3 || (major == 3 && minor >= 2) || extensions.count("GL_ARB_draw_elements_base_vertex");
+	_instancing = major > 3 || (major == 3 && minor >= 3) || extensions.count("GL_ARB_instanced_arrays");
+
+	// persistent mapping since 4.4, its regions are guarded by fences core since 3.2
+	bool sync = major > 3 || (major == 3 && minor >= 2) || extensions.count("GL_ARB_sync");
+	_bufferStorage = sync && (major > 4 || (major == 4 && minor >= 4) || extensions.count("GL_ARB_buffer_storage"));
+
+	StateTracker::Invalidate();
+
 	glClearColor(color.r, color.g, color.b, color.a);
 	(*func)();
 }
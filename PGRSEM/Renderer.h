@@ -12,9 +12,28 @@
 
 #pragma once
 
+#include <functional>
+
 #include "Shader.h"
 #include "VertexArray.h"
 #include "ElementBuffer.h"
+#include "RenderQueue.h"
+#include "DepthPrepass.h"
+#include "DeferredShading.h"
+#include "ResourceRegistry.h"
+
+/// Struct that contains statistics of executed queue.
+/**
+	This struct contains binds done and skipped while executing single frame.
+*/
+struct RenderStats
+{
+	size_t Items = 0; ///< Executed draws
+	size_t ShaderBinds = 0; ///< Shader programs bound
+	size_t TextureBinds = 0; ///< Textures bound
+	size_t VertexArrayBinds = 0; ///< Vertex arrays bound
+	size_t Avoided = 0; ///< Binds skipped because the state was bound already
+};
 
 /// Class that handles OpenGL renderer.
 /**
@@ -22,6 +41,13 @@
 */
 class Renderer
 {
+private:
+	static bool _baseVertex; ///< Base vertex draws are supported by the context
+	static bool _instancing; ///< Per instance attributes are supported by the context
+	static bool _bufferStorage; ///< Persistently mapped buffers are supported by the context
+
+	RenderStats _stats; ///< Statistics of the last executed queue
+
 public:
 	/// Draw data.
 	/**
@@ -33,6 +59,75 @@ public:
 		\param[in] mode		Drawing mode.
 	*/
 	void Draw(const VertexArray& va, const ElementBuffer& eb, const Shader& shader, const GLenum& mode = GL_TRIANGLES) const;
+	/// Draw part of data.
+	/**
+		Draws single level of single part of data sharing the buffers with other parts.
+
+		\param[in] va		Object data.
+		\param[in] eb		Object face indices.
+		\param[in] submesh	Drawn part.
+		\param[in] lod		Level of detail, zero for full detail.
+		\param[in] shader	Shader program.
+		\param[in] mode		Drawing mode.
+	*/
+	void Draw(const VertexArray& va, const ElementBuffer& eb, const Submesh& submesh, size_t lod, const Shader& shader, const GLenum& mode = GL_TRIANGLES) const;
+	/// Draw instances of part of data.
+	/**
+		Draws single level of single part of data for every instance in one call.
+		Vertex array has to carry per instance attributes, see HasInstancing.
+
+		\param[in] va		Object data with instance data.
+		\param[in] eb		Object face indices.
+		\param[in] submesh	Drawn part.
+		\param[in] lod		Level of detail, zero for full detail.
+		\param[in] count	Number of instances.
+		\param[in] shader	Shader program.
+		\param[in] mode		Drawing mode.
+	*/
+	void DrawInstanced(const VertexArray& va, const ElementBuffer& eb, const Submesh& submesh, size_t lod, GLsizei count, const Shader& shader, const GLenum& mode = GL_TRIANGLES) const;
+	/// Execute queue.
+	/**
+		Draws the sorted queue, shader, texture and vertex array are only bound
+		when they differ from the previous draw. Blend state follows the draws
+		and is disabled afterwards. Draws laid down by active pre-pass are drawn
+		with equal depth test and without depth writes. Draws lit by enabled
+		deferred path are skipped.
+
+		\param[in] queue		Sorted draws of the frame.
+		\param[in] setup		Sets up uniforms of the draw once its shader is bound.
+		\param[in] prepass	Depth pre-pass, null if there is none.
+		\param[in] deferred	Deferred path, null if there is none.
+	*/
+	void Execute(const RenderQueue& queue, const std::function<void(const DrawItem&)>& setup, const DepthPrepass* prepass = nullptr, const DeferredShading* deferred = nullptr);
+	/// Execute depth of queue.
+	/**
+		Draws opaque draws of the sorted queue whose shader has depth pair with the depth shader.
+
+		\param[in] queue		Sorted draws of the frame.
+		\param[in] prepass	Depth pre-pass pairing the shaders.
+		\param[in] setup		Sets up uniforms of the draw once its shader is bound.
+	*/
+	void ExecuteDepth(const RenderQueue& queue, const DepthPrepass& prepass, const std::function<void(const DrawItem&)>& setup);
+	/// Execute geometry of queue.
+	/**
+		Draws opaque draws of the sorted queue whose shader has geometry pair
+		with the geometry shader into the bound G-buffer.
+
+		\param[in] queue		Sorted draws of the frame.
+		\param[in] deferred	Deferred path pairing the shaders.
+		\param[in] setup		Sets up uniforms of the draw once its shader is bound.
+	*/
+	void ExecuteGeometry(const RenderQueue& queue, const DeferredShading& deferred, const std::function<void(const DrawItem&)>& setup);
+	/// Statistics getter.
+	/**
+		Returns statistics of the last executed queue.
+	*/
+	inline const RenderStats& GetStats() const { return _stats; }
+	/// Report statistics.
+	/**
+		Prints statistics of the last executed queue.
+	*/
+	void Report() const;
 	/// Clear screen.
 	/**
 		Clears screen.
@@ -46,6 +141,24 @@ public:
 		\param[in] func		Additional operations.
 	*/
 	static void Initialize(const glm::vec4& color, void(*func)());
+	/// Base vertex support getter.
+	/**
+		Returns true if parts can be drawn with base vertex, otherwise indices
+		of the parts have to be offset on upload.
+	*/
+	static bool HasBaseVertex() { return _baseVertex; }
+	/// Instancing support getter.
+	/**
+		Returns true if vertex attributes can advance per instance,
+		otherwise instances have to be drawn one by one.
+	*/
+	static bool HasInstancing() { return _instancing; }
+	/// Buffer storage support getter.
+	/**
+		Returns true if buffers can stay mapped while the GPU reads them,
+		otherwise dynamic data has to be uploaded.
+	*/
+	static bool HasBufferStorage() { return _bufferStorage; }
 	/// Set screen viewport.
 	/**
 		Sets screen viewport.
@@ -56,5 +169,17 @@ public:
 		\param[in] H	Height.
 	*/
 	static void SetViewport(GLint x, GLint y, GLsizei w, GLsizei h);
+
+private:
+	/// Draw range of bound data.
+	/**
+		Draws single level of single part, the buffers have to be bound already.
+
+		\param[in] eb		Object face indices.
+		\param[in] submesh	Drawn part.
+		\param[in] lod		Level of detail, zero for full detail.
+		\param[in] mode		Drawing mode.
+	*/
+	void DrawRange(const ElementBuffer& eb, const Submesh& submesh, size_t lod, GLenum mode) const;
 };
 
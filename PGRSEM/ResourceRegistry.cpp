@@ -0,0 +1,176 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       ResourceRegistry.cpp
+ * \author     Dominik Pupala
+ * \date       2021/24/05
+ * \brief      Source file for shared resource registry.
+ *
+ *  Source file containing declarations for ResourceRegistry class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "ResourceRegistry.h"
+#include "MeshCache.h"
+#include "TextureCooker.h"
+#include "TextureStreamer.h"
+#include "StateTracker.h"
+
+#include <vector>
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+
+std::mutex ResourceRegistry::_mutex;
+ResourceRegistry::Table<MeshResource> ResourceRegistry::_meshes;
+ResourceRegistry::Table<TextureResource> ResourceRegistry::_textures;
+
+size_t ResourceRegistry::_loaded = 0;
+size_t ResourceRegistry::_loadedSize = 0;
+size_t ResourceRegistry::_shared = 0;
+size_t ResourceRegistry::_sharedSize = 0;
+
+template<typename T>
+std::shared_ptr<T> ResourceRegistry::Table<T>::Find(const std::string& path, uint64_t hash) const
+{
+	// path matches only if the file didn't change since
+	auto byPath = Paths.find(path);
+
+	if (byPath != Paths.end() && byPath->second.first == hash)
+		if (auto resource = byPath->second.second.lock())
+			return resource;
+
+	if (hash == 0)
+		return nullptr;
+
+	auto byHash = Hashes.find(hash);
+
+	if (byHash != Hashes.end())
+		return byHash->second.lock();
+
+	return nullptr;
+}
+
+template<typename T>
+void ResourceRegistry::Table<T>::Add(const std::string& path, uint64_t hash, const std::shared_ptr<T>& resource)
+{
+	Paths[path] = { hash, resource };
+
+	if (hash != 0)
+		Hashes[hash] = resource;
+}
+
+std::string ResourceRegistry::GetCanonicalPath(const std::string& path)
+{
+	std::vector<std::string> segments;
+	std::string segment;
+
+	for (size_t i = 0; i <= path.size(); ++i)
+	{
+		char c = i < path.size() ? path[i] : '/';
+
+		if (c != '/' && c != '\\')
+		{
+#ifdef _WIN32
+			// windows paths are case insensitive
+			c = (char)std::tolower((unsigned char)c);
+#endif
+			segment += c;
+			continue;
+		}
+
+		if (segment == ".." && !segments.empty() && segments.back() != "..")
+			segments.pop_back();
+		else if (!segment.empty() && segment != ".")
+			segments.push_back(segment);
+
+		segment.clear();
+	}
+
+	std::string result = !path.empty() && (path[0] == '/' || path[0] == '\\') ? "/" : "";
+
+	for (size_t i = 0; i < segments.size(); ++i)
+		result += (i ? "/" : "") + segments[i];
+
+	return result;
+}
+
+std::shared_ptr<MeshResource> ResourceRegistry::FindMesh(const std::string& path, uint64_t hash)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	auto mesh = _meshes.Find(GetCanonicalPath(path), hash);
+
+	if (mesh)
+	{
+		++_shared;
+		_sharedSize += mesh->Size;
+
+		for (const auto& submesh : mesh->Submeshes)
+			_sharedSize += submesh.Material.Texture ? submesh.Material.Texture->Size : 0;
+	}
+
+	return mesh;
+}
+
+void ResourceRegistry::AddMesh(const std::string& path, uint64_t hash, const std::shared_ptr<MeshResource>& mesh)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_meshes.Add(GetCanonicalPath(path), hash, mesh);
+
+	++_loaded;
+	_loadedSize += mesh->Size;
+}
+
+std::shared_ptr<TextureResource> ResourceRegistry::AcquireTexture(const std::string& path)
+{
+	std::string canonical = GetCanonicalPath(path);
+	uint64_t hash = MeshCache::HashFile(path);
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto texture = _textures.Find(canonical, hash);
+
+		if (texture)
+		{
+			++_shared;
+			_sharedSize += texture->Size;
+			return texture;
+		}
+	}
+
+	auto texture = std::make_shared<TextureResource>();
+	texture->ID = TextureCooker::CreateTexture(path);
+
+	if (texture->ID == 0)
+		return nullptr;
+
+	GLint width = 0, height = 0, compressed = GL_FALSE, compressedSize = 0;
+	StateTracker::ActiveTexture(GL_TEXTURE0 + TextureStreamer::UPLOAD_UNIT);
+	StateTracker::BindTexture(GL_TEXTURE_2D, texture->ID);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED, &compressed);
+
+	if (compressed)
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressedSize);
+
+	// RGBA texels unless compressed, mipmap chain adds a third
+	texture->Size = (compressed ? (size_t)compressedSize : (size_t)width * height * 4) * 4 / 3;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+	_textures.Add(canonical, hash, texture);
+
+	++_loaded;
+	_loadedSize += texture->Size;
+
+	return texture;
+}
+
+void ResourceRegistry::Report()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< "Resources: " << _loaded << " loaded (" << _loadedSize / 1024.0 << " KB), "
+		<< _shared << " shared (" << _sharedSize / 1024.0 << " KB saved)" << std::endl;
+}
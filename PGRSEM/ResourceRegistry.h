@@ -0,0 +1,258 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       ResourceRegistry.h
+ * \author     Dominik Pupala
+ * \date       2021/24/05
+ * \brief      Header file for shared resource registry.
+ *
+ *  Header file containing definitions for ResourceRegistry class and the shared
+ *  mesh and texture resources it hands out.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <unordered_map>
+
+#include "pgr.h"
+#include "BVH.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "ElementBuffer.h"
+#include "GeometryPool.h"
+#include "StateTracker.h"
+#include "TextureStreamer.h"
+
+/// Struct that contains shared texture.
+/**
+	This struct owns OpenGL texture shared between objects.
+*/
+struct TextureResource
+{
+	GLuint ID = 0; ///< OpenGL texture
+	size_t Size = 0; ///< Approximate GPU memory in bytes
+
+	TextureResource() = default;
+	TextureResource(const TextureResource&) = delete;
+	TextureResource& operator=(const TextureResource&) = delete;
+	/// Destructor
+	/**
+		Drops pending uploads and deletes OpenGL texture.
+	*/
+	inline ~TextureResource()
+	{
+		TextureStreamer::Cancel(ID);
+		StateTracker::DeleteTexture(ID);
+	}
+};
+
+/// Struct that wraps material attributes.
+/**
+	This struct contains material context of object or its part.
+*/
+struct MaterialData
+{
+	glm::vec3 Diffuse = glm::vec3(0.0f);
+	glm::vec3 Ambient = glm::vec3(0.0f);
+	glm::vec3 Specular = glm::vec3(0.0f);
+
+	GLfloat Shininess = 1.0f;
+	std::shared_ptr<TextureResource> Texture;
+};
+
+/// Struct that contains range of indices.
+/**
+	This struct contains range of the shared index buffer.
+*/
+struct IndexRange
+{
+	GLuint First = 0; ///< Offset of the first index
+	GLuint Count = 0; ///< Number of indices
+};
+
+/// Struct that contains part of shared mesh.
+/**
+	This struct contains range of the shared buffers drawn with single material.
+	Indices of the part start from zero, the base vertex is added to them on draw.
+	Simplified levels reference the same vertices as the full detail one.
+*/
+struct Submesh
+{
+	GLuint First = 0; ///< Offset of the first index
+	GLuint Count = 0; ///< Number of indices
+	GLint BaseVertex = 0; ///< Offset of the first vertex
+
+	std::vector<IndexRange> Lods; ///< Simplified levels from the finest one
+
+	MaterialData Material; ///< Default material of the part
+
+	/// Level getter.
+	/**
+		Returns indices of the level, the coarsest one if the part has less levels.
+
+		\param[in] lod		Index of the level, zero for full detail.
+	*/
+	inline IndexRange GetLevel(size_t lod) const
+	{
+		if (lod == 0 || Lods.empty())
+		{
+			IndexRange range;
+			range.First = First;
+			range.Count = Count;
+			return range;
+		}
+
+		return Lods[std::min(lod, Lods.size()) - 1];
+	}
+};
+
+/// Struct that contains shared mesh.
+/**
+	This struct owns OpenGL context and default materials of mesh shared between objects.
+	All parts of the mesh live in the same buffers, pooled meshes share them with other
+	meshes and their parts are offset into the shared ranges.
+*/
+struct MeshResource
+{
+	// OpenGL context, owned by the arena if the mesh is pooled
+	VertexArray* VAO = nullptr;
+	VertexBuffer* VB = nullptr;
+	ElementBuffer* EB = nullptr;
+	VertexBufferLayout* VBL = nullptr;
+
+	std::shared_ptr<GeometryPool::Arena> Arena; ///< Arena holding the buffers, empty if the mesh owns them
+
+	size_t Size = 0; ///< GPU memory in bytes
+
+	glm::vec3 Center = glm::vec3(0.0f); ///< Center of the bounding sphere
+	GLfloat Radius = 0.0f; ///< Radius of the bounding sphere, zero if unknown
+	glm::vec3 BoundsMin = glm::vec3(0.0f); ///< Lower corner of the bounding box
+	glm::vec3 BoundsMax = glm::vec3(0.0f); ///< Upper corner of the bounding box
+
+	std::shared_ptr<MeshBVH> Collision; ///< CPU copy of triangles for ray queries, empty if not kept
+
+	std::vector<Submesh> Submeshes; ///< Parts of the mesh, at least one
+
+	/// Level count getter.
+	/**
+		Returns number of levels of the most detailed part including the full detail one.
+	*/
+	inline size_t GetLodCount() const
+	{
+		size_t count = 1;
+
+		for (const auto& submesh : Submeshes)
+			count = std::max(count, submesh.Lods.size() + 1);
+
+		return count;
+	}
+
+	MeshResource() = default;
+	MeshResource(const MeshResource&) = delete;
+	MeshResource& operator=(const MeshResource&) = delete;
+	/// Destructor
+	/**
+		Deletes allocated memory or returns the ranges to the arena.
+	*/
+	inline ~MeshResource()
+	{
+		if (Arena)
+		{
+			GeometryPool::Release(*this);
+			return;
+		}
+
+		delete VAO;
+		delete VB;
+		delete EB;
+		delete VBL;
+	}
+};
+
+/// Static class that deduplicates shared resources.
+/**
+  This static class keeps track of loaded meshes and textures by canonical path
+  and content hash, so the same file is uploaded only once. Registry doesn't own
+  the resources, they are released with the last handle.
+*/
+class ResourceRegistry
+{
+private:
+	/// Struct that contains lookup tables of single resource type.
+	/**
+		This struct contains weak handles by canonical path and by content hash.
+	*/
+	template<typename T>
+	struct Table
+	{
+		std::unordered_map<std::string, std::pair<uint64_t, std::weak_ptr<T>>> Paths; ///< Hash and handle by path
+		std::unordered_map<uint64_t, std::weak_ptr<T>> Hashes; ///< Handle by hash
+
+		std::shared_ptr<T> Find(const std::string& path, uint64_t hash) const;
+		void Add(const std::string& path, uint64_t hash, const std::shared_ptr<T>& resource);
+	};
+
+	static std::mutex _mutex; ///< Table guard, meshes are looked up from loader workers
+	static Table<MeshResource> _meshes; ///< Mesh table
+	static Table<TextureResource> _textures; ///< Texture table
+
+	static size_t _loaded; ///< Number of uploaded resources
+	static size_t _loadedSize; ///< GPU memory of uploaded resources
+	static size_t _shared; ///< Number of requests served by existing resource
+	static size_t _sharedSize; ///< GPU memory saved by sharing
+
+public:
+	/// Canonical path getter.
+	/**
+		Returns the path with unified separators and resolved dot segments.
+
+		\param[in] path		Filepath to canonicalize.
+	*/
+	static std::string GetCanonicalPath(const std::string& path);
+	/// Find mesh.
+	/**
+		Returns shared mesh loaded from the same path or with the same content,
+		nullptr if there is none.
+
+		\param[in] path		Filepath to the source OBJ file.
+		\param[in] hash		Hash of the source files.
+	*/
+	static std::shared_ptr<MeshResource> FindMesh(const std::string& path, uint64_t hash);
+	/// Add mesh.
+	/**
+		Registers freshly uploaded mesh.
+
+		\param[in] path		Filepath to the source OBJ file.
+		\param[in] hash		Hash of the source files.
+		\param[in] mesh		Uploaded mesh.
+	*/
+	static void AddMesh(const std::string& path, uint64_t hash, const std::shared_ptr<MeshResource>& mesh);
+	/// Acquire texture.
+	/**
+		Returns shared texture loaded from the same path or with the same content,
+		the texture is loaded if there is none. Has to be called on the thread owning
+		OpenGL context.
+
+		\param[in] path		Filepath to the image.
+	*/
+	static std::shared_ptr<TextureResource> AcquireTexture(const std::string& path);
+	/// Report statistics.
+	/**
+		Prints number of loaded and shared resources and memory saved by sharing.
+	*/
+	static void Report();
+
+private:
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	ResourceRegistry() { }
+};
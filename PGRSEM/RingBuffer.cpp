@@ -0,0 +1,147 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       RingBuffer.cpp
+ * \author     Dominik Pupala
+ * \date       2021/02/06
+ * \brief      Source file for OpenGL uniform ring buffer.
+ *
+ *  Source file containing declarations for RingBuffer class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "RingBuffer.h"
+#include "Renderer.h"
+#include "StateTracker.h"
+
+#include <cstring>
+#include <iostream>
+#include <algorithm>
+
+RingBuffer::RingBuffer(GLsizeiptr regionSize, GLuint binding)
+	: _binding(binding), _region(0), _head(0), _mapped(nullptr), _fences(), _blocks(0), _written(0), _stalls(0), _frames(0)
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+	_alignment = std::max(alignment, 1);
+	_regionSize = (regionSize + _alignment - 1) / _alignment * _alignment;
+
+	glGenBuffers(1, &_rendererID);
+	StateTracker::BindBuffer(GL_UNIFORM_BUFFER, _rendererID);
+
+	if (Renderer::HasBufferStorage())
+	{
+		GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		// dynamic storage keeps the uploads working if the mapping fails
+		glBufferStorage(GL_UNIFORM_BUFFER, _regionSize * FRAMES, nullptr, access | GL_DYNAMIC_STORAGE_BIT);
+		_mapped = static_cast<GLubyte*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, _regionSize * FRAMES, access));
+
+		if (_mapped == nullptr)
+			std::cout << "persistent mapping of ring buffer has failed!" << std::endl;
+	}
+	else
+		glBufferData(GL_UNIFORM_BUFFER, _regionSize * FRAMES, nullptr, GL_STREAM_DRAW);
+}
+
+RingBuffer::~RingBuffer()
+{
+	for (GLsync& fence : _fences)
+		if (fence)
+			glDeleteSync(fence);
+
+	if (_mapped)
+	{
+		StateTracker::BindBuffer(GL_UNIFORM_BUFFER, _rendererID);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+	}
+
+	StateTracker::DeleteBuffer(_rendererID);
+}
+
+void RingBuffer::BeginFrame()
+{
+	// uploaded blocks are copied by the driver, only mapped regions need fences
+	if (_mapped)
+		_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	_region = (_region + 1) % FRAMES;
+	_head = 0;
+	++_frames;
+
+	Wait(_fences[_region]);
+}
+
+void RingBuffer::Push(const GLvoid* data, GLsizeiptr size)
+{
+	GLsizeiptr aligned = (size + _alignment - 1) / _alignment * _alignment;
+
+	// block bigger than a region would overrun it, or the whole buffer from the last one
+	if (aligned > _regionSize)
+	{
+		std::cout << "pushing block of " << size << " B into ring buffer has failed!" << std::endl;
+		return;
+	}
+
+	// full region is reused once the draws reading it are done
+	if (_head + aligned > _regionSize)
+	{
+		if (_mapped)
+		{
+			GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			Wait(fence);
+		}
+
+		_head = 0;
+	}
+
+	GLintptr offset = _region * _regionSize + _head;
+	_head += aligned;
+
+	StateTracker::BindBuffer(GL_UNIFORM_BUFFER, _rendererID);
+
+	if (_mapped)
+		std::memcpy(_mapped + offset, data, size);
+	else
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, _binding, _rendererID, offset, size);
+
+	++_blocks;
+	_written += size;
+}
+
+void RingBuffer::Report()
+{
+	size_t frames = _frames > 0 ? _frames : 1;
+
+	std::cout << "Ring buffer: " << (_mapped ? "persistent" : "uploaded") << ", "
+		<< _blocks / frames << " blocks (" << _written / frames << " B) per frame, "
+		<< _stalls << " stalls over " << _frames << " frames" << std::endl;
+
+	_blocks = 0;
+	_written = 0;
+	_stalls = 0;
+	_frames = 0;
+}
+
+void RingBuffer::Wait(GLsync& fence)
+{
+	if (!fence)
+		return;
+
+	GLenum status = glClientWaitSync(fence, 0, 0);
+
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		++_stalls;
+
+		do
+			status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, TIMEOUT);
+		while (status == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+}
@@ -0,0 +1,97 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       RingBuffer.h
+ * \author     Dominik Pupala
+ * \date       2021/02/06
+ * \brief      Header file for OpenGL uniform ring buffer.
+ *
+ *  Header file containing definitions for RingBuffer class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "pgr.h"
+
+/// Class that streams per draw uniform blocks.
+/**
+  This class contains uniform buffer split into one region per frame in flight.
+  Blocks are written one after another into the region of the current frame and
+  bound by range to the binding point, so every draw reads its own block.
+  With buffer storage the buffer stays mapped for its whole life and a region is
+  reused only once the fence of the frame that wrote it has passed, writing a block
+  is then a plain copy. Without it every block is uploaded by the driver.
+*/
+class RingBuffer
+{
+public:
+	static constexpr GLuint FRAMES = 3; ///< Frames in flight
+	static constexpr GLuint64 TIMEOUT = 1000000000; ///< Fence timeout in nanoseconds
+
+private:
+	GLuint _rendererID; ///< OpenGL ID handle
+	GLuint _binding; ///< Binding point
+	GLsizeiptr _regionSize; ///< Size of single frame region
+	GLsizeiptr _alignment; ///< Alignment of bound ranges
+
+	GLuint _region; ///< Region of the current frame
+	GLsizeiptr _head; ///< Offset of the next block in the region
+	GLubyte* _mapped; ///< Persistently mapped buffer, nullptr without buffer storage
+	GLsync _fences[FRAMES]; ///< Fences of the frames that wrote the regions
+
+	size_t _blocks; ///< Blocks written since the last report
+	size_t _written; ///< Bytes written since the last report
+	size_t _stalls; ///< Waits on the GPU since the last report
+	size_t _frames; ///< Frames since the last report
+
+public:
+	/// Constructor
+	/**
+		Creates the OpenGL uniform buffer object with region for every frame in flight.
+
+		\param[in] regionSize	Size of single frame region in bytes.
+		\param[in] binding		Binding point.
+	*/
+	RingBuffer(GLsizeiptr regionSize, GLuint binding);
+	/// Destructor
+	/**
+		Unmaps and deletes the OpenGL uniform buffer object.
+	*/
+	~RingBuffer();
+	/// Begin frame.
+	/**
+		Fences the region of the finished frame and moves to the next one,
+		waiting until the GPU stops reading it.
+	*/
+	void BeginFrame();
+	/// Push block.
+	/**
+		Writes the block behind the previous one and binds its range to the binding point.
+		Full region wraps around once the GPU catches up. Block bigger than a region
+		is refused and the binding point is left as it was.
+
+		\param[in] data		Data laid out by std140 rules.
+		\param[in] size		Size of the data.
+	*/
+	void Push(const GLvoid* data, GLsizeiptr size);
+	/// Persistence getter.
+	/**
+		Returns true if the buffer is persistently mapped.
+	*/
+	inline bool IsPersistent() const { return _mapped != nullptr; }
+	/// Report statistics.
+	/**
+		Prints written blocks and waits since the last report and resets them.
+	*/
+	void Report();
+
+private:
+	/// Wait for fence.
+	/**
+		Blocks until the GPU passes the fence and deletes it.
+
+		\param[in,out] fence	Awaited fence, reset to nullptr.
+	*/
+	void Wait(GLsync& fence);
+};
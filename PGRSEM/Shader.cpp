@@ -12,67 +12,228 @@
 //----------------------------------------------------------------------------------------
 
 #include "Shader.h"
+#include "StateTracker.h"
+
+#include <algorithm>
 
 Shader::Shader(const std::string& vsPath, const std::string& fsPath)
-	: _rendererID(pgr::createProgram({ pgr::createShaderFromFile(GL_VERTEX_SHADER, vsPath), pgr::createShaderFromFile(GL_FRAGMENT_SHADER, fsPath) })) { }
+	: _rendererID(pgr::createProgram({ pgr::createShaderFromFile(GL_VERTEX_SHADER, vsPath), pgr::createShaderFromFile(GL_FRAGMENT_SHADER, fsPath) }))
+{
+	Reflect();
+}
 
 Shader::Shader(const std::string& vsPath, const std::string& gsPath, const std::string& fsPath)
-	: _rendererID(pgr::createProgram({ pgr::createShaderFromFile(GL_VERTEX_SHADER, vsPath), pgr::createShaderFromFile(GL_GEOMETRY_SHADER, gsPath), pgr::createShaderFromFile(GL_FRAGMENT_SHADER, fsPath) })) { }
+	: _rendererID(pgr::createProgram({ pgr::createShaderFromFile(GL_VERTEX_SHADER, vsPath), pgr::createShaderFromFile(GL_GEOMETRY_SHADER, gsPath), pgr::createShaderFromFile(GL_FRAGMENT_SHADER, fsPath) }))
+{
+	Reflect();
+}
 
 Shader::~Shader()
 {
-	glDeleteProgram(_rendererID);
+	StateTracker::DeleteProgram(_rendererID);
 }
 
 void Shader::Bind() const
 {
-	glUseProgram(_rendererID);
+	StateTracker::UseProgram(_rendererID);
 }
 
 void Shader::Unbind() const
 {
-	glUseProgram(0);
+	StateTracker::UseProgram(0);
+}
+
+Shader::Uniform Shader::GetUniform(const std::string& name)
+{
+	auto& names = GetNames();
+	auto found = names.emplace(name, (GLuint)names.size());
+
+	return { found.first->second };
+}
+
+void Shader::SetUniform1i(Uniform uniform, GLint v0)
+{
+	GLint location = Changed(uniform, &v0, 1);
+
+	if (location >= 0)
+		glUniform1i(location, v0);
+}
+
+void Shader::SetUniform1f(Uniform uniform, GLfloat v0)
+{
+	GLint location = Changed(uniform, &v0, 1);
+
+	if (location >= 0)
+		glUniform1f(location, v0);
 }
 
-void Shader::SetUniform1i(const std::string& name, GLint v0)
+void Shader::SetUniform3f(Uniform uniform, GLfloat v0, GLfloat v1, GLfloat v2)
 {
-	glUniform1i(GetUniformLocation(name), v0);
+	GLfloat value[3] = { v0, v1, v2 };
+	GLint location = Changed(uniform, value, 3);
+
+	if (location >= 0)
+		glUniform3fv(location, 1, value);
 }
 
-void Shader::SetUniform1f(const std::string& name, GLfloat v0)
+void Shader::SetUniform3fv(Uniform uniform, GLsizei count, const GLfloat* value)
 {
-	glUniform1f(GetUniformLocation(name), v0);
+	GLint location = Changed(uniform, value, 3 * count);
+
+	if (location >= 0)
+		glUniform3fv(location, count, value);
 }
 
-void Shader::SetUniform3f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2)
+void Shader::SetUniform4f(Uniform uniform, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
 {
-	glUniform3f(GetUniformLocation(name), v0, v1, v2);
+	GLfloat value[4] = { v0, v1, v2, v3 };
+	GLint location = Changed(uniform, value, 4);
+
+	if (location >= 0)
+		glUniform4fv(location, 1, value);
 }
 
-void Shader::SetUniform3fv(const std::string& name, GLsizei count, const GLfloat* value)
+void Shader::SetUniform4fv(Uniform uniform, GLsizei count, const GLfloat* value)
 {
-	glUniform3fv(GetUniformLocation(name), count, value);
+	GLint location = Changed(uniform, value, 4 * count);
+
+	if (location >= 0)
+		glUniform4fv(location, count, value);
 }
 
-void Shader::SetUniform4f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+void Shader::SetUniformMatrix4fv(Uniform uniform, GLsizei count, GLboolean transpose, const GLfloat* value)
 {
-	glUniform4f(GetUniformLocation(name), v0, v1, v2, v3);
+	GLint location = Changed(uniform, value, 16 * count);
+
+	if (location >= 0)
+		glUniformMatrix4fv(location, count, transpose, value);
 }
 
-void Shader::SetUniform4fv(const std::string& name, GLsizei count, const GLfloat* value)
+GLint Shader::GetAttribLocation(const std::string& name) const
 {
-	glUniform4fv(GetUniformLocation(name), count, value);
+	return glGetAttribLocation(_rendererID, name.c_str());
 }
 
-void Shader::SetUniformMatrix4fv(const std::string& name, GLsizei count, GLboolean transpose, const GLfloat* value)
+void Shader::MatchAttributes(const Shader& other)
 {
-	glUniformMatrix4fv(GetUniformLocation(name), count, transpose, value);
+	GLint count = 0, length = 0;
+	glGetProgramiv(_rendererID, GL_ACTIVE_ATTRIBUTES, &count);
+	glGetProgramiv(_rendererID, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &length);
+
+	std::vector<GLchar> buffer(std::max(length, 1));
+
+	for (GLint i = 0; i < count; ++i)
+	{
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveAttrib(_rendererID, i, (GLsizei)buffer.size(), nullptr, &size, &type, buffer.data());
+
+		// matrices take consecutive locations from the first column
+		GLint location = other.GetAttribLocation(buffer.data());
+
+		if (location >= 0)
+			glBindAttribLocation(_rendererID, location, buffer.data());
+	}
+
+	glLinkProgram(_rendererID);
+
+	// link resets uniforms, their locations are looked up again
+	_slots.clear();
+	_shadow.clear();
+	Reflect();
 }
 
-GLint Shader::GetUniformLocation(const std::string& name)
+void Shader::BindAttributes(const std::vector<std::string>& names)
 {
-	if (_uniformCache.find(name) == _uniformCache.end())
-		_uniformCache[name] = glGetUniformLocation(_rendererID, name.c_str());
+	for (size_t i = 0; i < names.size(); ++i)
+		glBindAttribLocation(_rendererID, (GLuint)i, names[i].c_str());
+
+	glLinkProgram(_rendererID);
 
-	return _uniformCache[name];
-}
\ No newline at end of file
+	_slots.clear();
+	_shadow.clear();
+	Reflect();
+}
+
+void Shader::BindOutputs(const std::vector<std::string>& names)
+{
+	for (size_t i = 0; i < names.size(); ++i)
+		glBindFragDataLocation(_rendererID, (GLuint)i, names[i].c_str());
+
+	glLinkProgram(_rendererID);
+
+	_slots.clear();
+	_shadow.clear();
+	Reflect();
+}
+
+bool Shader::BindBlock(const std::string& name, GLuint binding)
+{
+	GLuint index = glGetUniformBlockIndex(_rendererID, name.c_str());
+
+	if (index == GL_INVALID_INDEX)
+		return false;
+
+	glUniformBlockBinding(_rendererID, index, binding);
+
+	return true;
+}
+
+void Shader::Reflect()
+{
+	GLint count = 0, length = 0;
+	glGetProgramiv(_rendererID, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(_rendererID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &length);
+
+	std::vector<GLchar> buffer(std::max(length, 1));
+
+	for (GLint i = 0; i < count; ++i)
+	{
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(_rendererID, i, (GLsizei)buffer.size(), nullptr, &size, &type, buffer.data());
+
+		std::string name(buffer.data());
+		GLint location = glGetUniformLocation(_rendererID, name.c_str());
+
+		// members of uniform blocks have no location
+		if (location < 0)
+			continue;
+
+		// arrays are reported by their first element
+		name = name.substr(0, name.find('['));
+
+		// scalars and samplers take single word
+		GLuint words = 1;
+
+		switch (type)
+		{
+		case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_BOOL_VEC2: words = 2; break;
+		case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_BOOL_VEC3: words = 3; break;
+		case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2: words = 4; break;
+		case GL_FLOAT_MAT3: words = 9; break;
+		case GL_FLOAT_MAT4: words = 16; break;
+		default: break;
+		}
+
+		Uniform uniform = GetUniform(name);
+
+		if (uniform.Index >= _slots.size())
+			_slots.resize(uniform.Index + 1);
+
+		Slot& slot = _slots[uniform.Index];
+		slot.Location = location;
+		slot.Offset = (GLuint)_shadow.size();
+		slot.Size = words * size;
+
+		_shadow.resize(_shadow.size() + slot.Size);
+	}
+}
+
+std::unordered_map<std::string, GLuint>& Shader::GetNames()
+{
+	// created on first use, handles may be requested during static initialization
+	static std::unordered_map<std::string, GLuint> names;
+
+	return names;
+}
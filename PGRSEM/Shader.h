@@ -13,6 +13,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+#include <cstring>
 #include <unordered_map>
 
 #include "pgr.h"
@@ -24,10 +27,34 @@
 */
 class Shader
 {
+public:
+	/// Struct that identifies uniform.
+	/**
+		This struct contains index of the uniform name shared by all shaders.
+		Handles are created once by name and then used without any lookup.
+	*/
+	struct Uniform
+	{
+		GLuint Index; ///< Index of the name
+	};
+
 private:
+	/// Struct that contains uniform of the program.
+	/**
+		This struct contains location of the uniform and its last uploaded value.
+	*/
+	struct Slot
+	{
+		GLint Location = -1; ///< Location in the program, -1 if the program doesn't use it
+		GLuint Offset = 0; ///< Offset of the shadow value
+		GLuint Size = 0; ///< Number of 32-bit words of the shadow value
+		bool Valid = false; ///< Shadow value holds the uploaded value
+	};
+
 	GLuint _rendererID; ///< OpenGL ID handle
 
-	std::unordered_map<std::string, GLint> _uniformCache; ///< Uniform location cache
+	std::vector<Slot> _slots; ///< Uniforms of the program by handle index
+	std::vector<GLuint> _shadow; ///< Last uploaded values
 
 public:
 	/// Constructor
@@ -64,78 +91,169 @@ public:
 		Unbinds the shader from the OpenGL context.
 	*/
 	void Unbind() const;
+	/// OpenGL ID getter.
+	/**
+		Returns the OpenGL ID handle of the shader.
+	*/
+	inline GLuint GetID() const { return _rendererID; }
+	/// Uniform handle getter.
+	/**
+		Returns handle of the uniform name, the same name always gets the same handle.
+		Meant to be called once per name, the handle is then used with every shader.
+
+		\param[in] name		Name of the uniform.
+	*/
+	static Uniform GetUniform(const std::string& name);
 	/// Uniform attribute value setter.
 	/**
-		Sets the uniform attribute to given value.
+		Sets the uniform attribute to given value, unless it holds the value already.
 
-		\param[in] name		Name of the attribute.
+		\param[in] uniform	Handle of the attribute.
 		\param[in] v0		The first value.
 	*/
-	void SetUniform1i(const std::string& name, GLint v0);
+	void SetUniform1i(Uniform uniform, GLint v0);
 	/// Uniform attribute value setter.
 	/**
-		Sets the uniform attribute to given value.
+		Sets the uniform attribute to given value, unless it holds the value already.
 
-		\param[in] name		Name of the attribute.
+		\param[in] uniform	Handle of the attribute.
 		\param[in] v0		The first value.
 	*/
-	void SetUniform1f(const std::string& name, GLfloat v0);
+	void SetUniform1f(Uniform uniform, GLfloat v0);
 	/// Uniform attribute value setter.
 	/**
-		Sets the uniform attribute to given value.
+		Sets the uniform attribute to given value, unless it holds the value already.
 
-		\param[in] name		Name of the attribute.
+		\param[in] uniform	Handle of the attribute.
 		\param[in] v0		The first value.
 		\param[in] v1		The second value.
 		\param[in] v2		The third value.
 	*/
-	void SetUniform3f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2);
+	void SetUniform3f(Uniform uniform, GLfloat v0, GLfloat v1, GLfloat v2);
 	/// Uniform attribute value setter.
 	/**
-		Sets the uniform attribute to given value.
+		Sets the uniform attribute to given value, unless it holds the value already.
 
-		\param[in] name		Name of the attribute.
+		\param[in] uniform	Handle of the attribute.
 		\param[in] count	Number of items in the collection.
 		\param[in] value	Collection with data.
 	*/
-	void SetUniform3fv(const std::string& name, GLsizei count, const GLfloat* value);
+	void SetUniform3fv(Uniform uniform, GLsizei count, const GLfloat* value);
 	/// Uniform attribute value setter.
 	/**
-		Sets the uniform attribute to given value.
+		Sets the uniform attribute to given value, unless it holds the value already.
 
-		\param[in] name		Name of the attribute.
+		\param[in] uniform	Handle of the attribute.
 		\param[in] v0		The first value.
 		\param[in] v1		The second value.
 		\param[in] v2		The third value.
 		\param[in] v4		The forth value.
 	*/
-	void SetUniform4f(const std::string& name, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
+	void SetUniform4f(Uniform uniform, GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
 	/// Uniform attribute value setter.
 	/**
-		Sets the uniform attribute to given value.
+		Sets the uniform attribute to given value, unless it holds the value already.
 
-		\param[in] name		Name of the attribute.
+		\param[in] uniform	Handle of the attribute.
 		\param[in] count	Number of items in the collection.
 		\param[in] value	Collection with data.
 	*/
-	void SetUniform4fv(const std::string& name, GLsizei count, const GLfloat* value);
+	void SetUniform4fv(Uniform uniform, GLsizei count, const GLfloat* value);
 	/// Uniform attribute value setter.
 	/**
-		Sets the uniform attribute to given value.
+		Sets the uniform attribute to given value, unless it holds the value already.
 
-		\param[in] name			Name of the attribute.
+		\param[in] uniform		Handle of the attribute.
 		\param[in] count		Number of items in the collection.
 		\param[in] transpose	Transpose matrix data.
 		\param[in] value		Collection with data.
 	*/
-	void SetUniformMatrix4fv(const std::string& name, GLsizei count, GLboolean transpose, const GLfloat* value);
-private:
-	/// Inner uniform location getter.
+	void SetUniformMatrix4fv(Uniform uniform, GLsizei count, GLboolean transpose, const GLfloat* value);
+	/// Attribute location getter.
 	/**
-		Returns the location to the uniform attribute.
+		Returns the location of the vertex attribute, -1 if the shader doesn't use it.
 
 		\param[in] name		Name of the attribute.
 	*/
-	GLint GetUniformLocation(const std::string& name);
+	GLint GetAttribLocation(const std::string& name) const;
+	/// Match attributes.
+	/**
+		Binds attributes of the program to the locations the other program uses for them
+		and links the program again, so both can read the same vertex arrays.
+		Link resets uniform block bindings, they have to be bound afterwards.
+
+		\param[in] other	Program whose locations are taken.
+	*/
+	void MatchAttributes(const Shader& other);
+	/// Bind attributes.
+	/**
+		Binds vertex attributes to consecutive locations from zero in the given order
+		and links the program again. Matrix takes one location per column, so it has
+		to be the last one. Link resets uniform block bindings, they have to be bound afterwards.
+
+		\param[in] names	Names of the attributes.
+	*/
+	void BindAttributes(const std::vector<std::string>& names);
+	/// Bind outputs.
+	/**
+		Binds outputs of the fragment shader to draw buffers in the given order
+		and links the program again. Bindings are kept by later links.
+		Link resets uniform block bindings, they have to be bound afterwards.
+
+		\param[in] names	Names of the outputs.
+	*/
+	void BindOutputs(const std::vector<std::string>& names);
+	/// Uniform block binding setter.
+	/**
+		Assigns the uniform block to the binding point, returns false if the shader
+		doesn't use the block.
+
+		\param[in] name		Name of the block.
+		\param[in] binding	Binding point.
+	*/
+	bool BindBlock(const std::string& name, GLuint binding);
+private:
+	/// Reflect uniforms.
+	/**
+		Finds locations of all active uniforms of the linked program
+		and reserves their shadow values.
+	*/
+	void Reflect();
+	/// Change validator.
+	/**
+		Returns location of the uniform if the value differs from the uploaded one
+		and stores it, otherwise returns -1 and the upload can be skipped.
+
+		\param[in] uniform	Handle of the attribute.
+		\param[in] value	New value.
+		\param[in] size		Number of 32-bit words of the value.
+	*/
+	inline GLint Changed(Uniform uniform, const GLvoid* value, GLuint size)
+	{
+		if (uniform.Index >= _slots.size())
+			return -1;
+
+		Slot& slot = _slots[uniform.Index];
+
+		// partial uploads leave the rest unknown
+		if (size != slot.Size)
+		{
+			slot.Valid = false;
+			return slot.Location;
+		}
+
+		if (slot.Valid && std::memcmp(&_shadow[slot.Offset], value, size * sizeof(GLuint)) == 0)
+			return -1;
+
+		std::memcpy(&_shadow[slot.Offset], value, size * sizeof(GLuint));
+		slot.Valid = true;
+
+		return slot.Location;
+	}
+	/// Uniform names getter.
+	/**
+		Returns table of handles by uniform name shared by all shaders.
+	*/
+	static std::unordered_map<std::string, GLuint>& GetNames();
 };
 
@@ -0,0 +1,348 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       StateTracker.cpp
+ * \author     Dominik Pupala
+ * \date       2021/31/05
+ * \brief      Source file for OpenGL state tracker.
+ *
+ *  Source file containing declarations for StateTracker class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "StateTracker.h"
+
+#include <iostream>
+
+GLuint StateTracker::_program = StateTracker::UNKNOWN;
+GLuint StateTracker::_vertexArray = StateTracker::UNKNOWN;
+GLuint StateTracker::_framebuffer = StateTracker::UNKNOWN;
+GLuint StateTracker::_buffers[StateTracker::BUFFER_TARGETS];
+GLuint StateTracker::_activeUnit = StateTracker::UNKNOWN;
+GLuint StateTracker::_textures[StateTracker::TEXTURE_UNITS][StateTracker::TEXTURE_TARGETS];
+GLuint StateTracker::_capabilities[StateTracker::CAPABILITIES];
+
+GLuint StateTracker::_blend[2];
+GLuint StateTracker::_colorMask = StateTracker::UNKNOWN;
+GLuint StateTracker::_depthMask = StateTracker::UNKNOWN;
+GLuint StateTracker::_depthFunc = StateTracker::UNKNOWN;
+GLuint StateTracker::_cullFace = StateTracker::UNKNOWN;
+GLuint StateTracker::_stencilFunc[3];
+GLuint StateTracker::_stencilOp[3];
+
+size_t StateTracker::_issued = 0;
+size_t StateTracker::_filtered = 0;
+size_t StateTracker::_frames = 0;
+
+namespace
+{
+	/// Invalidate array.
+	/**
+		Marks all values of the array unknown.
+
+		\param[in,out] values	Tracked values.
+		\param[in] count		Number of values.
+		\param[in] unknown		Unknown value.
+	*/
+	void forget(GLuint* values, size_t count, GLuint unknown)
+	{
+		for (size_t i = 0; i < count; ++i)
+			values[i] = unknown;
+	}
+
+	/// Invalidate name.
+	/**
+		Marks values holding deleted name unknown, OpenGL unbinds the name on deletion.
+
+		\param[in,out] values	Tracked values.
+		\param[in] count		Number of values.
+		\param[in] name			Deleted name.
+		\param[in] unknown		Unknown value.
+	*/
+	void forget(GLuint* values, size_t count, GLuint name, GLuint unknown)
+	{
+		for (size_t i = 0; i < count; ++i)
+			if (values[i] == name)
+				values[i] = unknown;
+	}
+}
+
+void StateTracker::Invalidate()
+{
+	_program = UNKNOWN;
+	_vertexArray = UNKNOWN;
+	_framebuffer = UNKNOWN;
+	_activeUnit = UNKNOWN;
+	_colorMask = UNKNOWN;
+	_depthMask = UNKNOWN;
+	_depthFunc = UNKNOWN;
+	_cullFace = UNKNOWN;
+
+	forget(_buffers, BUFFER_TARGETS, UNKNOWN);
+	forget(&_textures[0][0], TEXTURE_UNITS * TEXTURE_TARGETS, UNKNOWN);
+	forget(_capabilities, CAPABILITIES, UNKNOWN);
+	forget(_blend, 2, UNKNOWN);
+	forget(_stencilFunc, 3, UNKNOWN);
+	forget(_stencilOp, 3, UNKNOWN);
+}
+
+void StateTracker::UseProgram(GLuint program)
+{
+	if (Change(_program, program))
+		glUseProgram(program);
+}
+
+void StateTracker::BindVertexArray(GLuint vertexArray)
+{
+	if (!Change(_vertexArray, vertexArray))
+		return;
+
+	glBindVertexArray(vertexArray);
+
+	// element array binding is part of the vertex array
+	_buffers[BufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+}
+
+void StateTracker::BindFramebuffer(GLuint framebuffer)
+{
+	if (Change(_framebuffer, framebuffer))
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void StateTracker::BindBuffer(GLenum target, GLuint buffer)
+{
+	size_t index = BufferIndex(target);
+
+	if (index == BUFFER_TARGETS)
+	{
+		++_issued;
+		glBindBuffer(target, buffer);
+	}
+	else if (Change(_buffers[index], buffer))
+		glBindBuffer(target, buffer);
+}
+
+void StateTracker::ActiveTexture(GLenum unit)
+{
+	if (Change(_activeUnit, unit))
+		glActiveTexture(unit);
+}
+
+void StateTracker::BindTexture(GLenum target, GLuint texture)
+{
+	size_t index = TextureIndex(target);
+	GLuint unit = _activeUnit - GL_TEXTURE0;
+
+	if (index == TEXTURE_TARGETS || _activeUnit == UNKNOWN || unit >= TEXTURE_UNITS)
+	{
+		++_issued;
+		glBindTexture(target, texture);
+	}
+	else if (Change(_textures[unit][index], texture))
+		glBindTexture(target, texture);
+}
+
+void StateTracker::Enable(GLenum capability)
+{
+	size_t index = CapabilityIndex(capability);
+
+	if (index == CAPABILITIES)
+	{
+		++_issued;
+		glEnable(capability);
+	}
+	else if (Change(_capabilities[index], GL_TRUE))
+		glEnable(capability);
+}
+
+void StateTracker::Disable(GLenum capability)
+{
+	size_t index = CapabilityIndex(capability);
+
+	if (index == CAPABILITIES)
+	{
+		++_issued;
+		glDisable(capability);
+	}
+	else if (Change(_capabilities[index], GL_FALSE))
+		glDisable(capability);
+}
+
+void StateTracker::BlendFunc(GLenum source, GLenum destination)
+{
+	if (_blend[0] == source && _blend[1] == destination)
+	{
+		++_filtered;
+		return;
+	}
+
+	_blend[0] = source;
+	_blend[1] = destination;
+	++_issued;
+
+	glBlendFunc(source, destination);
+}
+
+void StateTracker::DepthMask(GLboolean write)
+{
+	if (Change(_depthMask, write))
+		glDepthMask(write);
+}
+
+void StateTracker::ColorMask(GLboolean write)
+{
+	if (Change(_colorMask, write))
+		glColorMask(write, write, write, write);
+}
+
+void StateTracker::DepthFunc(GLenum func)
+{
+	if (Change(_depthFunc, func))
+		glDepthFunc(func);
+}
+
+void StateTracker::CullFace(GLenum mode)
+{
+	if (Change(_cullFace, mode))
+		glCullFace(mode);
+}
+
+void StateTracker::StencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+	if (_stencilFunc[0] == func && _stencilFunc[1] == (GLuint)ref && _stencilFunc[2] == mask)
+	{
+		++_filtered;
+		return;
+	}
+
+	_stencilFunc[0] = func;
+	_stencilFunc[1] = (GLuint)ref;
+	_stencilFunc[2] = mask;
+	++_issued;
+
+	glStencilFunc(func, ref, mask);
+}
+
+void StateTracker::StencilOp(GLenum sfail, GLenum dpfail, GLenum dppass)
+{
+	if (_stencilOp[0] == sfail && _stencilOp[1] == dpfail && _stencilOp[2] == dppass)
+	{
+		++_filtered;
+		return;
+	}
+
+	_stencilOp[0] = sfail;
+	_stencilOp[1] = dpfail;
+	_stencilOp[2] = dppass;
+	++_issued;
+
+	glStencilOp(sfail, dpfail, dppass);
+}
+
+void StateTracker::DeleteBuffer(GLuint buffer)
+{
+	glDeleteBuffers(1, &buffer);
+	forget(_buffers, BUFFER_TARGETS, buffer, UNKNOWN);
+}
+
+void StateTracker::DeleteTexture(GLuint texture)
+{
+	glDeleteTextures(1, &texture);
+	forget(&_textures[0][0], TEXTURE_UNITS * TEXTURE_TARGETS, texture, UNKNOWN);
+}
+
+void StateTracker::DeleteVertexArray(GLuint vertexArray)
+{
+	glDeleteVertexArrays(1, &vertexArray);
+
+	if (_vertexArray == vertexArray)
+	{
+		_vertexArray = UNKNOWN;
+		_buffers[BufferIndex(GL_ELEMENT_ARRAY_BUFFER)] = UNKNOWN;
+	}
+}
+
+void StateTracker::DeleteFramebuffer(GLuint framebuffer)
+{
+	glDeleteFramebuffers(1, &framebuffer);
+
+	// deleted bound framebuffer falls back to the default one
+	if (_framebuffer == framebuffer)
+		_framebuffer = 0;
+}
+
+void StateTracker::DeleteProgram(GLuint program)
+{
+	glDeleteProgram(program);
+
+	if (_program == program)
+		_program = UNKNOWN;
+}
+
+void StateTracker::Report()
+{
+	size_t frames = _frames > 0 ? _frames : 1;
+	size_t total = _issued + _filtered;
+
+	std::cout << "State tracker: " << _issued << " calls issued, " << _filtered << " filtered";
+
+	if (total > 0)
+		std::cout << " (" << (100 * _filtered / total) << "%)";
+
+	std::cout << " over " << _frames << " frames, " << (_issued / frames) << " issued per frame" << std::endl;
+
+	_issued = 0;
+	_filtered = 0;
+	_frames = 0;
+}
+
+bool StateTracker::Change(GLuint& tracked, GLuint value)
+{
+	if (tracked == value)
+	{
+		++_filtered;
+		return false;
+	}
+
+	tracked = value;
+	++_issued;
+
+	return true;
+}
+
+size_t StateTracker::BufferIndex(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER:			return 0;
+	case GL_ELEMENT_ARRAY_BUFFER:	return 1;
+	case GL_UNIFORM_BUFFER:			return 2;
+	case GL_PIXEL_UNPACK_BUFFER:	return 3;
+	case GL_COPY_READ_BUFFER:		return 4;
+	case GL_COPY_WRITE_BUFFER:		return 5;
+	default:						return BUFFER_TARGETS;
+	}
+}
+
+size_t StateTracker::TextureIndex(GLenum target)
+{
+	switch (target)
+	{
+	case GL_TEXTURE_2D:				return 0;
+	case GL_TEXTURE_CUBE_MAP:		return 1;
+	case GL_TEXTURE_BUFFER:			return 2;
+	default:						return TEXTURE_TARGETS;
+	}
+}
+
+size_t StateTracker::CapabilityIndex(GLenum capability)
+{
+	switch (capability)
+	{
+	case GL_BLEND:					return 0;
+	case GL_DEPTH_TEST:				return 1;
+	case GL_STENCIL_TEST:			return 2;
+	case GL_CULL_FACE:				return 3;
+	default:						return CAPABILITIES;
+	}
+}
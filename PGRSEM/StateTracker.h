@@ -0,0 +1,259 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       StateTracker.h
+ * \author     Dominik Pupala
+ * \date       2021/31/05
+ * \brief      Header file for OpenGL state tracker.
+ *
+ *  Header file containing definitions for StateTracker class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "pgr.h"
+
+/// Static class that tracks OpenGL state.
+/**
+  This static class mirrors bindings and fixed function state of the context and
+  skips calls that wouldn't change anything. All wrappers change the state through it,
+  code that touches the state directly has to call Invalidate afterwards.
+  Element array buffer binding belongs to the vertex array, so it's forgotten
+  whenever the vertex array changes.
+*/
+class StateTracker
+{
+public:
+	static constexpr GLuint TEXTURE_UNITS = 16; ///< Tracked texture units
+
+private:
+	static constexpr GLuint UNKNOWN = ~0u; ///< Value not known to the tracker
+
+	static constexpr size_t BUFFER_TARGETS = 6; ///< Tracked buffer targets
+	static constexpr size_t TEXTURE_TARGETS = 3; ///< Tracked texture targets
+	static constexpr size_t CAPABILITIES = 4; ///< Tracked capabilities
+
+	static GLuint _program; ///< Used program
+	static GLuint _vertexArray; ///< Bound vertex array
+	static GLuint _framebuffer; ///< Bound draw and read framebuffer
+	static GLuint _buffers[BUFFER_TARGETS]; ///< Bound buffers by target
+	static GLuint _activeUnit; ///< Active texture unit
+	static GLuint _textures[TEXTURE_UNITS][TEXTURE_TARGETS]; ///< Bound textures by unit and target
+	static GLuint _capabilities[CAPABILITIES]; ///< Enabled capabilities
+
+	static GLuint _blend[2]; ///< Blend factors
+	static GLuint _colorMask; ///< Color writes of all channels
+	static GLuint _depthMask; ///< Depth writes
+	static GLuint _depthFunc; ///< Depth test function
+	static GLuint _cullFace; ///< Culled faces
+	static GLuint _stencilFunc[3]; ///< Stencil function, reference and mask
+	static GLuint _stencilOp[3]; ///< Stencil operations
+
+	static size_t _issued; ///< Calls passed to the driver
+	static size_t _filtered; ///< Calls skipped as redundant
+	static size_t _frames; ///< Frames since the last report
+
+public:
+	/// Invalidate state.
+	/**
+		Forgets all tracked state, the next call of each kind reaches the driver.
+		Has to be called once the context is created.
+	*/
+	static void Invalidate();
+	/// Use program.
+	/**
+		Makes the program current.
+
+		\param[in] program		Program name.
+	*/
+	static void UseProgram(GLuint program);
+	/// Bind vertex array.
+	/**
+		Binds the vertex array.
+
+		\param[in] vertexArray	Vertex array name.
+	*/
+	static void BindVertexArray(GLuint vertexArray);
+	/// Bind framebuffer.
+	/**
+		Binds the framebuffer for drawing and reading.
+
+		\param[in] framebuffer	Framebuffer name, zero for the default one.
+	*/
+	static void BindFramebuffer(GLuint framebuffer);
+	/// Bind buffer.
+	/**
+		Binds the buffer to the target.
+
+		\param[in] target		Buffer target.
+		\param[in] buffer		Buffer name.
+	*/
+	static void BindBuffer(GLenum target, GLuint buffer);
+	/// Activate texture unit.
+	/**
+		Selects texture unit used by following texture binds.
+
+		\param[in] unit			Texture unit, GL_TEXTURE0 and above.
+	*/
+	static void ActiveTexture(GLenum unit);
+	/// Bind texture.
+	/**
+		Binds the texture to the target of the active unit.
+
+		\param[in] target		Texture target.
+		\param[in] texture		Texture name.
+	*/
+	static void BindTexture(GLenum target, GLuint texture);
+	/// Enable capability.
+	/**
+		Enables the capability.
+
+		\param[in] capability	Enabled capability.
+	*/
+	static void Enable(GLenum capability);
+	/// Disable capability.
+	/**
+		Disables the capability.
+
+		\param[in] capability	Disabled capability.
+	*/
+	static void Disable(GLenum capability);
+	/// Set blend function.
+	/**
+		Sets source and destination blend factors.
+
+		\param[in] source		Source factor.
+		\param[in] destination	Destination factor.
+	*/
+	static void BlendFunc(GLenum source, GLenum destination);
+	/// Set depth writes.
+	/**
+		Enables or disables writes into depth buffer.
+
+		\param[in] write		Depth writes enabled.
+	*/
+	static void DepthMask(GLboolean write);
+	/// Set color writes.
+	/**
+		Enables or disables writes of all color channels.
+
+		\param[in] write		Color writes.
+	*/
+	static void ColorMask(GLboolean write);
+	/// Set depth function.
+	/**
+		Sets comparison of the depth test.
+
+		\param[in] func			Depth test function.
+	*/
+	static void DepthFunc(GLenum func);
+	/// Set culled faces.
+	/**
+		Sets which faces are culled while face culling is enabled.
+
+		\param[in] mode			Culled faces.
+	*/
+	static void CullFace(GLenum mode);
+	/// Set stencil function.
+	/**
+		Sets stencil test function, reference value and mask.
+
+		\param[in] func			Stencil test function.
+		\param[in] ref			Reference value.
+		\param[in] mask			Mask of compared bits.
+	*/
+	static void StencilFunc(GLenum func, GLint ref, GLuint mask);
+	/// Set stencil operations.
+	/**
+		Sets stencil operations for failed stencil, failed depth and passed tests.
+
+		\param[in] sfail		Operation when stencil test fails.
+		\param[in] dpfail		Operation when depth test fails.
+		\param[in] dppass		Operation when both tests pass.
+	*/
+	static void StencilOp(GLenum sfail, GLenum dpfail, GLenum dppass);
+	/// Delete buffer.
+	/**
+		Deletes the buffer and forgets its bindings.
+
+		\param[in] buffer		Buffer name.
+	*/
+	static void DeleteBuffer(GLuint buffer);
+	/// Delete texture.
+	/**
+		Deletes the texture and forgets its bindings.
+
+		\param[in] texture		Texture name.
+	*/
+	static void DeleteTexture(GLuint texture);
+	/// Delete vertex array.
+	/**
+		Deletes the vertex array and forgets its binding.
+
+		\param[in] vertexArray	Vertex array name.
+	*/
+	static void DeleteVertexArray(GLuint vertexArray);
+	/// Delete framebuffer.
+	/**
+		Deletes the framebuffer and forgets its binding.
+
+		\param[in] framebuffer	Framebuffer name.
+	*/
+	static void DeleteFramebuffer(GLuint framebuffer);
+	/// Delete program.
+	/**
+		Deletes the program and forgets its use.
+
+		\param[in] program		Program name.
+	*/
+	static void DeleteProgram(GLuint program);
+	/// End frame.
+	/**
+		Counts finished frame for the report.
+	*/
+	static void EndFrame() { ++_frames; }
+	/// Report statistics.
+	/**
+		Prints issued and filtered calls since the last report and resets them.
+	*/
+	static void Report();
+
+private:
+	/// Set tracked value.
+	/**
+		Stores the value and returns true if it differs from the tracked one,
+		otherwise counts the call as filtered.
+
+		\param[in,out] tracked	Tracked value.
+		\param[in] value		New value.
+	*/
+	static bool Change(GLuint& tracked, GLuint value);
+	/// Buffer target index.
+	/**
+		Returns index of tracked buffer target, BUFFER_TARGETS if not tracked.
+
+		\param[in] target		Buffer target.
+	*/
+	static size_t BufferIndex(GLenum target);
+	/// Texture target index.
+	/**
+		Returns index of tracked texture target, TEXTURE_TARGETS if not tracked.
+
+		\param[in] target		Texture target.
+	*/
+	static size_t TextureIndex(GLenum target);
+	/// Capability index.
+	/**
+		Returns index of tracked capability, CAPABILITIES if not tracked.
+
+		\param[in] capability	Capability.
+	*/
+	static size_t CapabilityIndex(GLenum capability);
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	StateTracker() { }
+};
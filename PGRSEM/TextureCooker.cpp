@@ -0,0 +1,484 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       TextureCooker.cpp
+ * \author     Dominik Pupala
+ * \date       2021/25/05
+ * \brief      Source file for compressed texture cooker.
+ *
+ *  Source file containing declarations for TextureCooker class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "TextureCooker.h"
+#include "TextureStreamer.h"
+#include "StateTracker.h"
+#include "MeshCache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+/// KTX2 file identifier
+static const uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+/// Key of the source hash entry
+static const char SOURCE_HASH_KEY[] = "PGRSEMsourceHash";
+
+bool TextureCooker::_supported = false;
+
+void TextureCooker::Initialize()
+{
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	_supported = false;
+
+	for (GLint i = 0; i < count && !_supported; ++i)
+		_supported = std::string(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))) == "GL_EXT_texture_compression_s3tc";
+}
+
+std::string TextureCooker::GetCookedPath(const std::string& path)
+{
+	size_t found = path.find_last_of('.');
+
+	return (found != std::string::npos ? path.substr(0, found) : path) + ".ktx2";
+}
+
+bool TextureCooker::Cook(const std::string& path)
+{
+	uint64_t hash = MeshCache::HashFile(path);
+
+	if (hash == 0)
+		return false;
+
+	// source is decoded and mipmapped by the usual path, then read back
+	GLuint texture = CreateSource(path);
+
+	if (texture == 0)
+		return false;
+
+	GLint width = 0, height = 0;
+	StateTracker::ActiveTexture(GL_TEXTURE0 + TextureStreamer::UPLOAD_UNIT);
+	StateTracker::BindTexture(GL_TEXTURE_2D, texture);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
+	glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
+
+	std::vector<std::vector<GLubyte>> levels;
+	bool alpha = false;
+	size_t sourceSize = 0, cookedSize = 0;
+
+	for (GLint level = 0, w = width, h = height; ; ++level, w = std::max(1, w / 2), h = std::max(1, h / 2))
+	{
+		std::vector<GLubyte> pixels((size_t)w * h * 4);
+		glGetTexImage(GL_TEXTURE_2D, level, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+		// format is picked by the base level, so all levels share it
+		if (level == 0)
+			for (size_t i = 3; i < pixels.size() && !alpha; i += 4)
+				alpha = pixels[i] != 255;
+
+		levels.push_back(Compress(pixels, w, h, alpha));
+
+		sourceSize += pixels.size();
+		cookedSize += levels.back().size();
+
+		if (w == 1 && h == 1)
+			break;
+	}
+
+	StateTracker::DeleteTexture(texture);
+
+	uint32_t format = alpha ? VK_FORMAT_BC3_UNORM_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+
+	if (!Write(GetCookedPath(path), format, width, height, levels, hash))
+	{
+		std::cout << "writing cooked texture for " << path << " has failed!" << std::endl;
+		return false;
+	}
+
+	std::cout << "Cooked " << path << ": " << levels.size() << " levels, "
+		<< sourceSize / 1024 << " KB -> " << cookedSize / 1024 << " KB" << std::endl;
+
+	return true;
+}
+
+bool TextureCooker::OpenCooked(const std::string& path, CookedTexture& outTexture)
+{
+	if (!_supported)
+		return false;
+
+	uint64_t hash = MeshCache::HashFile(path);
+
+	for (int attempt = 0; attempt < 2; ++attempt)
+	{
+		// second attempt runs on freshly cooked file
+		if (attempt == 1 && !Cook(path))
+			return false;
+
+		auto file = std::make_shared<MappedFile>(GetCookedPath(path));
+
+		if (!file->IsOpen() || file->GetSize() < sizeof(KTX2Header))
+			continue;
+
+		const KTX2Header& header = *reinterpret_cast<const KTX2Header*>(file->GetData());
+
+		if (std::memcmp(header.Identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0
+			|| (header.VkFormat != VK_FORMAT_BC1_RGB_UNORM_BLOCK && header.VkFormat != VK_FORMAT_BC3_UNORM_BLOCK)
+			|| header.FaceCount != 1 || header.SupercompressionScheme != 0 || header.LevelCount == 0
+			|| sizeof(KTX2Header) + header.LevelCount * sizeof(KTX2Level) > file->GetSize()
+			|| (uint64_t)header.KvdByteOffset + header.KvdByteLength > file->GetSize())
+			continue;
+
+		// find the source hash between key/value entries
+		uint64_t cookedHash = 0;
+
+		for (uint32_t offset = 0; offset + sizeof(uint32_t) <= header.KvdByteLength; )
+		{
+			const uint8_t* entry = file->GetData() + header.KvdByteOffset + offset;
+			uint32_t length;
+			std::memcpy(&length, entry, sizeof(length));
+
+			if (length > header.KvdByteLength - offset - sizeof(length))
+				break;
+
+			if (length == sizeof(SOURCE_HASH_KEY) + sizeof(uint64_t) && std::memcmp(entry + sizeof(length), SOURCE_HASH_KEY, sizeof(SOURCE_HASH_KEY)) == 0)
+				std::memcpy(&cookedHash, entry + sizeof(length) + sizeof(SOURCE_HASH_KEY), sizeof(uint64_t));
+
+			offset += (sizeof(length) + length + 3) & ~3u;
+		}
+
+		// missing source accepts any cooked file
+		if (hash != 0 && cookedHash != hash)
+			continue;
+
+		const KTX2Level* levels = reinterpret_cast<const KTX2Level*>(file->GetData() + sizeof(KTX2Header));
+		bool valid = true;
+
+		for (uint32_t i = 0; i < header.LevelCount; ++i)
+			valid = valid && levels[i].ByteOffset + levels[i].ByteLength <= file->GetSize();
+
+		if (!valid)
+			continue;
+
+		outTexture.Format = header.VkFormat == VK_FORMAT_BC3_UNORM_BLOCK ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		outTexture.Width = header.PixelWidth;
+		outTexture.Height = header.PixelHeight;
+		outTexture.Levels.assign(levels, levels + header.LevelCount);
+		outTexture.File = file;
+
+		return true;
+	}
+
+	return false;
+}
+
+bool TextureCooker::LoadCooked(const std::string& path, GLenum target, GLint& outLevels)
+{
+	CookedTexture texture;
+
+	if (!OpenCooked(path, texture))
+		return false;
+
+	// cooking leaves the upload unit active
+	StateTracker::ActiveTexture(GL_TEXTURE0);
+
+	for (size_t i = 0; i < texture.Levels.size(); ++i)
+		glCompressedTexImage2D(target, (GLint)i, texture.Format, texture.GetWidth(i), texture.GetHeight(i), 0, texture.GetSize(i), texture.GetData(i));
+
+	outLevels = (GLint)texture.Levels.size();
+
+	return true;
+}
+
+GLuint TextureCooker::CreateTexture(const std::string& path)
+{
+	if (!_supported)
+		return CreateSource(path);
+
+	CookedTexture cooked;
+
+	if (!OpenCooked(path, cooked))
+		return CreateSource(path);
+
+	GLuint texture;
+
+	glGenTextures(1, &texture);
+	StateTracker::ActiveTexture(GL_TEXTURE0 + TextureStreamer::UPLOAD_UNIT);
+	StateTracker::BindTexture(GL_TEXTURE_2D, texture);
+
+	// finer levels arrive later through pixel buffers
+	TextureStreamer::Stream(texture, GL_TEXTURE_2D, { GL_TEXTURE_2D }, { cooked });
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	return texture;
+}
+
+GLuint TextureCooker::CreateSource(const std::string& path)
+{
+	// textures being created keep off the units the renderer samples
+	StateTracker::ActiveTexture(GL_TEXTURE0 + TextureStreamer::UPLOAD_UNIT);
+
+	GLuint texture = pgr::createTexture(path);
+	StateTracker::Invalidate();
+
+	return texture;
+}
+
+bool TextureCooker::Write(const std::string& path, uint32_t format, uint32_t width, uint32_t height, const std::vector<std::vector<GLubyte>>& levels, uint64_t hash)
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+	if (!file)
+		return false;
+
+	bool alpha = format == VK_FORMAT_BC3_UNORM_BLOCK;
+	uint32_t blockSize = alpha ? 16 : 8;
+
+	// basic data format descriptor, BC3 has separate alpha and color samples
+	uint32_t samples = alpha ? 2 : 1;
+	std::vector<uint32_t> dfd =
+	{
+		4u + 24u + 16u * samples, // total size
+		0, // vendor and descriptor type
+		2u | ((24u + 16u * samples) << 16), // version and block size
+		(alpha ? 130u : 128u) | (1u << 8) | (1u << 16), // BC model, BT.709 primaries, linear transfer
+		3u | (3u << 8), // 4x4 texel block
+		blockSize, 0 // bytes per plane
+	};
+
+	if (alpha)
+		dfd.insert(dfd.end(), { (63u << 16) | (15u << 24), 0, 0, 0xFFFFFFFFu });
+
+	dfd.insert(dfd.end(), { (alpha ? 64u : 0u) | (63u << 16), 0, 0, 0xFFFFFFFFu });
+
+	// key/value entries sorted by key, each padded to four bytes
+	std::vector<uint8_t> kvd;
+	auto addEntry = [&kvd](const char* key, size_t keySize, const void* value, size_t valueSize)
+	{
+		uint32_t length = (uint32_t)(keySize + valueSize);
+		kvd.insert(kvd.end(), reinterpret_cast<const uint8_t*>(&length), reinterpret_cast<const uint8_t*>(&length) + sizeof(length));
+		kvd.insert(kvd.end(), key, key + keySize);
+		kvd.insert(kvd.end(), reinterpret_cast<const uint8_t*>(value), reinterpret_cast<const uint8_t*>(value) + valueSize);
+		kvd.resize((kvd.size() + 3) & ~(size_t)3, 0);
+	};
+
+	addEntry("KTXwriter", sizeof("KTXwriter"), "PGRSEM", sizeof("PGRSEM"));
+	addEntry(SOURCE_HASH_KEY, sizeof(SOURCE_HASH_KEY), &hash, sizeof(hash));
+
+	KTX2Header header = { };
+	std::memcpy(header.Identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+	header.VkFormat = format;
+	header.TypeSize = 1;
+	header.PixelWidth = width;
+	header.PixelHeight = height;
+	header.FaceCount = 1;
+	header.LevelCount = (uint32_t)levels.size();
+	header.DfdByteOffset = (uint32_t)(sizeof(KTX2Header) + levels.size() * sizeof(KTX2Level));
+	header.DfdByteLength = (uint32_t)(dfd.size() * sizeof(uint32_t));
+	header.KvdByteOffset = header.DfdByteOffset + header.DfdByteLength;
+	header.KvdByteLength = (uint32_t)kvd.size();
+
+	// levels are stored from the smallest one, each aligned to the block size
+	std::vector<KTX2Level> index(levels.size());
+	uint64_t offset = header.KvdByteOffset + header.KvdByteLength;
+
+	for (size_t i = levels.size(); i-- > 0; )
+	{
+		offset = (offset + blockSize - 1) / blockSize * blockSize;
+		index[i] = { offset, levels[i].size(), levels[i].size() };
+		offset += levels[i].size();
+	}
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(KTX2Level));
+	file.write(reinterpret_cast<const char*>(dfd.data()), dfd.size() * sizeof(uint32_t));
+	file.write(reinterpret_cast<const char*>(kvd.data()), kvd.size());
+
+	uint64_t position = header.KvdByteOffset + header.KvdByteLength;
+	static const char padding[16] = { };
+
+	for (size_t i = levels.size(); i-- > 0; )
+	{
+		file.write(padding, index[i].ByteOffset - position);
+		file.write(reinterpret_cast<const char*>(levels[i].data()), levels[i].size());
+		position = index[i].ByteOffset + index[i].ByteLength;
+	}
+
+	return file.good();
+}
+
+std::vector<GLubyte> TextureCooker::Compress(const std::vector<GLubyte>& pixels, GLint width, GLint height, bool alpha)
+{
+	GLint blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+	size_t blockSize = alpha ? 16 : 8;
+
+	std::vector<GLubyte> result(blocksX * blocksY * blockSize);
+	GLubyte* out = result.data();
+	GLubyte block[64];
+
+	for (GLint by = 0; by < blocksY; ++by)
+		for (GLint bx = 0; bx < blocksX; ++bx)
+		{
+			// levels smaller than a block repeat their edge pixels
+			for (GLint y = 0; y < 4; ++y)
+				for (GLint x = 0; x < 4; ++x)
+				{
+					GLint px = std::min(bx * 4 + x, width - 1);
+					GLint py = std::min(by * 4 + y, height - 1);
+					std::memcpy(block + (y * 4 + x) * 4, &pixels[((size_t)py * width + px) * 4], 4);
+				}
+
+			if (alpha)
+			{
+				EncodeAlpha(block, out);
+				out += 8;
+			}
+
+			EncodeColor(block, out);
+			out += 8;
+		}
+
+	return result;
+}
+
+void TextureCooker::EncodeColor(const GLubyte* block, GLubyte* out)
+{
+	int low[3] = { 255, 255, 255 }, high[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; ++i)
+		for (int c = 0; c < 3; ++c)
+		{
+			low[c] = std::min(low[c], (int)block[i * 4 + c]);
+			high[c] = std::max(high[c], (int)block[i * 4 + c]);
+		}
+
+	// bounding box diagonal follows the red/blue and green/blue covariance
+	int covRB = 0, covGB = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		int b = block[i * 4 + 2] * 2 - low[2] - high[2];
+		covRB += (block[i * 4] * 2 - low[0] - high[0]) * b;
+		covGB += (block[i * 4 + 1] * 2 - low[1] - high[1]) * b;
+	}
+
+	if (covRB < 0)
+		std::swap(low[0], high[0]);
+
+	if (covGB < 0)
+		std::swap(low[1], high[1]);
+
+	// inset by a sixteenth, extremes are rarely worth the error of the rest
+	for (int c = 0; c < 3; ++c)
+	{
+		int inset = (high[c] - low[c]) / 16;
+		high[c] -= inset;
+		low[c] += inset;
+	}
+
+	auto pack = [](const int* color) { return (GLushort)(((color[0] * 31 + 127) / 255) << 11 | ((color[1] * 63 + 127) / 255) << 5 | ((color[2] * 31 + 127) / 255)); };
+	auto unpack = [](GLushort color, int* outColor)
+	{
+		outColor[0] = ((color >> 11) & 31) * 255 / 31;
+		outColor[1] = ((color >> 5) & 63) * 255 / 63;
+		outColor[2] = (color & 31) * 255 / 31;
+	};
+
+	GLushort color0 = pack(high), color1 = pack(low);
+
+	// four color mode needs the first endpoint greater
+	if (color0 < color1)
+		std::swap(color0, color1);
+
+	GLuint indices = 0;
+
+	if (color0 != color1)
+	{
+		int palette[4][3];
+		unpack(color0, palette[0]);
+		unpack(color1, palette[1]);
+
+		for (int c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0, bestError = INT_MAX;
+
+			for (int p = 0; p < 4; ++p)
+			{
+				int error = 0;
+
+				for (int c = 0; c < 3; ++c)
+					error += (block[i * 4 + c] - palette[p][c]) * (block[i * 4 + c] - palette[p][c]);
+
+				if (error < bestError)
+				{
+					bestError = error;
+					best = p;
+				}
+			}
+
+			indices |= (GLuint)best << (i * 2);
+		}
+	}
+
+	std::memcpy(out, &color0, sizeof(color0));
+	std::memcpy(out + 2, &color1, sizeof(color1));
+	std::memcpy(out + 4, &indices, sizeof(indices));
+}
+
+void TextureCooker::EncodeAlpha(const GLubyte* block, GLubyte* out)
+{
+	int low = 255, high = 0;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		low = std::min(low, (int)block[i * 4 + 3]);
+		high = std::max(high, (int)block[i * 4 + 3]);
+	}
+
+	uint64_t indices = 0;
+
+	// eight value mode, the rest interpolates between endpoints
+	if (high != low)
+	{
+		int palette[8] = { high, low };
+
+		for (int p = 2; p < 8; ++p)
+			palette[p] = ((8 - p) * high + (p - 1) * low) / 7;
+
+		for (int i = 0; i < 16; ++i)
+		{
+			int best = 0;
+
+			for (int p = 1; p < 8; ++p)
+				if (std::abs(block[i * 4 + 3] - palette[p]) < std::abs(block[i * 4 + 3] - palette[best]))
+					best = p;
+
+			indices |= (uint64_t)best << (i * 3);
+		}
+	}
+
+	out[0] = (GLubyte)high;
+	out[1] = (GLubyte)low;
+
+	for (int i = 0; i < 6; ++i)
+		out[2 + i] = (GLubyte)(indices >> (i * 8));
+}
@@ -0,0 +1,230 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       TextureCooker.h
+ * \author     Dominik Pupala
+ * \date       2021/25/05
+ * \brief      Header file for compressed texture cooker.
+ *
+ *  Header file containing definitions for TextureCooker class and the layout of the
+ *  KTX2 files it produces.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+#include "pgr.h"
+#include "MappedFile.h"
+
+/// Struct that contains header of the .ktx2 file.
+/**
+	This struct contains fixed size header of the .ktx2 file including its index.
+	Header is followed by the level index, data format descriptor, key/value data
+	and mip levels from the smallest one.
+*/
+struct KTX2Header
+{
+	uint8_t Identifier[12]; ///< File identifier
+	uint32_t VkFormat; ///< Vulkan format of the texels
+	uint32_t TypeSize; ///< Size of the data type, one for block compressed formats
+	uint32_t PixelWidth; ///< Width of the base level
+	uint32_t PixelHeight; ///< Height of the base level
+	uint32_t PixelDepth; ///< Depth of the base level, zero for 2D textures
+	uint32_t LayerCount; ///< Number of array layers, zero for non array textures
+	uint32_t FaceCount; ///< Number of cube faces
+	uint32_t LevelCount; ///< Number of mip levels
+	uint32_t SupercompressionScheme; ///< Supercompression, zero for none
+
+	uint32_t DfdByteOffset; ///< Offset of the data format descriptor
+	uint32_t DfdByteLength; ///< Length of the data format descriptor
+	uint32_t KvdByteOffset; ///< Offset of the key/value data
+	uint32_t KvdByteLength; ///< Length of the key/value data
+	uint64_t SgdByteOffset; ///< Offset of the supercompression data
+	uint64_t SgdByteLength; ///< Length of the supercompression data
+};
+
+/// Struct that contains level index entry of the .ktx2 file.
+/**
+	This struct contains location of the single mip level.
+*/
+struct KTX2Level
+{
+	uint64_t ByteOffset; ///< Offset of the level data
+	uint64_t ByteLength; ///< Length of the level data
+	uint64_t UncompressedByteLength; ///< Length of the level data before supercompression
+};
+
+/// Struct that contains opened cooked texture.
+/**
+	This struct contains compressed levels of the cooked texture, level data stay
+	inside the mapped file.
+*/
+struct CookedTexture
+{
+	std::shared_ptr<MappedFile> File; ///< Mapped cooked file
+	std::vector<KTX2Level> Levels; ///< Levels from the base one
+
+	GLenum Format = 0; ///< Compressed OpenGL format
+	GLsizei Width = 0; ///< Width of the base level
+	GLsizei Height = 0; ///< Height of the base level
+
+	/// Level data getter.
+	/**
+		Returns compressed data of the level.
+
+		\param[in] level	Index of the level.
+	*/
+	inline const GLubyte* GetData(size_t level) const { return File->GetData() + Levels[level].ByteOffset; }
+	/// Level size getter.
+	/**
+		Returns size of compressed data of the level in bytes.
+
+		\param[in] level	Index of the level.
+	*/
+	inline GLsizei GetSize(size_t level) const { return (GLsizei)Levels[level].ByteLength; }
+	/// Level width getter.
+	/**
+		Returns width of the level.
+
+		\param[in] level	Index of the level.
+	*/
+	inline GLsizei GetWidth(size_t level) const { return std::max(1, Width >> level); }
+	/// Level height getter.
+	/**
+		Returns height of the level.
+
+		\param[in] level	Index of the level.
+	*/
+	inline GLsizei GetHeight(size_t level) const { return std::max(1, Height >> level); }
+};
+
+/// Static class that cooks textures into compressed KTX2 files.
+/**
+  This static class encodes images with mip chains into BC1 or BC3 compressed .ktx2 files
+  placed next to the source images and uploads them instead of the source images.
+  Cooked file is rebuilt whenever the source image changes.
+*/
+class TextureCooker
+{
+public:
+	static constexpr uint32_t VK_FORMAT_BC1_RGB_UNORM_BLOCK = 131; ///< Opaque textures, 8 bytes per block
+	static constexpr uint32_t VK_FORMAT_BC3_UNORM_BLOCK = 137; ///< Textures with alpha, 16 bytes per block
+
+private:
+	static bool _supported; ///< S3TC compressed formats are supported by the context
+
+public:
+	/// Initialize cooker.
+	/**
+		Checks OpenGL context for S3TC support. Has to be called on the thread owning
+		OpenGL context before any texture is created.
+	*/
+	static void Initialize();
+	/// Support getter.
+	/**
+		Returns true if cooked textures can be uploaded.
+	*/
+	static bool IsSupported() { return _supported; }
+	/// Cooked path getter.
+	/**
+		Returns path of the cooked file that belongs to the given source.
+
+		\param[in] path		Filepath to the source image.
+	*/
+	static std::string GetCookedPath(const std::string& path);
+	/// Cook texture.
+	/**
+		Decodes the source image, builds its mip chain, compresses all levels
+		and writes the cooked file. Has to be called on the thread owning OpenGL context.
+
+		\param[in] path		Filepath to the source image.
+	*/
+	static bool Cook(const std::string& path);
+	/// Open cooked texture.
+	/**
+		Maps the cooked file and validates it against the source image.
+		The file is cooked first, if it is missing or out of date.
+
+		\param[in] path			Filepath to the source image.
+		\param[out] outTexture	Opened cooked texture.
+	*/
+	static bool OpenCooked(const std::string& path, CookedTexture& outTexture);
+	/// Load cooked texture.
+	/**
+		Uploads all levels of the cooked file into the target of texture bound on the first unit.
+		The file is cooked first, if it is missing or out of date.
+
+		\param[in] path			Filepath to the source image.
+		\param[in] target		Target of the upload.
+		\param[out] outLevels	Number of uploaded levels.
+	*/
+	static bool LoadCooked(const std::string& path, GLenum target, GLint& outLevels);
+	/// Create texture.
+	/**
+		Creates mipmapped 2D texture from the cooked file, finer levels are streamed.
+		Falls back to the source image if the cooked file can't be used.
+
+		\param[in] path		Filepath to the source image.
+	*/
+	static GLuint CreateTexture(const std::string& path);
+
+private:
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	TextureCooker() { }
+	/// Create source texture.
+	/**
+		Decodes the source image into mipmapped 2D texture on the upload unit. The framework
+		binds behind the state tracker, so the tracker forgets its state afterwards.
+
+		\param[in] path		Filepath to the source image.
+	*/
+	static GLuint CreateSource(const std::string& path);
+	/// Write cooked file.
+	/**
+		Writes compressed levels into the .ktx2 file.
+
+		\param[in] path		Filepath to the cooked file.
+		\param[in] format	Vulkan format of the levels.
+		\param[in] width	Width of the base level.
+		\param[in] height	Height of the base level.
+		\param[in] levels	Compressed levels from the base one.
+		\param[in] hash		Hash of the source image.
+	*/
+	static bool Write(const std::string& path, uint32_t format, uint32_t width, uint32_t height, const std::vector<std::vector<GLubyte>>& levels, uint64_t hash);
+	/// Compress level.
+	/**
+		Compresses RGBA level into BC1 or BC3 blocks.
+
+		\param[in] pixels		RGBA pixels.
+		\param[in] width		Width of the level.
+		\param[in] height		Height of the level.
+		\param[in] alpha		Use BC3 to keep alpha.
+	*/
+	static std::vector<GLubyte> Compress(const std::vector<GLubyte>& pixels, GLint width, GLint height, bool alpha);
+	/// Encode color block.
+	/**
+		Encodes 4x4 RGBA block into BC1 color block.
+
+		\param[in] block	Sixteen RGBA pixels.
+		\param[out] out		Eight bytes of encoded block.
+	*/
+	static void EncodeColor(const GLubyte* block, GLubyte* out);
+	/// Encode alpha block.
+	/**
+		Encodes alpha of 4x4 RGBA block into BC3 alpha block.
+
+		\param[in] block	Sixteen RGBA pixels.
+		\param[out] out		Eight bytes of encoded block.
+	*/
+	static void EncodeAlpha(const GLubyte* block, GLubyte* out);
+};
@@ -0,0 +1,325 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       TextureStreamer.cpp
+ * \author     Dominik Pupala
+ * \date       2021/26/05
+ * \brief      Source file for streaming texture uploader.
+ *
+ *  Source file containing declarations for TextureStreamer class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "TextureStreamer.h"
+#include "StateTracker.h"
+
+#include <string>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+static_assert(TextureStreamer::UPLOAD_UNIT < StateTracker::TEXTURE_UNITS, "Upload unit isn't tracked");
+
+bool TextureStreamer::_sync = false;
+bool TextureStreamer::_stop = false;
+bool TextureStreamer::_running = false;
+
+TextureStreamer::Slot TextureStreamer::_slots[TextureStreamer::SLOT_COUNT];
+std::list<TextureStreamer::Chunk> TextureStreamer::_pending;
+std::map<GLuint, TextureStreamer::Progress> TextureStreamer::_streams;
+
+std::thread TextureStreamer::_worker;
+std::queue<size_t> TextureStreamer::_copies;
+std::mutex TextureStreamer::_mutex;
+std::condition_variable TextureStreamer::_copyReady;
+
+size_t TextureStreamer::_streamed = 0;
+std::chrono::steady_clock::time_point TextureStreamer::_start;
+
+void TextureStreamer::Initialize()
+{
+	GLint major = 0, minor = 0, count = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+
+	// fences are core since OpenGL 3.2
+	_sync = major > 3 || (major == 3 && minor >= 2);
+
+	for (GLint i = 0; i < count && !_sync; ++i)
+		_sync = std::string(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i))) == "GL_ARB_sync";
+
+	for (auto& slot : _slots)
+		glGenBuffers(1, &slot.Buffer);
+
+	_stop = false;
+	_running = true;
+	_worker = std::thread(&TextureStreamer::Run);
+}
+
+void TextureStreamer::Shutdown()
+{
+	if (!_running)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_copyReady.notify_all();
+	_worker.join();
+	_running = false;
+
+	for (auto& slot : _slots)
+	{
+		if (slot.Status == Slot::State::MAPPED || slot.Status == Slot::State::COPIED)
+		{
+			StateTracker::BindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.Buffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		}
+
+		if (slot.Fence)
+			glDeleteSync(slot.Fence);
+
+		StateTracker::DeleteBuffer(slot.Buffer);
+		slot = Slot();
+	}
+
+	StateTracker::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	_copies = std::queue<size_t>();
+	_pending.clear();
+	_streams.clear();
+}
+
+void TextureStreamer::Stream(GLuint texture, GLenum target, const std::vector<GLenum>& faces, const std::vector<CookedTexture>& images)
+{
+	GLint levels = (GLint)images[0].Levels.size();
+	GLint base = 0;
+
+	// without worker everything is resident right away
+	if (_running)
+		while (base < levels - 1 && std::max(images[0].GetWidth(base), images[0].GetHeight(base)) > RESIDENT_SIZE)
+			++base;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_pending.empty() && _streams.empty())
+	{
+		_streamed = 0;
+		_start = std::chrono::steady_clock::now();
+	}
+
+	for (size_t face = 0; face < faces.size(); ++face)
+	{
+		const CookedTexture& image = images[face];
+
+		for (GLint level = 0; level < levels; ++level)
+		{
+			bool resident = level >= base;
+
+			// streamed levels get storage only
+			glCompressedTexImage2D(faces[face], level, image.Format, image.GetWidth(level), image.GetHeight(level), 0,
+				image.GetSize(level), resident ? image.GetData(level) : nullptr);
+
+			if (!resident)
+				_pending.push_back({ texture, faces[face], level, image.GetData(level), image.GetSize(level),
+					image.GetWidth(level), image.GetHeight(level), image.Format, image.File });
+		}
+	}
+
+	glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, base);
+	glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+
+	if (base == 0)
+		return;
+
+	Progress& stream = _streams[texture];
+	stream.Target = target;
+	stream.Base = base;
+
+	for (GLint level = 0; level < base; ++level)
+		stream.Remaining[level] = faces.size();
+}
+
+void TextureStreamer::Cancel(GLuint texture)
+{
+	// textures outliving the streamer have nothing to cancel
+	if (!_running)
+		return;
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	if (_streams.erase(texture) == 0)
+		return;
+
+	_pending.remove_if([texture](const Chunk& chunk) { return chunk.Texture == texture; });
+
+	// uploads in flight finish their copy, but skip the texture
+	for (auto& slot : _slots)
+		if (slot.Upload.Texture == texture)
+			slot.Upload.Texture = 0;
+}
+
+void TextureStreamer::Update()
+{
+	if (!_running)
+		return;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	if (_pending.empty() && _streams.empty() && _streamed == 0)
+		return;
+
+	for (auto& slot : _slots)
+	{
+		// upload read the buffer, it can be mapped again
+		if (slot.Status == Slot::State::PENDING)
+		{
+			if (!_sync)
+			{
+				slot.Status = Slot::State::FREE;
+			}
+			else if (glClientWaitSync(slot.Fence, 0, 0) != GL_TIMEOUT_EXPIRED)
+			{
+				glDeleteSync(slot.Fence);
+				slot.Fence = nullptr;
+				slot.Status = Slot::State::FREE;
+			}
+		}
+
+		// copy is done, upload is issued from the buffer
+		if (slot.Status == Slot::State::COPIED)
+		{
+			StateTracker::BindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.Buffer);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			slot.Mapped = nullptr;
+
+			const Chunk& upload = slot.Upload;
+
+			if (upload.Texture != 0)
+			{
+				// uploads keep off the units the renderer samples
+				StateTracker::ActiveTexture(GL_TEXTURE0 + UPLOAD_UNIT);
+				StateTracker::BindTexture(_streams[upload.Texture].Target, upload.Texture);
+				glCompressedTexSubImage2D(upload.Target, upload.Level, 0, 0, upload.Width, upload.Height, upload.Format, upload.Size, nullptr);
+				Complete(upload);
+			}
+
+			if (_sync)
+				slot.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+			slot.Upload.File.reset();
+			slot.Status = Slot::State::PENDING;
+		}
+	}
+
+	size_t budget = FRAME_BUDGET;
+
+	for (size_t i = 0; i < SLOT_COUNT && !_pending.empty() && budget > 0; ++i)
+	{
+		Slot& slot = _slots[i];
+
+		if (slot.Status != Slot::State::FREE)
+			continue;
+
+		// smallest levels first, so all textures sharpen together
+		auto next = _pending.begin();
+
+		for (auto it = _pending.begin(); it != _pending.end(); ++it)
+			if (it->Size < next->Size)
+				next = it;
+
+		StateTracker::BindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.Buffer);
+
+		if (slot.Capacity < next->Size)
+		{
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, next->Size, nullptr, GL_STREAM_DRAW);
+			slot.Capacity = next->Size;
+		}
+
+		// without fences the driver orphans the buffer still read by previous upload
+		GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | (_sync ? GL_MAP_UNSYNCHRONIZED_BIT : 0);
+		slot.Mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, next->Size, access);
+
+		if (slot.Mapped == nullptr)
+		{
+			std::cout << "mapping of pixel buffer has failed!" << std::endl;
+			break;
+		}
+
+		slot.Upload = *next;
+		slot.Status = Slot::State::MAPPED;
+		_copies.push(i);
+
+		budget -= std::min(budget, (size_t)next->Size);
+		_streamed += next->Size;
+		_pending.erase(next);
+	}
+
+	StateTracker::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	_copyReady.notify_one();
+
+	bool idle = _pending.empty() && _streams.empty();
+
+	for (const auto& slot : _slots)
+		idle = idle && (slot.Status == Slot::State::FREE || slot.Status == Slot::State::PENDING);
+
+	if (idle)
+	{
+		std::cout << std::fixed << std::setprecision(2) << "Textures streamed: " << _streamed / 1024.0 << " KB in "
+			<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - _start).count() << " ms" << std::endl;
+
+		_streamed = 0;
+	}
+}
+
+void TextureStreamer::Run()
+{
+	while (true)
+	{
+		Slot* slot;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_copyReady.wait(lock, []() { return _stop || !_copies.empty(); });
+
+			if (_stop)
+				return;
+
+			slot = &_slots[_copies.front()];
+			_copies.pop();
+		}
+
+		std::memcpy(slot->Mapped, slot->Upload.Data, slot->Upload.Size);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		slot->Status = Slot::State::COPIED;
+	}
+}
+
+void TextureStreamer::Complete(const Chunk& upload)
+{
+	auto found = _streams.find(upload.Texture);
+
+	if (found == _streams.end())
+		return;
+
+	Progress& stream = found->second;
+	--stream.Remaining[upload.Level];
+
+	bool lowered = false;
+
+	while (stream.Base > 0 && stream.Remaining[stream.Base - 1] == 0)
+	{
+		--stream.Base;
+		lowered = true;
+	}
+
+	if (lowered)
+		glTexParameteri(stream.Target, GL_TEXTURE_BASE_LEVEL, stream.Base);
+
+	if (stream.Base == 0)
+		_streams.erase(found);
+}
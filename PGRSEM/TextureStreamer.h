@@ -0,0 +1,163 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       TextureStreamer.h
+ * \author     Dominik Pupala
+ * \date       2021/26/05
+ * \brief      Header file for streaming texture uploader.
+ *
+ *  Header file containing definitions for TextureStreamer class that streams cooked
+ *  texture levels through a pool of pixel buffer objects.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <condition_variable>
+
+#include "pgr.h"
+#include "TextureCooker.h"
+
+/// Static class that streams textures.
+/**
+  This static class uploads cooked textures level by level from the coarsest one.
+  Levels are copied into mapped pixel buffer objects on the worker thread, the thread
+  owning OpenGL context only issues the uploads from them. Base level of the texture
+  follows the finest complete level, so the texture can be drawn right away.
+*/
+class TextureStreamer
+{
+public:
+	static constexpr size_t SLOT_COUNT = 4; ///< Number of pixel buffer objects
+	static constexpr GLsizei RESIDENT_SIZE = 64; ///< Levels up to this size are uploaded right away
+	static constexpr size_t FRAME_BUDGET = 4 << 20; ///< Bytes handed to the worker per frame
+	static constexpr GLuint UPLOAD_UNIT = 15; ///< Texture unit of the uploads, no draw samples it
+
+private:
+	/// Struct that contains single level upload.
+	/**
+		This struct contains upload of single level of single face.
+	*/
+	struct Chunk
+	{
+		GLuint Texture; ///< Target texture, zero if cancelled
+		GLenum Target; ///< Upload target, cube face or 2D texture
+		GLint Level; ///< Level index
+
+		const GLubyte* Data; ///< Compressed data inside the mapped file
+		GLsizei Size; ///< Size of compressed data
+		GLsizei Width; ///< Width of the level
+		GLsizei Height; ///< Height of the level
+		GLenum Format; ///< Compressed OpenGL format
+
+		std::shared_ptr<MappedFile> File; ///< Keeps the data mapped
+	};
+
+	/// Struct that contains pixel buffer object.
+	/**
+		This struct contains pixel buffer object and the upload it holds.
+	*/
+	struct Slot
+	{
+		/// Slot states.
+		enum class State { FREE, MAPPED, COPIED, PENDING };
+
+		GLuint Buffer = 0; ///< Pixel buffer object
+		GLsizeiptr Capacity = 0; ///< Allocated size
+		GLsync Fence = nullptr; ///< Signals the upload has read the buffer
+		void* Mapped = nullptr; ///< Mapped memory
+
+		State Status = State::FREE; ///< Current state
+		Chunk Upload; ///< Current upload
+	};
+
+	/// Struct that contains streamed texture.
+	/**
+		This struct contains progress of the streamed texture.
+	*/
+	struct Progress
+	{
+		GLenum Target; ///< Bind target
+		GLint Base; ///< Finest level with all faces resident
+		std::map<GLint, size_t> Remaining; ///< Faces not uploaded yet by level
+	};
+
+	static bool _sync; ///< Fences are supported by the context
+	static bool _stop; ///< Worker termination flag
+	static bool _running; ///< Worker is running, stays valid during static destruction
+
+	static Slot _slots[SLOT_COUNT]; ///< Pixel buffer objects
+	static std::list<Chunk> _pending; ///< Uploads waiting for slot
+	static std::map<GLuint, Progress> _streams; ///< Streamed textures
+
+	static std::thread _worker; ///< Copy thread
+	static std::queue<size_t> _copies; ///< Slots waiting for copy
+	static std::mutex _mutex; ///< Slot state guard
+	static std::condition_variable _copyReady; ///< Signals slot waiting for copy
+
+	static size_t _streamed; ///< Bytes streamed since the last idle state
+	static std::chrono::steady_clock::time_point _start; ///< Start of the current streaming
+
+public:
+	/// Initialize streamer.
+	/**
+		Checks OpenGL context for fences, creates pixel buffer objects and starts the worker.
+		Has to be called on the thread owning OpenGL context.
+	*/
+	static void Initialize();
+	/// Shutdown streamer.
+	/**
+		Stops the worker and deletes pixel buffer objects.
+	*/
+	static void Shutdown();
+	/// Stream texture.
+	/**
+		Allocates all levels of the bound texture, uploads the coarse ones and queues the rest.
+
+		\param[in] texture	Target texture, bound to its target.
+		\param[in] target	Bind target of the texture.
+		\param[in] faces	Upload targets, one for 2D texture or six for cube map.
+		\param[in] images	Cooked images, one for each face.
+	*/
+	static void Stream(GLuint texture, GLenum target, const std::vector<GLenum>& faces, const std::vector<CookedTexture>& images);
+	/// Cancel texture.
+	/**
+		Drops all uploads of the texture that is about to be deleted.
+
+		\param[in] texture	Target texture.
+	*/
+	static void Cancel(GLuint texture);
+	/// Update streamer.
+	/**
+		Issues finished copies, recycles signaled buffers and hands next levels to the worker.
+		Has to be called once per frame on the thread owning OpenGL context.
+	*/
+	static void Update();
+
+private:
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	TextureStreamer() { }
+	/// Worker loop.
+	/**
+		Copies level data into mapped buffers.
+	*/
+	static void Run();
+	/// Complete upload.
+	/**
+		Lowers base level of the texture once all faces of the next level are resident.
+
+		\param[in] upload	Finished upload.
+	*/
+	static void Complete(const Chunk& upload);
+};
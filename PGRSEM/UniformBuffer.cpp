@@ -0,0 +1,47 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       UniformBuffer.cpp
+ * \author     Dominik Pupala
+ * \date       2021/30/05
+ * \brief      Source file for uniform buffer.
+ *
+ *  Source file containing declarations for UniformBuffer class that is a wrapper around
+ *  OpenGL object.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "UniformBuffer.h"
+#include "StateTracker.h"
+
+#include <algorithm>
+
+UniformBuffer::UniformBuffer(GLsizeiptr size, GLuint binding)
+	: _binding(binding), _size(size)
+{
+	glGenBuffers(1, &_rendererID);
+	StateTracker::BindBuffer(GL_UNIFORM_BUFFER, _rendererID);
+	glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, _rendererID);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+	StateTracker::DeleteBuffer(_rendererID);
+}
+
+void UniformBuffer::SetData(const GLvoid* data, GLsizeiptr size, GLintptr offset)
+{
+	Bind();
+	glBufferSubData(GL_UNIFORM_BUFFER, offset, std::min(size, _size - offset), data);
+}
+
+void UniformBuffer::Bind() const
+{
+	StateTracker::BindBuffer(GL_UNIFORM_BUFFER, _rendererID);
+}
+
+void UniformBuffer::Unbind() const
+{
+	StateTracker::BindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,70 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       UniformBuffer.h
+ * \author     Dominik Pupala
+ * \date       2021/30/05
+ * \brief      Header file for uniform buffer.
+ *
+ *  Header file containing definitions for UniformBuffer class that is a wrapper around
+ *  OpenGL object.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "pgr.h"
+
+/// Class that wraps OpenGL uniform buffer object.
+/**
+  This class contains context and functionality of wrapped
+  OpenGL uniform buffer object. The buffer stays bound to its binding point,
+  so every program with block assigned to the point reads the same data.
+*/
+class UniformBuffer
+{
+private:
+	GLuint _rendererID; ///< OpenGL ID handle
+	GLuint _binding; ///< Binding point
+	GLsizeiptr _size; ///< Size of the buffer
+
+public:
+	/// Constructor
+	/**
+		Creates the OpenGL uniform buffer object of given size
+		and binds it to the binding point.
+
+		\param[in] size		Size of the buffer in bytes.
+		\param[in] binding	Binding point.
+	*/
+	UniformBuffer(GLsizeiptr size, GLuint binding);
+	/// Destructor
+	/**
+		Deletes the OpenGL uniform buffer object.
+	*/
+	~UniformBuffer();
+	/// Set data.
+	/**
+		Replaces content of the buffer.
+
+		\param[in] data		Data laid out by std140 rules.
+		\param[in] size		Size of the data, at most size of the buffer.
+		\param[in] offset	Offset in the buffer.
+	*/
+	void SetData(const GLvoid* data, GLsizeiptr size, GLintptr offset = 0);
+	/// Bind buffer.
+	/**
+		Binds the buffer to the OpenGL context.
+	*/
+	void Bind() const;
+	/// Unbind buffer.
+	/**
+		Unbinds the buffer from the OpenGL context.
+	*/
+	void Unbind() const;
+	/// Binding point getter.
+	/**
+		Returns binding point of the buffer.
+	*/
+	inline GLuint GetBinding() const { return _binding; }
+};
@@ -12,6 +12,9 @@
 //----------------------------------------------------------------------------------------
 
 #include "VertexArray.h"
+#include "StateTracker.h"
+
+#include <algorithm>
 
 VertexArray::VertexArray() 
 	: _offset(0)
@@ -21,10 +24,15 @@ VertexArray::VertexArray()
 
 VertexArray::~VertexArray()
 {
-	glDeleteVertexArrays(1, &_rendererID);
+	StateTracker::DeleteVertexArray(_rendererID);
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
+{
+	AddBuffer(vb, layout, _offset);
+}
+
+void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, GLuint location)
 {
 	Bind();
 	vb.Bind();
@@ -34,20 +42,24 @@ void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& la
 	for (size_t i = 0, offset = 0; i < elements.size(); ++i)
 	{
 		const auto& element = elements[i];
-		glEnableVertexAttribArray(_offset + i);
-		glVertexAttribPointer(_offset + i, element.Count, element.Type, element.Normalized, layout.GetStride(), (const GLvoid*)offset);
-		offset += element.Count * VertexBufferElement::GetSizeOfType(element.Type);
+		glEnableVertexAttribArray(location + i);
+		glVertexAttribPointer(location + i, element.Count, element.Type, element.Normalized, layout.GetStride(), (const GLvoid*)offset);
+
+		if (layout.GetDivisor() != 0)
+			glVertexAttribDivisor(location + i, layout.GetDivisor());
+
+		offset += element.GetSize();
 	}
 
-	_offset += elements.size();
+	_offset = std::max(_offset, location + (GLuint)elements.size());
 }
 
 void VertexArray::Bind() const
 {
-	glBindVertexArray(_rendererID);
+	StateTracker::BindVertexArray(_rendererID);
 }
 
 void VertexArray::Unbind() const
 {
-	glBindVertexArray(0);
+	StateTracker::BindVertexArray(0);
 }
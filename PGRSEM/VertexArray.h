@@ -49,6 +49,16 @@ public:
 		\param[in] layout	Buffer layout of mesh data.
 	*/
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	/// Add buffer.
+	/**
+		Adds given buffer and its layout to the vertex array context starting at given
+		attribute location. Per instance layouts need instanced arrays support.
+
+		\param[in] vb			Buffer with mesh or instance data.
+		\param[in] layout		Buffer layout of the data.
+		\param[in] location		Location of the first attribute.
+	*/
+	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout, GLuint location);
 	/// Bind vertex array.
 	/**
 		Binds the vertex array to the OpenGL context.
@@ -59,5 +69,10 @@ public:
 		Unbinds the vertex array from the OpenGL context.
 	*/
 	void Unbind() const;
+	/// OpenGL ID getter.
+	/**
+		Returns the OpenGL ID handle of the vertex array.
+	*/
+	inline GLuint GetID() const { return _rendererID; }
 };
 
@@ -12,25 +12,32 @@
 //----------------------------------------------------------------------------------------
 
 #include "VertexBuffer.h"
+#include "StateTracker.h"
 
 VertexBuffer::VertexBuffer(const GLvoid* data, GLsizeiptr size)
 {
 	glGenBuffers(1, &_rendererID);
-	glBindBuffer(GL_ARRAY_BUFFER, _rendererID);
+	StateTracker::BindBuffer(GL_ARRAY_BUFFER, _rendererID);
 	glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
 }
 
 VertexBuffer::~VertexBuffer()
 {
-	glDeleteBuffers(1, &_rendererID);
+	StateTracker::DeleteBuffer(_rendererID);
+}
+
+void VertexBuffer::SetData(const GLvoid* data, GLsizeiptr size, GLintptr offset)
+{
+	Bind();
+	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
 }
 
 void VertexBuffer::Bind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, _rendererID);
+	StateTracker::BindBuffer(GL_ARRAY_BUFFER, _rendererID);
 }
 
 void VertexBuffer::Unbind() const
 {
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	StateTracker::BindBuffer(GL_ARRAY_BUFFER, 0);
 }
@@ -40,6 +40,15 @@ public:
 		Deletes the OpenGL vertex buffer object.
 	*/
 	~VertexBuffer();
+	/// Set data.
+	/**
+		Replaces part of the buffer content.
+
+		\param[in] data		Collection of vertices.
+		\param[in] size		Size of the collection.
+		\param[in] offset	Offset in the buffer in bytes.
+	*/
+	void SetData(const GLvoid* data, GLsizeiptr size, GLintptr offset);
 	/// Bind buffer.
 	/**
 		Binds the buffer to the OpenGL context.
@@ -50,5 +59,10 @@ public:
 		Unbinds the buffer from the OpenGL context.
 	*/
 	void Unbind() const;
+	/// OpenGL name getter.
+	/**
+		Returns OpenGL name of the buffer.
+	*/
+	inline GLuint GetID() const { return _rendererID; }
 };
 
@@ -23,9 +23,9 @@
 */
 struct VertexBufferElement
 {
-	GLuint Count; ///< Number of vertices
-	GLenum Type; ///< Datatype of vertices
-	GLboolean Normalized; ///< Normalized vertices
+	GLuint Count; ///< Number of components
+	GLenum Type; ///< Datatype of components
+	GLboolean Normalized; ///< Normalized components
 
 	/// Datatype getter.
 	/**
@@ -38,12 +38,33 @@ struct VertexBufferElement
 		switch (type)
 		{
 		case GL_FLOAT: return sizeof(GLfloat);
+		case GL_HALF_FLOAT: return sizeof(GLhalf);
 		case GL_UNSIGNED_INT: return sizeof(GLuint);
+		case GL_UNSIGNED_SHORT: return sizeof(GLushort);
+		case GL_SHORT: return sizeof(GLshort);
 		case GL_UNSIGNED_BYTE: return sizeof(GLubyte);
 		}
 
 		return 0;
 	}
+	/// Packed datatype validator.
+	/**
+		Returns true if all components of given datatype are packed into single value.
+
+		\param[in] type		Datatype to check.
+	*/
+	static bool IsPackedType(GLuint type)
+	{
+		return type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV;
+	}
+	/// Size getter.
+	/**
+		Returns size of the attribute in bytes.
+	*/
+	GLuint GetSize() const
+	{
+		return IsPackedType(Type) ? sizeof(GLuint) : Count * GetSizeOfType(Type);
+	}
 };
 
 /// Class that handles layout context for Vertex buffer object.
@@ -55,20 +76,36 @@ class VertexBufferLayout
 {
 private:
 	GLsizei _stride; ///< Stride offset
+	GLuint _divisor; ///< Instances sharing single element, zero for per vertex data
 	std::vector<VertexBufferElement> _elements; ///< Attribute collection
 
 public:
 	/// Constructor
 	/**
 		Creates empty context for layouts.
+
+		\param[in] divisor	Instances sharing single element, zero for per vertex data.
 	*/
-	VertexBufferLayout()
-		: _stride(0) { }
+	VertexBufferLayout(GLuint divisor = 0)
+		: _stride(0), _divisor(divisor) { }
+	/// Push attribute.
+	/**
+		Pushes attribute of given count, datatype and normalization to the layout.
+
+		\param[in] count		Number of components.
+		\param[in] type			Datatype of components.
+		\param[in] normalized	Normalize integer components to [0, 1] or [-1, 1].
+	*/
+	void Push(GLuint count, GLenum type, GLboolean normalized)
+	{
+		_elements.push_back({ count, type, normalized });
+		_stride += _elements.back().GetSize();
+	}
 	/// Push attribute.
 	/**
 		Pushes attribute of given count to the layout.
 
-		\param[in] count	Number of vertices.
+		\param[in] count	Number of components.
 	*/
 	template<typename T>
 	void Push(GLuint count)
@@ -78,26 +115,33 @@ public:
 	template<>
 	void Push<GLfloat>(GLuint count)
 	{
-		_elements.push_back({ count, GL_FLOAT, GL_FALSE });
-		_stride += count * VertexBufferElement::GetSizeOfType(GL_FLOAT);
+		Push(count, GL_FLOAT, GL_FALSE);
 	}
 	template<>
 	void Push<GLuint>(GLuint count)
 	{
-		_elements.push_back({ count, GL_UNSIGNED_INT, GL_FALSE });
-		_stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT);
+		Push(count, GL_UNSIGNED_INT, GL_FALSE);
+	}
+	template<>
+	void Push<GLushort>(GLuint count)
+	{
+		Push(count, GL_UNSIGNED_SHORT, GL_TRUE);
 	}
 	template<>
 	void Push<GLubyte>(GLuint count)
 	{
-		_elements.push_back({ count, GL_UNSIGNED_BYTE, GL_TRUE });
-		_stride += count * VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE);
+		Push(count, GL_UNSIGNED_BYTE, GL_TRUE);
 	}
 	/// Stride getter.
 	/**
 		Returns stride offset of the layout.
 	*/
 	inline GLuint GetStride() const { return _stride; }
+	/// Divisor getter.
+	/**
+		Returns number of instances sharing single element, zero for per vertex data.
+	*/
+	inline GLuint GetDivisor() const { return _divisor; }
 	/// Elements getter.
 	/**
 		Returns elements of atrribute layout.
@@ -0,0 +1,249 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       VertexQuantizer.cpp
+ * \author     Dominik Pupala
+ * \date       2021/22/05
+ * \brief      Source file for vertex quantizer.
+ *
+ *  Source file containing declarations for VertexQuantizer class.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#include "VertexQuantizer.h"
+
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+
+GLuint VertexQuantizer::_mode = VertexQuantizer::MODE_ENABLED;
+
+void VertexQuantizer::Initialize(bool enabled)
+{
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+	_mode = enabled ? MODE_ENABLED : 0;
+
+	// packed vertex formats are core since OpenGL 3.3
+	if (enabled && (major > 3 || (major == 3 && minor >= 3)))
+		_mode |= MODE_PACKED_NORMALS;
+}
+
+PackedMesh VertexQuantizer::Pack(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, const std::vector<GLuint>& sequence)
+{
+	PackedMesh mesh;
+
+	size_t stride = 0;
+	for (GLuint size : sequence)
+		stride += size;
+
+	size_t count = stride ? vertices.size() / stride : 0;
+	size_t packedStride = 0;
+
+	for (size_t i = 0, offset = 0; i < sequence.size(); offset += sequence[i++])
+	{
+		mesh.Layout.push_back(PickType(vertices, stride, offset, sequence[i], i));
+		packedStride += mesh.Layout.back().GetSize();
+	}
+
+	mesh.Vertices.resize(count * packedStride);
+	GLubyte* out = mesh.Vertices.data();
+
+	for (size_t v = 0; v < count; ++v)
+	{
+		const GLfloat* in = &vertices[v * stride];
+
+		for (size_t i = 0, offset = 0; i < sequence.size(); offset += sequence[i++])
+		{
+			const VertexBufferElement& element = mesh.Layout[i];
+
+			switch (element.Type)
+			{
+			case GL_HALF_FLOAT:
+				for (GLuint c = 0; c < element.Count; ++c)
+				{
+					// padding component keeps attributes 4 byte aligned
+					GLhalf value = c < sequence[i] ? ToHalf(in[offset + c]) : (c == 3 ? 0x3C00 : 0);
+					std::memcpy(out + c * sizeof(GLhalf), &value, sizeof(GLhalf));
+				}
+				break;
+			case GL_UNSIGNED_SHORT:
+				for (GLuint c = 0; c < element.Count; ++c)
+				{
+					GLushort value = (GLushort)std::lround(std::min(std::max(in[offset + c], 0.0f), 1.0f) * 65535.0f);
+					std::memcpy(out + c * sizeof(GLushort), &value, sizeof(GLushort));
+				}
+				break;
+			case GL_INT_2_10_10_10_REV:
+			{
+				GLuint value = ToPackedNormal(in + offset);
+				std::memcpy(out, &value, sizeof(GLuint));
+				break;
+			}
+			default:
+				std::memcpy(out, in + offset, element.Count * sizeof(GLfloat));
+				break;
+			}
+
+			out += element.GetSize();
+		}
+	}
+
+	mesh.IndexCount = (GLuint)indices.size();
+
+	// parts drawn with base vertex only need their own vertices addressable
+	GLuint largest = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end());
+
+	if ((_mode & MODE_ENABLED) && largest < 65536)
+	{
+		mesh.IndexType = GL_UNSIGNED_SHORT;
+		mesh.Indices.resize(indices.size() * sizeof(GLushort));
+
+		GLushort* packed = reinterpret_cast<GLushort*>(mesh.Indices.data());
+		for (size_t i = 0; i < indices.size(); ++i)
+			packed[i] = (GLushort)indices[i];
+	}
+	else
+	{
+		mesh.IndexType = GL_UNSIGNED_INT;
+		mesh.Indices.resize(indices.size() * sizeof(GLuint));
+		std::memcpy(mesh.Indices.data(), indices.data(), mesh.Indices.size());
+	}
+
+	return mesh;
+}
+
+std::vector<glm::vec3> VertexQuantizer::UnpackPositions(const GLvoid* vertices, GLsizeiptr vertexSize, const VertexBufferLayout& layout)
+{
+	std::vector<glm::vec3> positions;
+
+	if (layout.GetElements().empty() || layout.GetStride() == 0)
+		return positions;
+
+	const VertexBufferElement& element = layout.GetElements()[0];
+	const GLubyte* in = static_cast<const GLubyte*>(vertices);
+	size_t count = (size_t)vertexSize / layout.GetStride();
+
+	positions.resize(count);
+
+	for (size_t v = 0; v < count; ++v, in += layout.GetStride())
+	{
+		for (GLuint c = 0; c < 3 && c < element.Count; ++c)
+		{
+			if (element.Type == GL_HALF_FLOAT)
+			{
+				GLhalf value;
+				std::memcpy(&value, in + c * sizeof(GLhalf), sizeof(GLhalf));
+				positions[v][c] = FromHalf(value);
+			}
+			else
+				std::memcpy(&positions[v][c], in + c * sizeof(GLfloat), sizeof(GLfloat));
+		}
+	}
+
+	return positions;
+}
+
+VertexBufferElement VertexQuantizer::PickType(const std::vector<GLfloat>& vertices, size_t stride, size_t offset, GLuint count, size_t role)
+{
+	if (!(_mode & MODE_ENABLED) || count > 4)
+		return { count, GL_FLOAT, GL_FALSE };
+
+	if (role == 1 && count == 3 && (_mode & MODE_PACKED_NORMALS))
+		return { 4, GL_INT_2_10_10_10_REV, GL_TRUE };
+
+	float low = std::numeric_limits<float>::max();
+	float high = std::numeric_limits<float>::lowest();
+	float error = 0.0f;
+
+	for (size_t i = offset; i < vertices.size(); i += stride)
+	{
+		for (size_t c = 0; c < count; ++c)
+		{
+			float value = vertices[i + c];
+			low = std::min(low, value);
+			high = std::max(high, value);
+			error = std::max(error, std::fabs(FromHalf(ToHalf(value)) - value));
+		}
+	}
+
+	// texture coordinates inside the texture fit normalized shorts
+	if (role == 2 && low >= 0.0f && high <= 1.0f)
+		return { count, GL_UNSIGNED_SHORT, GL_TRUE };
+
+	// positions may lose a thousandth of the extent, coordinates a half of 2K texel
+	float tolerance = role == 0 ? std::max(high - low, 1e-6f) / 1024.0f : 1.0f / 2048.0f;
+
+	if (error <= tolerance)
+		return { count + count % 2, GL_HALF_FLOAT, GL_FALSE };
+
+	return { count, GL_FLOAT, GL_FALSE };
+}
+
+GLhalf VertexQuantizer::ToHalf(float value)
+{
+	GLuint bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	GLuint sign = (bits >> 16) & 0x8000;
+	GLint exponent = (GLint)((bits >> 23) & 0xFF) - 127 + 15;
+	GLuint mantissa = bits & 0x7FFFFF;
+
+	if (exponent <= 0)
+	{
+		// subnormal half or zero
+		if (exponent < -10)
+			return (GLhalf)sign;
+
+		mantissa |= 0x800000;
+		GLuint shift = 14 - exponent;
+		GLuint half = mantissa >> shift;
+
+		if ((mantissa >> (shift - 1)) & 1)
+			++half;
+
+		return (GLhalf)(sign | half);
+	}
+
+	if (exponent >= 31)
+		return (GLhalf)(sign | 0x7C00);
+
+	GLuint half = sign | (exponent << 10) | (mantissa >> 13);
+
+	// carry from rounding correctly bumps the exponent
+	if (mantissa & 0x1000)
+		++half;
+
+	return (GLhalf)half;
+}
+
+float VertexQuantizer::FromHalf(GLhalf value)
+{
+	float sign = (value & 0x8000) ? -1.0f : 1.0f;
+	int exponent = (value >> 10) & 0x1F;
+	int mantissa = value & 0x3FF;
+
+	if (exponent == 0)
+		return sign * std::ldexp((float)mantissa, -24);
+
+	if (exponent == 31)
+		return sign * std::numeric_limits<float>::infinity();
+
+	return sign * std::ldexp((float)(mantissa | 0x400), exponent - 25);
+}
+
+GLuint VertexQuantizer::ToPackedNormal(const GLfloat* value)
+{
+	GLuint packed = 0;
+
+	for (int c = 0; c < 3; ++c)
+	{
+		GLint component = (GLint)std::lround(std::min(std::max(value[c], -1.0f), 1.0f) * 511.0f);
+		packed |= ((GLuint)component & 0x3FF) << (10 * c);
+	}
+
+	return packed;
+}
@@ -0,0 +1,123 @@
+//----------------------------------------------------------------------------------------
+/**
+ * \file       VertexQuantizer.h
+ * \author     Dominik Pupala
+ * \date       2021/22/05
+ * \brief      Header file for vertex quantizer.
+ *
+ *  Header file containing definitions for VertexQuantizer and PackedMesh classes.
+ *
+*/
+//----------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <vector>
+
+#include "pgr.h"
+#include "VertexBufferLayout.h"
+
+/// Struct that contains packed mesh data.
+/**
+	This struct contains mesh data in the format they are uploaded in.
+*/
+struct PackedMesh
+{
+	std::vector<GLubyte> Vertices; ///< Packed interleaved vertices
+	std::vector<GLubyte> Indices; ///< Packed indices
+	std::vector<VertexBufferElement> Layout; ///< Layout of packed vertices
+
+	GLenum IndexType = GL_UNSIGNED_INT; ///< Datatype of indices
+	GLuint IndexCount = 0; ///< Number of indices
+};
+
+/// Static class that quantizes vertex data.
+/**
+  This static class packs float vertex data into smaller datatypes.
+  Attributes are expected in the shader order - position, normal and texture coordinates.
+*/
+class VertexQuantizer
+{
+public:
+	static constexpr GLuint MODE_ENABLED = 1; ///< Quantization is enabled
+	static constexpr GLuint MODE_PACKED_NORMALS = 2; ///< GL_INT_2_10_10_10_REV is supported
+
+private:
+	static GLuint _mode; ///< Current quantization mode
+
+public:
+	/// Initialize quantizer.
+	/**
+		Checks OpenGL context for supported datatypes. Has to be called on the thread
+		owning OpenGL context before any packing.
+
+		\param[in] enabled	Quantization switch, disabled quantizer keeps floats.
+	*/
+	static void Initialize(bool enabled = true);
+	/// Mode getter.
+	/**
+		Returns current quantization mode, packed data are valid only for the same mode.
+	*/
+	static GLuint GetMode() { return _mode; }
+	/// Pack mesh.
+	/**
+		Picks the smallest datatype for each attribute that keeps the mesh precise enough
+		and packs vertices and indices. Indices may be relative to the part they belong to,
+		16-bit indices are used whenever the largest one fits.
+
+		\param[in] vertices		Interleaved float vertex data.
+		\param[in] indices		Face data.
+		\param[in] sequence		Sequence of attribute sizes.
+	*/
+	static PackedMesh Pack(const std::vector<GLfloat>& vertices, const std::vector<GLuint>& indices, const std::vector<GLuint>& sequence);
+	/// Unpack positions.
+	/**
+		Reads positions of packed vertices back into floats. Position is expected to be
+		the first attribute, packed either as floats or half floats.
+
+		\param[in] vertices		Packed interleaved vertices.
+		\param[in] vertexSize	Size of the vertices in bytes.
+		\param[in] layout		Layout of packed vertices.
+	*/
+	static std::vector<glm::vec3> UnpackPositions(const GLvoid* vertices, GLsizeiptr vertexSize, const VertexBufferLayout& layout);
+
+private:
+	/// Disabled constructor
+	/**
+		Constructor created so the default one isn't created.
+		This class is meant to be static.
+	*/
+	VertexQuantizer() { }
+	/// Pick datatype.
+	/**
+		Picks datatype of the attribute based on its role and value range.
+
+		\param[in] vertices		Interleaved float vertex data.
+		\param[in] stride		Number of floats per vertex.
+		\param[in] offset		Offset of the attribute in floats.
+		\param[in] count		Number of components of the attribute.
+		\param[in] role			Index of the attribute in the shader.
+	*/
+	static VertexBufferElement PickType(const std::vector<GLfloat>& vertices, size_t stride, size_t offset, GLuint count, size_t role);
+	/// Convert to half.
+	/**
+		Converts float to half float with rounding to nearest.
+
+		\param[in] value	Float value.
+	*/
+	static GLhalf ToHalf(float value);
+	/// Convert from half.
+	/**
+		Converts half float to float.
+
+		\param[in] value	Half float value.
+	*/
+	static float FromHalf(GLhalf value);
+	/// Pack normal.
+	/**
+		Packs normalized vector into signed 2_10_10_10 value.
+
+		\param[in] value	Vector with three components.
+	*/
+	static GLuint ToPackedNormal(const GLfloat* value);
+};
@@ -0,0 +1,107 @@
+#version 140
+
+struct Light
+{
+	vec3 Diffuse;
+	vec3 Ambient;
+	vec3 Specular;
+	vec3 Position;
+	vec3 Direction;
+	
+	float CutoffInn;
+	float CutoffOut;
+
+	float Constant;
+	float Linear;
+	float Quadratic;
+};
+
+struct Fog
+{
+	vec3 Color;
+	float Density;
+	float Gradient;
+};
+
+in vec2 texCoord_v;
+
+uniform sampler2D albedoSampler;
+uniform sampler2D specularSampler;
+uniform sampler2D normalSampler;
+uniform sampler2D depthSampler;
+uniform sampler2D ambientSampler;
+uniform mat4 inversePVMatrix;
+
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
+
+layout(std140) uniform LightData
+{
+	Light sunlight;
+};
+
+layout(std140) uniform FogData
+{
+	Fog fog;
+};
+
+out vec4 color_final;
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+vec3 decodeNormal(vec4 encoded)
+{
+	vec2 e = (encoded.xy + encoded.zw / 255.0f) * 2.0f - 1.0f;
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+
+	if (n.z < 0.0f)
+		n.xy = (1.0f - abs(n.yx)) * signNotZero(n.xy);
+
+	return normalize(n);
+}
+
+float fogExp(Fog fog, vec3 fogPosition)
+{
+	float dist = length(fogPosition);
+	float visibility = exp(-pow((dist * fog.Density), fog.Gradient));
+
+	return clamp(visibility, 0.0f, 1.0f);
+}
+
+void main()
+{
+	float depth = texture(depthSampler, texCoord_v).r;
+
+	// sky shows through pixels without surface
+	if (depth >= 1.0f)
+		discard;
+
+	vec4 world = inversePVMatrix * vec4(vec3(texCoord_v, depth) * 2.0f - 1.0f, 1.0f);
+	vec3 position = world.xyz / world.w;
+
+	vec4 albedo = texture(albedoSampler, texCoord_v);
+	vec4 specular = texture(specularSampler, texCoord_v);
+	vec3 ambient = texture(ambientSampler, texCoord_v).rgb;
+	float shininess = specular.a * 256.0f;
+
+	vec3 N = decodeNormal(texture(normalSampler, texCoord_v));
+	vec3 L = normalize(sunlight.Position - position);
+	vec3 R = reflect(-L, N);
+	vec3 V = normalize(cameraPosition - position);
+
+	// global ambient and sunlight, other lights are added by their volumes
+	vec3 color = ambient * (vec3(0.13f) + sunlight.Ambient);
+	color += albedo.rgb * sunlight.Diffuse * max(0.0f, dot(N, L));
+	color += specular.rgb * sunlight.Specular * (shininess > 0.0f ? pow(max(0.0f, dot(R, V)), shininess) : 0.0f);
+
+	gl_FragDepth = depth;
+	color_final = mix(vec4(fog.Color, 1.0f), vec4(color, 1.0f), fogExp(fog, position - cameraPosition));
+}
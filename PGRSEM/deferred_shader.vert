@@ -0,0 +1,12 @@
+#version 140
+
+out vec2 texCoord_v;
+
+void main()
+{
+	// single triangle covers the screen, corners come from the vertex index
+	vec2 position = vec2(float((gl_VertexID & 1) * 4 - 1), float((gl_VertexID >> 1) * 4 - 1));
+
+	texCoord_v = position * 0.5f + 0.5f;
+	gl_Position = vec4(position, 0.0f, 1.0f);
+}
@@ -0,0 +1,6 @@
+#version 140
+
+// only depth is written, color writes are masked
+void main()
+{
+}
\ No newline at end of file
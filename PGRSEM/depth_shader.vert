@@ -0,0 +1,28 @@
+#version 140
+
+struct Material
+{
+	vec3 Diffuse;
+	vec3 Ambient;
+	vec3 Specular;
+	float Shininess;
+};
+
+layout(std140) uniform ObjectData
+{
+	mat4 pvmMatrix;
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	Material material;
+	bool texUse;
+};
+
+in vec3 vertexPosition;
+
+// depth has to match the lighting pass bit for bit
+invariant gl_Position;
+
+void main()
+{
+	gl_Position = pvmMatrix * vec4(vertexPosition, 1.0f);
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#version 140
+
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
+
+in vec3 vertexPosition;
+in mat4 instanceModel;
+
+// depth has to match the lighting pass bit for bit
+invariant gl_Position;
+
+void main()
+{
+	vec4 worldPosition = instanceModel * vec4(vertexPosition, 1.0f);
+	gl_Position = pvMatrix * worldPosition;
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#version 140
+
+struct Material
+{
+	vec3 Diffuse;
+	vec3 Ambient;
+	vec3 Specular;
+	float Shininess;
+};
+
+in vec2 texCoord_v;
+in vec3 vertexPosition_v;
+in vec3 vertexNormal_v;
+in vec4 fogPosition_v;
+
+uniform sampler2D texSampler; 
+
+layout(std140) uniform ObjectData
+{
+	mat4 pvmMatrix;
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	Material material;
+	bool texUse;
+};
+
+out vec4 albedo_final;
+out vec4 specular_final;
+out vec4 normal_final;
+out vec4 ambient_final;
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+vec4 encodeNormal(vec3 normal)
+{
+	// octahedral mapping, lower hemisphere folds over the diagonals
+	vec3 n = normal / (abs(normal.x) + abs(normal.y) + abs(normal.z));
+	vec2 e = n.z >= 0.0f ? n.xy : (1.0f - abs(n.yx)) * signNotZero(n.xy);
+	e = e * 0.5f + 0.5f;
+
+	// high and low byte of each component
+	return vec4(floor(e * 255.0f) / 255.0f, fract(e * 255.0f));
+}
+
+void main()
+{
+	vec4 texel = texUse ? texture(texSampler, texCoord_v) : vec4(1.0f);
+
+	albedo_final = vec4(material.Diffuse * texel.rgb, 1.0f);
+	specular_final = vec4(material.Specular * texel.rgb, clamp(material.Shininess / 256.0f, 0.0f, 1.0f));
+	normal_final = encodeNormal(normalize(vertexNormal_v));
+	ambient_final = vec4(material.Ambient * texel.rgb, 1.0f);
+}
@@ -0,0 +1,101 @@
+#version 140
+
+struct Fog
+{
+	vec3 Color;
+	float Density;
+	float Gradient;
+};
+
+flat in int light_v;
+
+uniform sampler2D albedoSampler;
+uniform sampler2D specularSampler;
+uniform sampler2D normalSampler;
+uniform sampler2D depthSampler;
+uniform sampler2D ambientSampler;
+uniform samplerBuffer lightSampler;
+uniform mat4 inversePVMatrix;
+uniform bool spot;
+
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
+
+layout(std140) uniform FogData
+{
+	Fog fog;
+};
+
+out vec4 color_final;
+
+vec2 signNotZero(vec2 v)
+{
+	return vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+}
+
+vec3 decodeNormal(vec4 encoded)
+{
+	vec2 e = (encoded.xy + encoded.zw / 255.0f) * 2.0f - 1.0f;
+	vec3 n = vec3(e, 1.0f - abs(e.x) - abs(e.y));
+
+	if (n.z < 0.0f)
+		n.xy = (1.0f - abs(n.yx)) * signNotZero(n.xy);
+
+	return normalize(n);
+}
+
+float fogExp(Fog fog, vec3 fogPosition)
+{
+	float dist = length(fogPosition);
+	float visibility = exp(-pow((dist * fog.Density), fog.Gradient));
+
+	return clamp(visibility, 0.0f, 1.0f);
+}
+
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(depthSampler, pixel, 0).r;
+
+	vec2 texCoord = gl_FragCoord.xy / vec2(textureSize(depthSampler, 0));
+	vec4 world = inversePVMatrix * vec4(vec3(texCoord, depth) * 2.0f - 1.0f, 1.0f);
+	vec3 position = world.xyz / world.w;
+
+	vec4 center = texelFetch(lightSampler, light_v * 4);
+	vec4 color = texelFetch(lightSampler, light_v * 4 + 1);
+	vec4 direction = texelFetch(lightSampler, light_v * 4 + 2);
+	vec4 attenuation = texelFetch(lightSampler, light_v * 4 + 3);
+
+	vec3 toLight = center.xyz - position;
+	float dist = length(toLight);
+
+	// volume is bigger than the range, surfaces in front of it pass the depth test too
+	if (dist >= center.w)
+		discard;
+
+	vec4 albedo = texelFetch(albedoSampler, pixel, 0);
+	vec4 specular = texelFetch(specularSampler, pixel, 0);
+	float shininess = specular.a * 256.0f;
+
+	vec3 N = decodeNormal(texelFetch(normalSampler, pixel, 0));
+	vec3 L = toLight / dist;
+	vec3 R = reflect(-L, N);
+	vec3 V = normalize(cameraPosition - position);
+
+	vec3 light = texelFetch(ambientSampler, pixel, 0).rgb * color.a;
+	light += albedo.rgb * max(0.0f, dot(N, L));
+	light += specular.rgb * (shininess > 0.0f ? pow(max(0.0f, dot(R, V)), shininess) : 0.0f);
+
+	// falloff of the forward lights, windowed to reach zero at the range
+	float atten = 1.0f / (attenuation.x + attenuation.y * dist + attenuation.z * dist * dist);
+	float window = clamp(1.0f - pow(dist / center.w, 4.0f), 0.0f, 1.0f);
+	float intensity = spot ? clamp((dot(-L, direction.xyz) - attenuation.w) / max(direction.w - attenuation.w, 0.001f), 0.0f, 1.0f) : 1.0f;
+
+	// fog blend is linear, so each light adds its share of the fogged color
+	color_final = vec4(light * color.rgb * atten * window * window * intensity * fogExp(fog, position - cameraPosition), 1.0f);
+}
@@ -0,0 +1,42 @@
+#version 140
+
+in vec3 position;
+
+uniform samplerBuffer lightSampler;
+uniform int firstLight;
+uniform bool spot;
+
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
+
+flat out int light_v;
+
+void main()
+{
+	// four texels per light, position with range first
+	light_v = firstLight + gl_InstanceID;
+
+	vec4 center = texelFetch(lightSampler, light_v * 4);
+	vec3 world = center.xyz + position * center.w;
+
+	if (spot)
+	{
+		vec3 axis = texelFetch(lightSampler, light_v * 4 + 2).xyz;
+		float cutoff = texelFetch(lightSampler, light_v * 4 + 3).w;
+
+		// unit cone is stretched to the range and widened to the outer cutoff
+		vec3 up = abs(axis.y) < 0.99f ? vec3(0.0f, 1.0f, 0.0f) : vec3(1.0f, 0.0f, 0.0f);
+		vec3 side = normalize(cross(up, axis));
+		up = cross(axis, side);
+
+		float radius = center.w * sqrt(1.0f - cutoff * cutoff) / max(cutoff, 0.01f);
+		world = center.xyz + (side * position.x + up * position.y) * radius + axis * position.z * center.w;
+	}
+
+	gl_Position = pvMatrix * vec4(world, 1.0f);
+}
@@ -1,9 +1,29 @@
 #version 140
 
-uniform mat4 pvmMatrix;
-uniform mat4 normalMatrix;
-uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
+struct Material
+{
+	vec3 Diffuse;
+	vec3 Ambient;
+	vec3 Specular;
+	float Shininess;
+};
+
+layout(std140) uniform ObjectData
+{
+	mat4 pvmMatrix;
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	Material material;
+	bool texUse;
+};
+
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
 
 in vec3 vertexPosition;
 in vec3 vertexNormal;
@@ -14,6 +34,9 @@ out vec3 vertexNormal_v;
 out vec3 vertexPosition_v;
 out vec4 fogPosition_v;
 
+// depth has to match the pre-pass bit for bit
+invariant gl_Position;
+
 void main()
 {
 	vertexNormal_v = normalize((normalMatrix * vec4(vertexNormal, 0.0f)).xyz);
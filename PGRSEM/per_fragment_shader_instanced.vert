@@ -0,0 +1,34 @@
+#version 140
+
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
+
+in vec3 vertexPosition;
+in vec3 vertexNormal;
+in vec2 texCoord;
+in mat4 instanceModel;
+
+out vec2 texCoord_v;
+out vec3 vertexNormal_v;
+out vec3 vertexPosition_v;
+out vec4 fogPosition_v;
+
+// depth has to match the pre-pass bit for bit
+invariant gl_Position;
+
+void main()
+{
+	vec4 worldPosition = instanceModel * vec4(vertexPosition, 1.0f);
+	mat3 normalMatrix = transpose(inverse(mat3(instanceModel)));
+
+	vertexNormal_v = normalize(normalMatrix * vertexNormal);
+	vertexPosition_v = vec3(worldPosition);
+	fogPosition_v = viewMatrix * worldPosition;
+	texCoord_v = texCoord;
+	gl_Position = pvMatrix * worldPosition;
+}
\ No newline at end of file
@@ -28,15 +28,40 @@ in vec2 texCoord_v;
 in vec3 vertexPosition_v;
 in vec3 vertexNormal_v;
 
-uniform bool texUse = false;
 uniform sampler2D texSampler; 
+uniform samplerBuffer lightSampler;
+uniform usamplerBuffer clusterSampler;
+uniform usamplerBuffer indexSampler;
 
-uniform Light sunlight;
-uniform Light spotlight;
-uniform Light pointlight;
-uniform Material material;
+layout(std140) uniform ObjectData
+{
+	mat4 pvmMatrix;
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	Material material;
+	bool texUse;
+};
+
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
+
+layout(std140) uniform LightData
+{
+	Light sunlight;
+};
 
-uniform vec3 cameraPosition;
+layout(std140) uniform ClusterData
+{
+	vec2 tileScale;
+	float sliceScale;
+	float sliceBias;
+	ivec3 clusterCount;
+};
 
 out vec4 color_final;
 
@@ -70,41 +95,51 @@ vec4 lightDirectional(Material material, Light light, vec3 vPosition, vec3 vNorm
 	return vec4(ambient + diffuse + specular, 1.0f);
 }
 
-vec4 lightPoint(Material material, Light light, vec3 vPosition, vec3 vNormal)
+vec3 lightSource(Material material, int index, vec3 vPosition, vec3 vNormal)
 {
-	vec3 ambient = lightAmbient(material, light);
-	
+	vec4 center = texelFetch(lightSampler, index * 4);
+	vec4 color = texelFetch(lightSampler, index * 4 + 1);
+	vec4 direction = texelFetch(lightSampler, index * 4 + 2);
+	vec4 attenuation = texelFetch(lightSampler, index * 4 + 3);
+
+	vec3 toLight = center.xyz - vPosition;
+	float dist = length(toLight);
+
+	// clusters are bigger than the range, surfaces beyond it get nothing
+	if (dist >= center.w)
+		return vec3(0.0f);
+
 	vec3 N = normalize(vNormal);
-	vec3 L = normalize(light.Position - vPosition);
-	vec3 diffuse = lightDiffuse(material, light, max(0.0f, dot(N, L)));
-	
+	vec3 L = toLight / dist;
 	vec3 R = reflect(-L, N);
 	vec3 V = normalize(cameraPosition - vPosition);
-	vec3 specular = lightSpecular(material, light, max(0.0f, dot(R, V)));
 
-	float dist = length(light.Position - vPosition);
-	float atten = 1.0f / (light.Constant + light.Linear * dist + light.Quadratic * pow(dist, 2.0f));
+	vec3 light = material.Ambient * color.a;
+	light += material.Diffuse * max(0.0f, dot(N, L));
+	light += material.Specular * (material.Shininess > 0.0f ? pow(max(0.0f, dot(R, V)), material.Shininess) : 0.0f);
+
+	// falloff windowed to reach zero at the range, spot lights have direction
+	float atten = 1.0f / (attenuation.x + attenuation.y * dist + attenuation.z * dist * dist);
+	float window = clamp(1.0f - pow(dist / center.w, 4.0f), 0.0f, 1.0f);
+	float intensity = dot(direction.xyz, direction.xyz) > 0.0f ? clamp((dot(-L, direction.xyz) - attenuation.w) / max(direction.w - attenuation.w, 0.001f), 0.0f, 1.0f) : 1.0f;
 
-	return vec4(ambient * atten + diffuse * atten + specular * atten, 1.0f);
+	return light * color.rgb * atten * window * window * intensity;
 }
 
-vec4 lightSpot(Material material, Light light, vec3 vPosition, vec3 vNormal)
+vec3 lightClustered(Material material, vec3 vPosition, vec3 vNormal)
 {
-	vec3 ambient = lightAmbient(material, light);
-	
-	vec3 N = normalize(vNormal);
-	vec3 L = normalize(light.Position - vPosition);
-	vec3 diffuse = lightDiffuse(material, light, max(0.0f, dot(N, L)));
+	float depth = -(viewMatrix * vec4(vPosition, 1.0f)).z;
+	ivec3 cluster = ivec3(ivec2(gl_FragCoord.xy * tileScale), int(floor(log(max(depth, 0.0001f)) * sliceScale + sliceBias)));
+	cluster = clamp(cluster, ivec3(0), clusterCount - 1);
 
-	vec3 R = reflect(-L, N);
-	vec3 V = normalize(-vPosition);
-	vec3 specular = lightSpecular(material, light, max(0.0f, dot(R, V)));
+	// cluster holds offset and count of its lights in the index list
+	uvec2 range = texelFetch(clusterSampler, (cluster.z * clusterCount.y + cluster.y) * clusterCount.x + cluster.x).rg;
+	vec3 color = vec3(0.0f);
 
-	float theta = dot(L, normalize(light.Position - light.Direction));
-	float epsilon = light.CutoffInn - light.CutoffOut;
-	float intensity = clamp((theta - light.CutoffOut) / epsilon, 0.0f, 1.0f);
+	for (uint i = 0u; i < range.y; ++i)
+		color += lightSource(material, int(texelFetch(indexSampler, int(range.x + i)).r), vPosition, vNormal);
 
-	return vec4(ambient * intensity + diffuse * intensity + specular * intensity, 1.0f);
+	return color;
 }
 
 void main()
@@ -113,8 +148,7 @@ void main()
 	vec4 color = vec4(material.Ambient * globalAmbientLight, 0.0f);
 
 	color += lightDirectional(material, sunlight, vertexPosition_v, vertexNormal_v);
-	color += lightPoint(material, pointlight, vertexPosition_v, vertexNormal_v);
-	color += lightSpot(material, spotlight, vertexPosition_v, vertexNormal_v);
+	color.rgb += lightClustered(material, vertexPosition_v, vertexNormal_v);
 
 	color_final = color * (texUse ? texture(texSampler, texCoord_v) : vec4(1.0f));
 }
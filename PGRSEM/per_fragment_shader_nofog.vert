@@ -1,9 +1,29 @@
 #version 140
 
-uniform mat4 pvmMatrix;
-uniform mat4 normalMatrix;
-uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
+struct Material
+{
+	vec3 Diffuse;
+	vec3 Ambient;
+	vec3 Specular;
+	float Shininess;
+};
+
+layout(std140) uniform ObjectData
+{
+	mat4 pvmMatrix;
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+	Material material;
+	bool texUse;
+};
+
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
 
 in vec3 vertexPosition;
 in vec3 vertexNormal;
@@ -2,13 +2,19 @@
 
 in vec3 position;
 
-uniform mat4 viewMatrix;
-uniform mat4 projectionMatrix; 
+layout(std140) uniform FrameData
+{
+	mat4 projectionMatrix;
+	mat4 viewMatrix;
+	mat4 pvMatrix;
+	vec3 cameraPosition;
+};
 
 out vec3 texCoord_v;
 
 void main()
 {
 	texCoord_v = position;
-	gl_Position = projectionMatrix * viewMatrix * vec4(position, 1.0f);
+	// translation is dropped, so the sky stays around the camera
+	gl_Position = projectionMatrix * mat4(mat3(viewMatrix)) * vec4(position, 1.0f);
 }  